@@ -32,6 +32,7 @@
 #include "OGLDCylinder.h"
 #include "OGLDAltAzView.h"
 #include "OGLDTexture.h"
+#include "OGLDBuildThread.h"
 #include "OGLDMath.h"
 #include <math.h>
 #include <iostream>
@@ -56,6 +57,12 @@ ogld::Texture* torusTex = NULL;
 ogld::Texture* cylTex = NULL;
 ogld::Texture* sphereTex = NULL;
 ogld::Texture* petroglyphs;
+
+// The image textures load in the background.
+static const int NUM_LOADS( 4 );
+static const unsigned int LOAD_POLL_MS( 50 );
+ogld::BuildJob* loadJobs[ NUM_LOADS ];
+int numLoadsDone( 0 );
 ogld::AltAzView eyeView;
 ogld::AltAzView lightView;
 ogld::View* view;
@@ -453,6 +460,31 @@ specialKey( int key, int x, int y )
     glutPostRedisplay();
 }
 
+// Redraws as each image finishes loading, so that it replaces its
+//   texture's placeholder.
+static void
+loadTimer( int value )
+{
+    int done( 0 );
+    int idx;
+    for (idx=0; idx<NUM_LOADS; idx++)
+    {
+        if (loadJobs[ idx ]->isDone())
+        {
+            assert( loadJobs[ idx ]->getResult() );
+            done++;
+        }
+    }
+
+    if (done != numLoadsDone)
+    {
+        numLoadsDone = done;
+        glutPostRedisplay();
+    }
+    if (done < NUM_LOADS)
+        glutTimerFunc( LOAD_POLL_MS, loadTimer, 0 );
+}
+
 static void
 mainMenuCB( int value )
 {
@@ -547,22 +579,19 @@ init()
     sphereTex = ogld::Texture::create();
     petroglyphs = ogld::Texture::create();
 
-    bool result;
     petroglyphs->setUnit( GL_TEXTURE0 );
-    result = petroglyphs->loadImage( std::string( "NewspaperRock.tif" ) );
-    assert( result );
+    loadJobs[ 0 ] = petroglyphs->loadImageAsync( std::string( "NewspaperRock.tif" ) );
 
     torusTex->setUnit( GL_TEXTURE0 );
-    result = torusTex->loadImage( std::string( "texture0.tif" ) );
-    assert( result );
+    loadJobs[ 1 ] = torusTex->loadImageAsync( std::string( "texture0.tif" ) );
 
     cylTex->setUnit( GL_TEXTURE0 );
-    result = cylTex->loadImage( std::string( "texture2.tif" ) );
-    assert( result );
+    loadJobs[ 2 ] = cylTex->loadImageAsync( std::string( "texture2.tif" ) );
 
     sphereTex->setUnit( GL_TEXTURE0 );
-    result = sphereTex->loadImage( std::string( "texture1.tif" ) );
-    assert( result );
+    loadJobs[ 3 ] = sphereTex->loadImageAsync( std::string( "texture1.tif" ) );
+
+    glutTimerFunc( LOAD_POLL_MS, loadTimer, 0 );
 
 
     // Create and initialize the depth map texture.
@@ -15,12 +15,14 @@
 #include "OGLDTorus.h"
 #include "OGLDCylinder.h"
 #include "OGLDSphere.h"
+#include "OGLDStaticBatch.h"
 #include "OGLDTrackballView.h"
 #include <stdlib.h>
 #include <assert.h>
 
 static const int SCENE_LIGHT_VALUE( 1 );
 static const int HEAD_LIGHT_VALUE( 2 );
+static const int BATCH_VALUE( 3 );
 static const int QUIT_VALUE( 99 );
 
 ogld::Torus* torus = NULL;
@@ -43,154 +45,115 @@ bool shift( false );
 int lightType;
 
 
-static void
-display()
+// The nine objects: shape, placement, and material.
+enum ObjectShape { TORUS, CYLINDER, SPHERE };
+struct Object
 {
-    glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
-
-    glLoadIdentity();
-
-    if (lightType == HEAD_LIGHT_VALUE)
-    {
-        GLfloat pos[4] = { 0.f, .5f, .5f, 1.f };
-        glLightfv( GL_LIGHT0, GL_POSITION, pos );
-    }
-
-    view.multMatrix();
-
-    if (lightType == SCENE_LIGHT_VALUE)
-        glLightfv( GL_LIGHT0, GL_POSITION, sceneLightPosition );
-
-
-
-    glPushMatrix();
-
-    glTranslatef( -6.f, -6.f, 0.f );
-
+    ObjectShape _shape;
+    float _x, _y;
+    // Rotation around the x axis, in degrees
+    float _rotate;
+    const GLfloat* _specular;
+    GLfloat _shininess;
+    GLfloat _color[ 3 ];
+};
+
+static const int NUM_OBJECTS( 9 );
+const Object objects[ NUM_OBJECTS ] = {
     // Soft dull red plastic
-    glMaterialfv( GL_FRONT, GL_SPECULAR, pink );
-    glMaterialf( GL_FRONT, GL_SHININESS, 15.f );
-    glColor3f( .9, 0., 0. );
-    torus->draw();
-
-    glPopMatrix();
-
-
-
-    glPushMatrix();
-
-    glTranslatef( 0.f, -6.f, 0.f );
-
+    { TORUS, -6.f, -6.f, 0.f, pink, 15.f, { .9f, 0.f, 0.f } },
     // Polished wood
-    glMaterialfv( GL_FRONT, GL_SPECULAR, white );
-    glMaterialf( GL_FRONT, GL_SHININESS, 128.f );
-    glColor3f( .75, .6, .1 );
-    torus->draw();
-
-    glPopMatrix();
-
-
-
-    glPushMatrix();
-
-    glTranslatef( 6.f, -6.f, 0.f );
-
+    { TORUS, 0.f, -6.f, 0.f, white, 128.f, { .75f, .6f, .1f } },
     // Tire rubber
-    glMaterialfv( GL_FRONT, GL_SPECULAR, dkGray );
-    glMaterialf( GL_FRONT, GL_SHININESS, 3.f );
-    glColor3f( .15, .15, .15 );
-    torus->draw();
-
-    glPopMatrix();
-
-
-
-    glPushMatrix();
-
-    glTranslatef( -6.f, 0.f, 0.f );
-    glRotatef( 75.f, 1.f, 0.f, 0.f );
-
+    { TORUS, 6.f, -6.f, 0.f, dkGray, 3.f, { .15f, .15f, .15f } },
     // Hard shiny blue plastic
-    glMaterialfv( GL_FRONT, GL_SPECULAR, white );
-    glMaterialf( GL_FRONT, GL_SHININESS, 20.f );
-    glColor3f( .1, .1, 1. );
-    cyl->draw();
-
-    glPopMatrix();
-
-
-
-    glPushMatrix();
-
-    glTranslatef( 0.f, 0.f, 0.f );
-    glRotatef( 75.f, 1.f, 0.f, 0.f );
-
+    { CYLINDER, -6.f, 0.f, 75.f, white, 20.f, { .1f, .1f, 1.f } },
     // Ebony
-    glMaterialfv( GL_FRONT, GL_SPECULAR, white );
-    glMaterialf( GL_FRONT, GL_SHININESS, 100.f );
-    glColor3f( 0., 0., 0. );
-    cyl->draw();
-
-    glPopMatrix();
-
-
-
-    glPushMatrix();
-
-    glTranslatef( 6.f, 0.f, 0.f );
-    glRotatef( 75.f, 1.f, 0.f, 0.f );
-
+    { CYLINDER, 0.f, 0.f, 75.f, white, 100.f, { 0.f, 0.f, 0.f } },
     // Brass
-    glMaterialfv( GL_FRONT, GL_SPECULAR, brass );
-    glMaterialf( GL_FRONT, GL_SHININESS, 5.f );
-    glColor3f( .3, .3, .3 );
-    cyl->draw();
-
-    glPopMatrix();
-
+    { CYLINDER, 6.f, 0.f, 75.f, brass, 5.f, { .3f, .3f, .3f } },
+    // Plaster
+    { SPHERE, -6.f, 6.f, 0.f, black, 5.f, { .7f, .7f, .7f } },
+    // China / glazed alabaster
+    { SPHERE, 0.f, 6.f, 0.f, white, 128.f, { .7f, .7f, .7f } },
+    // Lemon
+    { SPHERE, 6.f, 6.f, 0.f, dkYellow, 32.f, { .85f, .68f, .02f } }
+};
 
+// The same objects merged into one vertex and index array, drawn
+//   with one draw call per material.
+ogld::StaticBatch* batch = NULL;
+bool useBatch( true );
 
-    glPushMatrix();
 
-    glTranslatef( -6.f, 6.f, 0.f );
+static ogld::Shape*
+getShape( const Object& obj )
+{
+    switch (obj._shape)
+    {
+    case TORUS:
+        return torus;
+    case CYLINDER:
+        return cyl;
+    case SPHERE:
+    default:
+        return sphere;
+    }
+}
 
-    // Plaster
-    glMaterialfv( GL_FRONT, GL_SPECULAR, black );
-    glColor3f( .7, .7, .7 );
-    sphere->draw();
+static void
+transform( const Object& obj )
+{
+    glTranslatef( obj._x, obj._y, 0.f );
+    if (obj._rotate != 0.f)
+        glRotatef( obj._rotate, 1.f, 0.f, 0.f );
+}
 
-    glPopMatrix();
 
+static void
+display()
+{
+    glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
 
+    glLoadIdentity();
 
-    glPushMatrix();
+    if (lightType == HEAD_LIGHT_VALUE)
+    {
+        GLfloat pos[4] = { 0.f, .5f, .5f, 1.f };
+        glLightfv( GL_LIGHT0, GL_POSITION, pos );
+    }
 
-    glTranslatef( 0.f, 6.f, 0.f );
+    view.multMatrix();
 
-    // China / glazed alabaster
-    glMaterialfv( GL_FRONT, GL_SPECULAR, white );
-    glMaterialf( GL_FRONT, GL_SHININESS, 128.f );
-    glColor3f( .7, .7, .7 );
-    sphere->draw();
+    if (lightType == SCENE_LIGHT_VALUE)
+        glLightfv( GL_LIGHT0, GL_POSITION, sceneLightPosition );
 
-    glPopMatrix();
 
+    if (useBatch)
+        // One draw call per material, and no matrix changes.
+        batch->draw();
 
+    else
+    {
+        int idx;
+        for (idx=0; idx<NUM_OBJECTS; idx++)
+        {
+            const Object& obj = objects[ idx ];
 
-    glPushMatrix();
+            glPushMatrix();
 
-    glTranslatef( 6.f, 6.f, 0.f );
+            transform( obj );
 
-    // Lemon
-    glMaterialfv( GL_FRONT, GL_SPECULAR, dkYellow );
-    glMaterialf( GL_FRONT, GL_SHININESS, 32.f );
-    glColor3f( .85, .68, .02 );
-    sphere->draw();
+            glMaterialfv( GL_FRONT, GL_SPECULAR, obj._specular );
+            glMaterialf( GL_FRONT, GL_SHININESS, obj._shininess );
+            glColor3fv( obj._color );
+            getShape( obj )->draw();
 
-    glPopMatrix();
+            glPopMatrix();
+        }
+    }
 
 
-    
     glutSwapBuffers();
 }
 
@@ -272,6 +235,9 @@ mainMenuCB( int value )
     if ( (value == SCENE_LIGHT_VALUE) || (value == HEAD_LIGHT_VALUE) )
         lightType = value;
 
+    else if (value == BATCH_VALUE)
+        useBatch = !useBatch;
+
     else if (value == QUIT_VALUE)
 	{
 		if (torus)
@@ -280,9 +246,12 @@ mainMenuCB( int value )
 			delete cyl;
 		if (sphere)
 			delete sphere;
+		if (batch)
+			delete batch;
 		torus = NULL;
 		cyl = NULL;
 		sphere = NULL;
+		batch = NULL;
 
         exit( 0 );
 	}
@@ -301,6 +270,26 @@ init()
 
 	sphere = ogld::Sphere::create( 1.6f, 4 );
 
+    // Capture each object's modeling transformation for the batch.
+    batch = ogld::StaticBatch::create();
+    glMatrixMode( GL_MODELVIEW );
+    int idx;
+    for (idx=0; idx<NUM_OBJECTS; idx++)
+    {
+        const Object& obj = objects[ idx ];
+
+        glPushMatrix();
+        glLoadIdentity();
+        transform( obj );
+        GLfloat matrix[ 16 ];
+        glGetFloatv( GL_MODELVIEW_MATRIX, matrix );
+        glPopMatrix();
+
+        const GLfloat color[ 4 ] = { obj._color[0], obj._color[1], obj._color[2], 1.f };
+        batch->add( getShape( obj ), matrix,
+                ogld::StaticBatch::Material( color, obj._specular, obj._shininess ) );
+    }
+
     lightType = SCENE_LIGHT_VALUE;
 
 
@@ -325,6 +314,7 @@ init()
     glutCreateMenu( mainMenuCB );
     glutAddMenuEntry( "Scene light", SCENE_LIGHT_VALUE );
     glutAddMenuEntry( "Head light", HEAD_LIGHT_VALUE );
+    glutAddMenuEntry( "Toggle static batch", BATCH_VALUE );
     glutAddMenuEntry( "Quit", QUIT_VALUE );
     glutAttachMenu( GLUT_RIGHT_BUTTON );
 }
@@ -0,0 +1,78 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+// 
+
+
+#include "OGLDBound.h"
+#include <math.h>
+
+
+
+namespace ogld
+{
+
+
+Bound::Bound()
+  : _radius( -1.f )
+{
+    int idx;
+    for (idx=0; idx<3; idx++)
+    {
+        _min[ idx ] = 1.f;
+        _max[ idx ] = -1.f;
+        _center[ idx ] = 0.f;
+    }
+}
+
+
+void
+Bound::setBox( float minX, float minY, float minZ, float maxX, float maxY, float maxZ )
+{
+    _min[0] = minX;
+    _min[1] = minY;
+    _min[2] = minZ;
+    _max[0] = maxX;
+    _max[1] = maxY;
+    _max[2] = maxZ;
+}
+
+void
+Bound::setSphere( float x, float y, float z, float radius )
+{
+    _center[0] = x;
+    _center[1] = y;
+    _center[2] = z;
+    _radius = radius;
+}
+
+void
+Bound::setSphereFromBox()
+{
+    float sqLen = 0.f;
+    int idx;
+    for (idx=0; idx<3; idx++)
+    {
+        _center[ idx ] = (_min[ idx ] + _max[ idx ]) * .5f;
+        const float halfExtent = (_max[ idx ] - _min[ idx ]) * .5f;
+        sqLen += halfExtent * halfExtent;
+    }
+    _radius = (float) sqrt( sqLen );
+}
+
+
+bool
+Bound::isEmpty() const
+{
+    return( (_radius < 0.f) || (_min[0] > _max[0]) );
+}
+
+
+}
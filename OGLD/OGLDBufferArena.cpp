@@ -0,0 +1,370 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+// 
+
+#include "OGLDPlatformGL.h"
+#include "OGLDif.h"
+#include "OGLDBufferArena.h"
+#include <assert.h>
+
+
+
+namespace ogld
+{
+
+
+#ifdef GL_VERSION_1_5
+
+
+// Every block starts on a multiple of ALIGNMENT bytes, enough for
+//   any vertex or index type.
+static const GLsizeiptr ALIGNMENT( 16 );
+
+static GLsizeiptr
+alignSize( GLsizeiptr size )
+{
+    return( (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT );
+}
+
+
+BufferBlock::BufferBlock()
+  : _page( NULL ),
+    _offset( 0 ),
+    _size( 0 )
+{
+}
+
+BufferBlock::~BufferBlock()
+{
+}
+
+GLuint
+BufferBlock::getBuffer() const
+{
+    return _page->_buffer;
+}
+
+
+BufferPage::BufferPage( GLenum target, GLsizeiptr size )
+  : _target( target ),
+    _buffer( 0 ),
+    _size( size ),
+    _lost( false )
+{
+    glGenBuffers( 1, &_buffer );
+    glBindBuffer( _target, _buffer );
+    glBufferData( _target, _size, NULL, GL_STATIC_DRAW );
+
+    _free[ 0 ] = _size;
+}
+
+BufferPage::~BufferPage()
+{
+    assert( _blocks.empty() );
+    if (!_lost)
+        glDeleteBuffers( 1, &_buffer );
+}
+
+bool
+BufferPage::reserve( GLsizeiptr size, GLintptr& offset )
+{
+    FreeMap::iterator it;
+    for (it=_free.begin(); it!=_free.end(); it++)
+    {
+        if (it->second < size)
+            continue;
+
+        offset = it->first;
+        const GLsizeiptr remaining = it->second - size;
+        _free.erase( it );
+        if (remaining > 0)
+            _free[ offset + size ] = remaining;
+        return true;
+    }
+    return false;
+}
+
+void
+BufferPage::release( GLintptr offset, GLsizeiptr size )
+{
+    FreeMap::iterator next = _free.lower_bound( offset );
+    assert( (next == _free.end()) || (next->first >= offset + size) );
+
+    // Merge with the free range that follows, if adjacent.
+    if ( (next != _free.end()) && (next->first == offset + size) )
+    {
+        size += next->second;
+        _free.erase( next++ );
+    }
+
+    // Merge with the free range that precedes, if adjacent.
+    if (next != _free.begin())
+    {
+        FreeMap::iterator prev = next;
+        prev--;
+        if (prev->first + prev->second == offset)
+        {
+            prev->second += size;
+            return;
+        }
+    }
+
+    _free[ offset ] = size;
+}
+
+
+BufferArena* BufferArena::_instance = 0;
+
+BufferArena*
+BufferArena::instance()
+{
+    if (!_instance)
+        _instance = new BufferArena;
+
+    return _instance;
+}
+
+BufferArena::BufferArena()
+  : _pageSize( 4 * 1024 * 1024 )
+{
+}
+
+
+void
+BufferArena::setPageSize( GLsizeiptr size )
+{
+    _pageSize = alignSize( size );
+}
+
+GLsizeiptr
+BufferArena::getPageSize() const
+{
+    return _pageSize;
+}
+
+
+BufferBlock*
+BufferArena::allocate( GLenum target, GLsizeiptr size, const GLvoid* data )
+{
+    assert( size > 0 );
+    const GLsizeiptr alignedSize = alignSize( size );
+
+    PageList& pages = getPages( target );
+    BufferPage* page( NULL );
+    GLintptr offset( 0 );
+    PageList::const_iterator it;
+    for (it=pages.begin(); it!=pages.end(); it++)
+    {
+        if ((*it)->reserve( alignedSize, offset ))
+        {
+            page = *it;
+            break;
+        }
+    }
+    if (page == NULL)
+    {
+        page = addPage( target, alignedSize );
+        page->reserve( alignedSize, offset );
+    }
+
+    BufferBlock* block = new BufferBlock;
+    block->_page = page;
+    block->_offset = offset;
+    block->_size = alignedSize;
+    page->_blocks.insert( block );
+
+    glBindBuffer( target, page->_buffer );
+    glBufferSubData( target, offset, size, data );
+
+    OGLDIF_CHECK_ERROR;
+
+    return block;
+}
+
+void
+BufferArena::release( BufferBlock* block )
+{
+    if (block == NULL)
+        return;
+
+    BufferPage* page = block->_page;
+    page->release( block->_offset, block->_size );
+    page->_blocks.erase( block );
+    delete block;
+
+    if ( page->_lost && page->_blocks.empty() )
+        delete page;
+}
+
+void
+BufferArena::compact()
+{
+    const GLenum targets[ 2 ] = { GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER };
+    int tIdx;
+    for (tIdx=0; tIdx<2; tIdx++)
+    {
+        PageList& pages = getPages( targets[ tIdx ] );
+
+        // Last page first, move each block into the first earlier
+        //   page with room for it.
+        int pIdx;
+        for (pIdx=(int)pages.size()-1; pIdx>0; pIdx--)
+        {
+            // move() changes _blocks, so walk a copy.
+            const std::vector< BufferBlock* > blocks(
+                    pages[ pIdx ]->_blocks.begin(), pages[ pIdx ]->_blocks.end() );
+            std::vector< BufferBlock* >::const_iterator bIt;
+            for (bIt=blocks.begin(); bIt!=blocks.end(); bIt++)
+            {
+                int dest;
+                for (dest=0; dest<pIdx; dest++)
+                {
+                    GLintptr offset;
+                    if (pages[ dest ]->reserve( (*bIt)->_size, offset ))
+                    {
+                        move( *bIt, pages[ dest ], offset );
+                        break;
+                    }
+                }
+            }
+        }
+
+        PageList kept;
+        PageList::iterator it;
+        for (it=pages.begin(); it!=pages.end(); it++)
+        {
+            if ((*it)->_blocks.empty())
+                delete *it;
+            else
+                kept.push_back( *it );
+        }
+        pages.swap( kept );
+    }
+
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+
+    OGLDIF_CHECK_ERROR;
+}
+
+void
+BufferArena::contextLost()
+{
+    const GLenum targets[ 2 ] = { GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER };
+    int tIdx;
+    for (tIdx=0; tIdx<2; tIdx++)
+    {
+        PageList& pages = getPages( targets[ tIdx ] );
+        PageList::iterator it;
+        for (it=pages.begin(); it!=pages.end(); it++)
+        {
+            (*it)->_lost = true;
+            if ((*it)->_blocks.empty())
+                delete *it;
+        }
+        pages.clear();
+    }
+}
+
+
+int
+BufferArena::getNumPages( GLenum target ) const
+{
+    return (int) getPages( target ).size();
+}
+
+int
+BufferArena::getNumBlocks( GLenum target ) const
+{
+    int count( 0 );
+    const PageList& pages = getPages( target );
+    PageList::const_iterator it;
+    for (it=pages.begin(); it!=pages.end(); it++)
+        count += (int) (*it)->_blocks.size();
+    return count;
+}
+
+GLsizeiptr
+BufferArena::getUsedBytes( GLenum target ) const
+{
+    GLsizeiptr used( 0 );
+    const PageList& pages = getPages( target );
+    PageList::const_iterator it;
+    for (it=pages.begin(); it!=pages.end(); it++)
+    {
+        used += (*it)->_size;
+        BufferPage::FreeMap::const_iterator fIt;
+        for (fIt=(*it)->_free.begin(); fIt!=(*it)->_free.end(); fIt++)
+            used -= fIt->second;
+    }
+    return used;
+}
+
+GLsizeiptr
+BufferArena::getPageBytes( GLenum target ) const
+{
+    GLsizeiptr total( 0 );
+    const PageList& pages = getPages( target );
+    PageList::const_iterator it;
+    for (it=pages.begin(); it!=pages.end(); it++)
+        total += (*it)->_size;
+    return total;
+}
+
+
+BufferArena::PageList&
+BufferArena::getPages( GLenum target )
+{
+    assert( (target == GL_ARRAY_BUFFER) || (target == GL_ELEMENT_ARRAY_BUFFER) );
+    return( (target == GL_ELEMENT_ARRAY_BUFFER) ? _indexPages : _vertexPages );
+}
+
+const BufferArena::PageList&
+BufferArena::getPages( GLenum target ) const
+{
+    assert( (target == GL_ARRAY_BUFFER) || (target == GL_ELEMENT_ARRAY_BUFFER) );
+    return( (target == GL_ELEMENT_ARRAY_BUFFER) ? _indexPages : _vertexPages );
+}
+
+BufferPage*
+BufferArena::addPage( GLenum target, GLsizeiptr size )
+{
+    BufferPage* page = new BufferPage( target, (size > _pageSize) ? size : _pageSize );
+    getPages( target ).push_back( page );
+    return page;
+}
+
+void
+BufferArena::move( BufferBlock* block, BufferPage* page, GLintptr offset )
+{
+    BufferPage* src = block->_page;
+    const GLenum target = src->_target;
+
+    GLubyte* data = new GLubyte[ block->_size ];
+    glBindBuffer( target, src->_buffer );
+    glGetBufferSubData( target, block->_offset, block->_size, data );
+    glBindBuffer( target, page->_buffer );
+    glBufferSubData( target, offset, block->_size, data );
+    delete[] data;
+
+    src->release( block->_offset, block->_size );
+    src->_blocks.erase( block );
+
+    block->_page = page;
+    block->_offset = offset;
+    page->_blocks.insert( block );
+}
+
+
+#endif
+
+
+}
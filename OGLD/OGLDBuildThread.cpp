@@ -0,0 +1,221 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+// 
+
+
+#include "OGLDBuildThread.h"
+#include "OGLDShape.h"
+#include <algorithm>
+#include <assert.h>
+
+
+
+namespace ogld
+{
+
+
+BuildJob::BuildJob( Shape* shape )
+  : _shape( shape ),
+    _state( Pending ),
+    _result( false )
+{
+}
+
+BuildJob::~BuildJob()
+{
+}
+
+bool
+BuildJob::execute()
+{
+    return _shape->buildCachedGeometry();
+}
+
+bool
+BuildJob::isDone() const
+{
+    ScopedLock lock( BuildThread::instance()->_mutex );
+    return( _state == Done );
+}
+
+void
+BuildJob::wait()
+{
+    // The worker signals _done in the same critical section that sets
+    //   Done, so a signal sent between isDone() and _done.wait() is
+    //   remembered rather than lost.
+    while (!isDone())
+        _done.wait();
+}
+
+bool
+BuildJob::getResult() const
+{
+    ScopedLock lock( BuildThread::instance()->_mutex );
+    return _result;
+}
+
+
+
+// One of the BuildThread's workers.
+class BuildWorker : public Thread
+{
+protected:
+    virtual void run() { BuildThread::instance()->run(); }
+};
+
+
+
+BuildThread* BuildThread::_instance( NULL );
+
+BuildThread*
+BuildThread::instance()
+{
+    if (!_instance)
+        _instance = new BuildThread;
+
+    return _instance;
+}
+
+
+BuildThread::BuildThread()
+  : _numThreads( getNumProcessors() ),
+    _running( false )
+{
+}
+
+BuildThread::~BuildThread()
+{
+}
+
+
+void
+BuildThread::setNumThreads( int numThreads )
+{
+    ScopedLock lock( _mutex );
+    assert( !_running );
+    _numThreads = (numThreads > 1) ? numThreads : 1;
+}
+
+int
+BuildThread::getNumThreads() const
+{
+    return _numThreads;
+}
+
+
+void
+BuildThread::submit( BuildJob* job )
+{
+    bool running;
+    {
+        ScopedLock lock( _mutex );
+        assert( job->_state == BuildJob::Pending );
+
+        if (!_running)
+        {
+            int idx;
+            for (idx=0; idx<_numThreads; idx++)
+            {
+                Thread* worker = new BuildWorker;
+                if (!worker->start())
+                {
+                    delete worker;
+                    break;
+                }
+                _workers.push_back( worker );
+            }
+            _running = !_workers.empty();
+        }
+        running = _running;
+
+        if (running)
+            _queue.push_back( job );
+        else
+            job->_state = BuildJob::Running;
+    }
+
+    if (running)
+    {
+        _work.signal();
+        return;
+    }
+
+    // No thread support; build now.
+    const bool result = job->execute();
+    ScopedLock lock( _mutex );
+    job->_result = result;
+    job->_state = BuildJob::Done;
+}
+
+void
+BuildThread::cancel( BuildJob* job )
+{
+    {
+        ScopedLock lock( _mutex );
+        if (job->_state == BuildJob::Pending)
+        {
+            std::deque< BuildJob* >::iterator it =
+                std::find( _queue.begin(), _queue.end(), job );
+            if (it != _queue.end())
+                _queue.erase( it );
+            job->_state = BuildJob::Done;
+            job->_result = false;
+            return;
+        }
+    }
+
+    job->wait();
+}
+
+
+void
+BuildThread::run()
+{
+    for (;;)
+    {
+        BuildJob* job( NULL );
+        bool more( false );
+        while (job == NULL)
+        {
+            {
+                ScopedLock lock( _mutex );
+                if (!_queue.empty())
+                {
+                    job = _queue.front();
+                    _queue.pop_front();
+                    job->_state = BuildJob::Running;
+                    more = !_queue.empty();
+                }
+            }
+            if (job == NULL)
+                _work.wait();
+        }
+
+        // Signals don't accumulate, so several submit()s may have
+        //   woken only this worker. Pass the wake-up on.
+        if (more)
+            _work.signal();
+
+        const bool result = job->execute();
+
+        // Signal while holding the lock. Once wait() or isDone() sees
+        //   Done, the job's owner may delete it, so the worker mustn't
+        //   touch it after releasing the lock.
+        ScopedLock lock( _mutex );
+        job->_result = result;
+        job->_state = BuildJob::Done;
+        job->_done.signal();
+    }
+}
+
+
+}
@@ -0,0 +1,377 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+// 
+
+
+#include "OGLDPlatformGL.h"
+#include "OGLDif.h"
+#include "OGLDMath.h"
+#include "OGLDCompactVertices.h"
+#include <math.h>
+#include <string.h>
+#include <assert.h>
+
+
+
+namespace ogld
+{
+
+
+// Largest magnitude written to a quantized GLshort or GLbyte.
+static const float SHORT_MAX( 32767.f );
+static const float BYTE_MAX( 127.f );
+
+
+static int
+roundToInt( double v )
+{
+    return( (int) floor( v + .5 ) );
+}
+
+// Computes a bias (the center of the value range) and a scale so that
+//   (value - bias) / scale lies within [-SHORT_MAX, SHORT_MAX].
+static void
+computeRange( const GLfloat* data, int components, int numVerts, int comp,
+        GLfloat& bias, GLfloat& halfExtent )
+{
+    GLfloat minVal = data[ comp ];
+    GLfloat maxVal = data[ comp ];
+    int idx;
+    for (idx=1; idx<numVerts; idx++)
+    {
+        const GLfloat v = data[ idx*components + comp ];
+        if (v < minVal)
+            minVal = v;
+        if (v > maxVal)
+            maxVal = v;
+    }
+    bias = (minVal + maxVal) * .5f;
+    halfExtent = (maxVal - minVal) * .5f;
+}
+
+
+// True if each vertex is its normal times one positive 'scale', to
+//   within half a step of normals quantized to GLshorts.
+static bool
+isNormalMultiple( const GLfloat* vertices, const GLfloat* normals, int numVerts,
+        GLfloat& scale )
+{
+    const GLfloat* n = normals;
+    const double nn = n[0]*n[0] + n[1]*n[1] + n[2]*n[2];
+    if (nn <= 0.)
+        return false;
+    const double s = (vertices[0]*n[0] + vertices[1]*n[1] + vertices[2]*n[2]) / nn;
+    if (s <= 0.)
+        return false;
+
+    const double tolerance = .5 * s / SHORT_MAX;
+    int idx;
+    for (idx=0; idx<numVerts*3; idx++)
+    {
+        if (fabs( vertices[ idx ] - s * normals[ idx ] ) > tolerance)
+            return false;
+    }
+    scale = (GLfloat) s;
+    return true;
+}
+
+
+CompactVertices::CompactVertices()
+  : _data( NULL ),
+    _numVerts( 0 ),
+    _stride( 0 ),
+    _normalType( GL_BYTE ),
+    _normalOffset( 0 ),
+    _texCoordOffset( 0 ),
+    _texComponents( 0 ),
+    _posScale( 1.f ),
+    _positionError( 0.f ),
+    _normalError( 0.f ),
+    _texCoordError( 0.f )
+{
+    int idx;
+    for (idx=0; idx<3; idx++)
+    {
+        _posBias[ idx ] = 0.f;
+        _texBias[ idx ] = 0.f;
+        _texScale[ idx ] = 1.f;
+    }
+}
+
+CompactVertices::~CompactVertices()
+{
+    releaseData();
+}
+
+
+bool
+CompactVertices::build( int numVerts, const GLfloat* vertices, const GLfloat* normals,
+        const GLfloat* texCoords, int texComponents )
+{
+    assert( (numVerts > 0) && vertices && normals );
+    assert( (texComponents >= 0) && (texComponents <= 3) );
+
+    releaseData();
+    _numVerts = numVerts;
+    _positionError = _normalError = _texCoordError = 0.f;
+
+    const bool aliasTexCoords = (texCoords == normals);
+    if (texCoords == NULL)
+        texComponents = 0;
+
+    // Aliased normals are GLshorts, precise enough to serve as the
+    //   positions too if every vertex is its normal times one positive
+    //   scale, as on a Sphere.
+    GLfloat normalScale = 0.f;
+    const bool aliasPositions = aliasTexCoords &&
+            isNormalMultiple( vertices, normals, _numVerts, normalScale );
+
+    // Layout, with every GLshort two-byte aligned and no other padding:
+    //   3 GLshorts of position, then texComponents GLshorts of texture
+    //   coordinates, then 3 GLbytes of normal. Aliased normals are 3
+    //   GLshorts in place of the texture coordinates, and aliased
+    //   positions share them as well.
+    _normalType = aliasTexCoords ? GL_SHORT : GL_BYTE;
+    if (aliasTexCoords)
+    {
+        _texComponents = 3;
+        _texCoordOffset = _normalOffset = aliasPositions ? 0 : 3 * sizeof( GLshort );
+        _stride = _normalOffset + 3 * sizeof( GLshort );
+    }
+    else
+    {
+        _texComponents = texComponents;
+        _texCoordOffset = 3 * sizeof( GLshort );
+        _normalOffset = _texCoordOffset + _texComponents * sizeof( GLshort );
+        _stride = (_normalOffset + 3 * sizeof( GLbyte ) + 1) & ~1;
+    }
+
+    _data = new GLubyte[ _numVerts * _stride ];
+    memset( _data, 0, _numVerts * _stride );
+
+
+    //
+    // Positions: one scale for all three axes keeps the quantized
+    //   model-view transform a similarity transform.
+    int comp;
+    if (aliasPositions)
+    {
+        for (comp=0; comp<3; comp++)
+            _posBias[ comp ] = 0.f;
+        _posScale = normalScale / SHORT_MAX;
+    }
+    else
+    {
+        GLfloat maxHalfExtent = 0.f;
+        for (comp=0; comp<3; comp++)
+        {
+            GLfloat halfExtent;
+            computeRange( vertices, 3, _numVerts, comp, _posBias[ comp ], halfExtent );
+            if (halfExtent > maxHalfExtent)
+                maxHalfExtent = halfExtent;
+        }
+        _posScale = (maxHalfExtent > 0.f) ? (maxHalfExtent / SHORT_MAX) : 1.f;
+    }
+
+
+    //
+    // Texture coordinates: independent scale and bias per component.
+    if (aliasTexCoords)
+    {
+        for (comp=0; comp<3; comp++)
+        {
+            _texBias[ comp ] = 0.f;
+            _texScale[ comp ] = 1.f / SHORT_MAX;
+        }
+    }
+    else
+    {
+        for (comp=0; comp<3; comp++)
+        {
+            _texBias[ comp ] = 0.f;
+            _texScale[ comp ] = 1.f;
+        }
+        for (comp=0; comp<_texComponents; comp++)
+        {
+            GLfloat halfExtent;
+            computeRange( texCoords, _texComponents, _numVerts, comp, _texBias[ comp ], halfExtent );
+            if (halfExtent > 0.f)
+                _texScale[ comp ] = halfExtent / SHORT_MAX;
+        }
+    }
+
+
+    double posError = 0., normalCos = 1., texError = 0.;
+    int idx;
+    for (idx=0; idx<_numVerts; idx++)
+    {
+        GLubyte* vertex = _data + idx * _stride;
+
+        const GLfloat* srcNorm = normals + idx*3;
+        double quant[ 3 ];
+        if (aliasTexCoords)
+        {
+            GLshort* norm = (GLshort*)( vertex + _normalOffset );
+            for (comp=0; comp<3; comp++)
+            {
+                norm[ comp ] = (GLshort) roundToInt( srcNorm[ comp ] * SHORT_MAX );
+                quant[ comp ] = norm[ comp ];
+
+                const double d = fabs( norm[ comp ] / SHORT_MAX - srcNorm[ comp ] );
+                if (d > texError)
+                    texError = d;
+            }
+        }
+        else
+        {
+            GLbyte* norm = (GLbyte*)( vertex + _normalOffset );
+            for (comp=0; comp<3; comp++)
+            {
+                norm[ comp ] = (GLbyte) roundToInt( srcNorm[ comp ] * BYTE_MAX );
+                quant[ comp ] = norm[ comp ];
+            }
+        }
+        const double quantLen = sqrt( quant[0]*quant[0] + quant[1]*quant[1] + quant[2]*quant[2] );
+        const double srcLen = sqrt( srcNorm[0]*srcNorm[0] + srcNorm[1]*srcNorm[1] + srcNorm[2]*srcNorm[2] );
+        if ((quantLen > 0.) && (srcLen > 0.))
+        {
+            const double cosAngle = (quant[0]*srcNorm[0] + quant[1]*srcNorm[1] +
+                    quant[2]*srcNorm[2]) / (quantLen * srcLen);
+            if (cosAngle < normalCos)
+                normalCos = cosAngle;
+        }
+
+        // Aliased positions were written with the normals.
+        GLshort* pos = (GLshort*) vertex;
+        const GLfloat* srcPos = vertices + idx*3;
+        double dist2 = 0.;
+        for (comp=0; comp<3; comp++)
+        {
+            if (!aliasPositions)
+                pos[ comp ] = (GLshort) roundToInt( (srcPos[ comp ] - _posBias[ comp ]) / _posScale );
+            const double d = pos[ comp ] * _posScale + _posBias[ comp ] - srcPos[ comp ];
+            dist2 += d * d;
+        }
+        if (dist2 > posError * posError)
+            posError = sqrt( dist2 );
+
+        if (!aliasTexCoords && (_texComponents > 0))
+        {
+            GLshort* tex = (GLshort*)( vertex + _texCoordOffset );
+            const GLfloat* srcTex = texCoords + idx*_texComponents;
+            for (comp=0; comp<_texComponents; comp++)
+            {
+                tex[ comp ] = (GLshort) roundToInt( (srcTex[ comp ] - _texBias[ comp ]) / _texScale[ comp ] );
+                const double d = fabs( tex[ comp ] * _texScale[ comp ] + _texBias[ comp ] - srcTex[ comp ] );
+                if (d > texError)
+                    texError = d;
+            }
+        }
+    }
+
+    if (normalCos > 1.)
+        normalCos = 1.;
+    _positionError = (float) posError;
+    _normalError = (float) radiansToDegrees( acos( normalCos ) );
+    _texCoordError = (float) texError;
+
+    return true;
+}
+
+void
+CompactVertices::releaseData()
+{
+    if (_data)
+        delete[] _data;
+    _data = NULL;
+}
+
+
+void
+CompactVertices::setPointers( const GLubyte* base, int numTextures ) const
+{
+    glEnableClientState( GL_VERTEX_ARRAY );
+    glVertexPointer( 3, GL_SHORT, _stride, base );
+
+    glEnableClientState( GL_NORMAL_ARRAY );
+    glNormalPointer( _normalType, _stride, base + _normalOffset );
+
+    if (_texComponents == 0)
+        return;
+
+    int tIdx;
+    for (tIdx=0; tIdx<numTextures; tIdx++)
+    {
+        glClientActiveTexture( GL_TEXTURE0 + tIdx );
+        glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+        glTexCoordPointer( _texComponents, GL_SHORT, _stride, base + _texCoordOffset );
+    }
+}
+
+void
+CompactVertices::pushTransform( int numTextures ) const
+{
+    glPushAttrib( GL_TRANSFORM_BIT );
+    glEnable( GL_NORMALIZE );
+
+    glMatrixMode( GL_MODELVIEW );
+    glPushMatrix();
+    glTranslatef( _posBias[0], _posBias[1], _posBias[2] );
+    glScalef( _posScale, _posScale, _posScale );
+
+    if (numTextures > 0)
+    {
+        glMatrixMode( GL_TEXTURE );
+        int tIdx;
+        for (tIdx=0; tIdx<numTextures; tIdx++)
+        {
+            glActiveTexture( GL_TEXTURE0 + tIdx );
+            glPushMatrix();
+            glTranslatef( _texBias[0], _texBias[1], _texBias[2] );
+            glScalef( _texScale[0], _texScale[1], _texScale[2] );
+        }
+        glActiveTexture( GL_TEXTURE0 );
+    }
+}
+
+void
+CompactVertices::popTransform( int numTextures ) const
+{
+    if (numTextures > 0)
+    {
+        glMatrixMode( GL_TEXTURE );
+        int tIdx;
+        for (tIdx=0; tIdx<numTextures; tIdx++)
+        {
+            glActiveTexture( GL_TEXTURE0 + tIdx );
+            glPopMatrix();
+        }
+        glActiveTexture( GL_TEXTURE0 );
+    }
+
+    glMatrixMode( GL_MODELVIEW );
+    glPopMatrix();
+
+    // Restores GL_NORMALIZE and the matrix mode.
+    glPopAttrib();
+}
+
+
+void
+CompactVertices::getErrors( float& position, float& normal, float& texCoord ) const
+{
+    position = _positionError;
+    normal = _normalError;
+    texCoord = _texCoordError;
+}
+
+
+}
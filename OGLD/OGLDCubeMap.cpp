@@ -11,7 +11,6 @@
 // 
 
 #include "OGLDPlatformGL.h"
-#include "OGLDPlatformGLU.h"
 #include "OGLDif.h"
 #include "OGLDPixels.h"
 #include "OGLDCubeMap.h"
@@ -69,7 +68,9 @@ CubeMap::create()
 CubeMap::CubeMap()
   : _texId( 0 ),
     _textureObjectAllocated( false ),
-    _mode( GL_MODULATE )
+    _mode( GL_MODULATE ),
+    _mipmapFilter( BoxFilter ),
+    _power2Rounding( RoundUpPower2 )
 {
     assert( OGLDif::instance()->getVersion() >= Ver11 );
 
@@ -199,6 +200,30 @@ CubeMap::getObject() const
     return _texId;
 }
 
+void
+CubeMap::setMipmapFilter( MipmapFilter filter )
+{
+    _mipmapFilter = filter;
+}
+
+MipmapFilter
+CubeMap::getMipmapFilter() const
+{
+    return _mipmapFilter;
+}
+
+void
+CubeMap::setPower2Rounding( Power2Rounding rounding )
+{
+    _power2Rounding = rounding;
+}
+
+Power2Rounding
+CubeMap::getPower2Rounding() const
+{
+    return _power2Rounding;
+}
+
 
 bool
 CubeMap::init()
@@ -217,6 +242,18 @@ CubeMap::initTextureObject()
 {
 }
 
+void
+CubeMap::resampleToPower2( Pixels* pixels ) const
+{
+    if (OGLDif::instance()->isTextureNPOTSupported())
+        return;
+
+    GLsizei width, height;
+    pixels->getWidthHeight( width, height );
+    roundToPower2( width, height, _power2Rounding );
+    pixels->resample( width, height );
+}
+
 
 
 
@@ -363,32 +400,15 @@ CubeMap13::initTextureObject()
     {
         GLenum target = GL_TEXTURE_CUBE_MAP_POSITIVE_X + i;
 
+        resampleToPower2( _pixels[i] );
+
         GLsizei width, height;
         _pixels[i]->getWidthHeight( width, height );
         GLenum format = _pixels[i]->getFormat();
         GLenum type = _pixels[i]->getType();
 
-        // Non-power-of-2 texture dimensions not supported. Resample if necessary.
-        bool wNPOT = ( (width & (width-1)) != 0);
-        bool hNPOT = ( (height & (height-1)) != 0);
-        if (wNPOT || hNPOT)
-        {
-            GLsizei oldW = width;
-            GLsizei oldH = height;
-            width = ceilPower2( width );
-            height = ceilPower2( height );
-            int sizeBytes = _pixels[i]->size();
-            unsigned char* newData = new unsigned char[ sizeBytes ];
-
-            gluScaleImage( format, oldW, oldH, type, _pixels[i]->getPixels(),
-                width, height, type, (GLvoid*) newData );
-
-            _pixels[i]->loadDirect( width, height, newData );
-            delete[] newData;
-        }
-
-        gluBuild2DMipmaps( target, format, width, height,
-                format, type, _pixels[i]->getPixels() );
+        buildMipmaps( target, format, width, height,
+                format, type, _pixels[i]->getPixels(), _mipmapFilter );
     }
 
     OGLDIF_CHECK_ERROR;
@@ -432,33 +452,15 @@ CubeMap14::initTextureObject()
     {
         GLenum target = GL_TEXTURE_CUBE_MAP_POSITIVE_X + i;
 
+        resampleToPower2( _pixels[i] );
+
         GLsizei width, height;
         _pixels[i]->getWidthHeight( width, height );
         GLenum format = _pixels[i]->getFormat();
         GLenum type = _pixels[i]->getType();
 
-        // Non-power-of-2 texture dimensions not supported. Resample if necessary.
-        bool wNPOT = ( (width & (width-1)) != 0);
-        bool hNPOT = ( (height & (height-1)) != 0);
-        if (wNPOT || hNPOT)
-        {
-            GLsizei oldW = width;
-            GLsizei oldH = height;
-            width = ceilPower2( width );
-            height = ceilPower2( height );
-            int sizeBytes = _pixels[i]->size();
-            unsigned char* newData = new unsigned char[ sizeBytes ];
-
-            gluScaleImage( format, oldW, oldH, type, _pixels[i]->getPixels(),
-                width, height, type, (GLvoid*) newData );
-
-            _pixels[i]->loadDirect( width, height, newData );
-            delete[] newData;
-        }
-
-        glTexParameteri( GL_TEXTURE_CUBE_MAP, GL_GENERATE_MIPMAP, GL_TRUE );
-        glTexImage2D( target, 0, format, width, height,
-                0, format, type, _pixels[i]->getPixels() );
+        buildMipmaps( target, format, width, height,
+                format, type, _pixels[i]->getPixels(), _mipmapFilter );
     }
 
     OGLDIF_CHECK_ERROR;
@@ -506,9 +508,8 @@ CubeMap20::initTextureObject()
         GLenum format = _pixels[i]->getFormat();
         GLenum type = _pixels[i]->getType();
 
-        glTexParameteri( GL_TEXTURE_CUBE_MAP, GL_GENERATE_MIPMAP, GL_TRUE );
-        glTexImage2D( target, 0, format, width, height,
-                0, format, type, _pixels[i]->getPixels() );
+        buildMipmaps( target, format, width, height,
+                format, type, _pixels[i]->getPixels(), _mipmapFilter );
     }
 
     OGLDIF_CHECK_ERROR;
@@ -14,8 +14,13 @@
 #include "OGLDCylinder.h"
 #include "OGLDif.h"
 #include "OGLDMath.h"
+#include "OGLDVertexCache.h"
+#include "OGLDMeshCache.h"
+#include "OGLDInstanceBuffer.h"
+#include "OGLDShapeTuner.h"
 #include <math.h>
 #include <assert.h>
+#include <stdio.h>
 
 
 
@@ -25,35 +30,37 @@ namespace ogld
 
 // Static factory creation methods
 Cylinder*
-Cylinder::create( float radius, float length, int slices )
+Cylinder::create( float radius, float length, int slices, VertexFormat format )
 {
-    switch (OGLDif::instance()->getVersion())
+    Cylinder* cylinder( NULL );
+
+    switch (ShapeTuner::instance()->getShapeVersion())
     {
 
     case VerExtended:
     case Ver20:
     case Ver15:
 #ifdef GL_VERSION_1_5
-        return new Cylinder15( radius, length, slices );
+        cylinder = new Cylinder15( radius, length, slices );
         break;
 #endif
 
     case Ver14:
     case Ver13:
 #ifdef GL_VERSION_1_3
-        return new Cylinder13( radius, length, slices );
+        cylinder = new Cylinder13( radius, length, slices );
         break;
 #endif
 
     case Ver12:
 #ifdef GL_VERSION_1_2
-        return new Cylinder12( radius, length, slices );
+        cylinder = new Cylinder12( radius, length, slices );
         break;
 #endif
 
     case Ver11:
 #ifdef GL_VERSION_1_1
-        return new Cylinder( radius, length, slices );
+        cylinder = new Cylinder( radius, length, slices );
         break;
 #endif
 
@@ -64,6 +71,9 @@ Cylinder::create( float radius, float length, int slices )
         return NULL;
         break;
     }
+
+    cylinder->_vertexFormat = format;
+    return cylinder;
 }
 
 Cylinder::Cylinder( float radius, float length, int slices )
@@ -75,43 +85,37 @@ Cylinder::Cylinder( float radius, float length, int slices )
     _vertices( NULL ),
     _normals( NULL ),
     _texCoords( NULL ),
-    _indices( NULL ),
-    _cap1Start( NULL ),
-    _cap2Start( NULL ),
     _idxStart( 0 ),
-    _cap1Idx( 0 ),
-    _cap2Idx( 0 ),
     _idxEnd( 0 ),
     _valid( false ),
     _numVerts( 0 ),
     _numCapVerts( 0 ),
+    _numIndices( 0 ),
     _dListAllocated( false )
 {
     assert( OGLDif::instance()->getVersion() >= Ver11 );
+
+    const float r = (float) fabs( _radius );
+    const float halfLength = (float) fabs( _length ) * .5f;
+    _bound.setBox( -r, -r, -halfLength, r, r, halfLength );
+    _bound.setSphere( 0.f, 0.f, 0.f, (float) sqrt( r*r + halfLength*halfLength ) );
 }
 
 Cylinder::~Cylinder()
 {
-    if ( _valid )
-    {
-        if (_dListAllocated)
-        {
-            glDeleteLists( _dList, 1 );
-            _dListAllocated = false;
-        }
+    cancelBuild();
 
-        if (_texCoords)
-            delete[] _texCoords;
-        if (_vertices)
-            delete[] _vertices;
-        if (_normals)
-            delete[] _normals;
-        if (_indices)
-            delete[] _indices;
-        _texCoords = _vertices = _normals = NULL;
-        _indices = NULL;
-        _valid = false;
+    if (_dListAllocated)
+    {
+        glDeleteLists( _dList, 1 );
+        _dListAllocated = false;
     }
+
+    freeHostArray( _texCoords );
+    freeHostArray( _vertices );
+    freeHostArray( _normals );
+    _indices.clear();
+    _valid = false;
 }
 
 void
@@ -124,26 +128,188 @@ Cylinder::cap( bool posZ, bool negZ )
 void
 Cylinder::draw()
 {
+    if (drawLOD())
+        return;
+
     if (!_valid)
     {
         if (!init())
             return;
     }
 
+    if (_master)
+    {
+        _master->draw();
+        return;
+    }
+
     glCallList( _dList );
 
     OGLDIF_CHECK_ERROR;
 }
 
+bool
+Cylinder::getShareKey( std::string& key ) const
+{
+    char buf[ 128 ];
+    sprintf( buf, "Cylinder %.9g %.9g %d %d %d %d %d", _radius, _length, _slices,
+            (int) _drawCap1, (int) _drawCap2, _numTextures, (int) _vertexFormat );
+    key = buf;
+    return true;
+}
+
+Shape*
+Cylinder::createMaster() const
+{
+    Cylinder* master = Cylinder::create( _radius, _length, _slices, _vertexFormat );
+    master->setShared( false );
+    master->setTextures( _numTextures );
+    master->cap( _drawCap1, _drawCap2 );
+    return master;
+}
+
+bool
+Cylinder::saveGeometry( MeshCacheWriter& writer ) const
+{
+    const int counts[ 5 ] = { _numVerts, _numCapVerts, _numIndices, (int) _idxStart, (int) _idxEnd };
+    writer.addInts( counts, 5 );
+    const int totalVerts = _numVerts + (_numCapVerts * 2);
+    writer.addFloats( _vertices, totalVerts * 3 );
+    writer.addFloats( _normals, totalVerts * 3 );
+    writer.addFloats( _texCoords, totalVerts * 2 );
+    writer.addIndices( _indices );
+    return true;
+}
+
+bool
+Cylinder::loadGeometry( MeshCacheEntry& entry )
+{
+    int counts[ 5 ];
+    if ( !entry.getInts( counts, 5 ) || (counts[0] < 0) || (counts[1] < 0) )
+        return false;
+    const int totalVerts = counts[0] + (counts[1] * 2);
+    const GLfloat* vertices = entry.getFloats( totalVerts * 3 );
+    const GLfloat* normals = vertices ? entry.getFloats( totalVerts * 3 ) : NULL;
+    const GLfloat* texCoords = normals ? entry.getFloats( totalVerts * 2 ) : NULL;
+    if ( (texCoords == NULL) || !entry.getIndices( _indices ) )
+        return false;
+    if (_indices.getCount() != counts[2])
+    {
+        _indices.clear();
+        return false;
+    }
+
+    _numVerts = counts[0];
+    _numCapVerts = counts[1];
+    _numIndices = counts[2];
+    _idxStart = counts[3];
+    _idxEnd = counts[4];
+    _vertices = (GLfloat*) vertices;
+    _normals = (GLfloat*) normals;
+    _texCoords = (GLfloat*) texCoords;
+    return true;
+}
+
+bool
+Cylinder::getTriangles( int& numVerts, const float*& vertices, const float*& normals,
+        const float*& texCoords, int& texCoordSize, const IndexArray*& indices ) const
+{
+    numVerts = _numVerts + (_numCapVerts * 2);
+    vertices = _vertices;
+    normals = _normals;
+    texCoords = _texCoords;
+    texCoordSize = 2;
+    indices = &_indices;
+    return( _vertices != NULL );
+}
+
+// Slices for LOD 'level': halved once per level, with a minimum of 3.
+static int
+lodSlices( int slices, int level )
+{
+    const int lod = slices >> level;
+    return( (lod < 3) ? 3 : lod );
+}
+
+float
+Cylinder::getLODError( int level ) const
+{
+    if (level < 0)
+        return -1.f;
+
+    const int slices = lodSlices( _slices, level );
+    if ( (level > 0) && (slices == lodSlices( _slices, level-1 )) )
+        // No coarser than the previous level.
+        return -1.f;
+
+    // Sagitta of the chords around the circumference.
+    return( (float)( _radius * (1. - cos( _PI / slices )) ) );
+}
+
+Shape*
+Cylinder::createLOD( int level ) const
+{
+    if (getLODError( level ) < 0.f)
+        return NULL;
+
+    Cylinder* lod = Cylinder::create( _radius, _length, lodSlices( _slices, level ), _vertexFormat );
+    lod->setShared( _shared );
+    lod->setTextures( _numTextures );
+    lod->cap( _drawCap1, _drawCap2 );
+    return lod;
+}
+
+void
+Cylinder::contextLost()
+{
+    Shape::contextLost();
+    if (_master)
+        return;
+
+    // The display list or buffer objects went with the context.
+    _dListAllocated = false;
+    _valid = false;
+}
+
+bool
+Cylinder::freeHostData()
+{
+    freeHostArray( _vertices );
+    freeHostArray( _normals );
+    freeHostArray( _texCoords );
+    _indices.releaseData();
+    return true;
+}
+
 bool
 Cylinder::init()
 {
-    if (!buildData())
+    if (acquireMaster())
+        return( _valid = true );
+
+    // Tessellate now, unless buildAsync() already started it.
+    if (!finishBuild())
         return false;
 
     if (!storeData())
         return false;
 
+    releaseHostData();
+    return true;
+}
+
+bool
+Cylinder::buildGeometry()
+{
+    if (!buildData())
+        return false;
+
+    const int totalVerts = _numVerts + (_numCapVerts * 2);
+    optimizeTriangleList( _indices.getUIntData(), _numIndices, totalVerts,
+            _vertices, _normals, _texCoords, 2 );
+
+    _indices.pack( totalVerts );
+
     return true;
 }
 
@@ -159,27 +325,24 @@ Cylinder::buildData()
     _texCoords = new GLfloat[ totalVerts * 2 ];
     _vertices = new GLfloat[ totalVerts * 3 ];
     _normals = new GLfloat[ totalVerts * 3 ];
-    _indices = new GLushort[ totalVerts ];
 
     const float halfLength = _length * .5f;
-    const double delta = _2PI / _slices;
+    const float* sinCos = sinCosTable( _slices );
 
     GLfloat* texPtr = _texCoords;
     GLfloat* vertPtr = _vertices;
     GLfloat* normPtr = _normals;
-    GLushort* indexPtr = _indices;
     int idx = 0;
 
 
     //
     // Cylinder body
     _idxStart = idx;
-    double theta = 0.f;
     int i;
     for (i=0; i<_slices; i++)
     {
-        const float cosTheta = (float) cos( theta );
-        const float sinTheta = (float) sin( theta );
+        const float cosTheta = sinCos[ i*2 ];
+        const float sinTheta = sinCos[ i*2+1 ];
 
         vertPtr[0] = cosTheta * _radius;
         vertPtr[1] = sinTheta * _radius;
@@ -195,7 +358,7 @@ Cylinder::buildData()
         texPtr[1] = 1.f;
         texPtr += 2;
 
-        *indexPtr++ = idx++;
+        idx++;
 
         vertPtr[0] = cosTheta * _radius;
         vertPtr[1] = sinTheta * _radius;
@@ -211,9 +374,7 @@ Cylinder::buildData()
         texPtr[1] = 0.f;
         texPtr += 2;
 
-        *indexPtr++ = idx++;
-
-        theta += delta;
+        idx++;
     }
 
     vertPtr[0] = _radius;
@@ -230,7 +391,7 @@ Cylinder::buildData()
     texPtr[1] = 1.f;
     texPtr += 2;
 
-    *indexPtr++ = idx++;
+    idx++;
 
     vertPtr[0] = _radius;
     vertPtr[1] = 0.f;
@@ -246,13 +407,12 @@ Cylinder::buildData()
     texPtr[1] = 0.f;
     texPtr += 2;
 
-    *indexPtr++ = idx++;
+    idx++;
 
 
     //
     // Cap 1 (positive Z)
-    _cap1Idx = idx;
-    _cap1Start = indexPtr;
+    const GLuint cap1Idx = idx;
 
     vertPtr[0] = 0.f;
     vertPtr[1] = 0.f;
@@ -268,13 +428,12 @@ Cylinder::buildData()
     texPtr[1] = .5f;
     texPtr += 2;
 
-    *indexPtr++ = idx++;
+    idx++;
 
-    theta = 0.;
     for (i=0; i<_slices; i++)
     {
-        const float cosTheta = (float) cos( theta );
-        const float sinTheta = (float) sin( theta );
+        const float cosTheta = sinCos[ i*2 ];
+        const float sinTheta = sinCos[ i*2+1 ];
 
         vertPtr[0] = cosTheta * _radius;
         vertPtr[1] = sinTheta * _radius;
@@ -290,9 +449,7 @@ Cylinder::buildData()
         texPtr[1] = sinTheta * .5f + .5f;
         texPtr += 2;
 
-        *indexPtr++ = idx++;
-
-        theta += delta;
+        idx++;
     }
 
     vertPtr[0] = _radius;
@@ -309,13 +466,12 @@ Cylinder::buildData()
     texPtr[1] = .5f;
     texPtr += 2;
 
-    *indexPtr++ = idx++;
+    idx++;
 
 
     //
     // Cap 2 (negative Z)
-    _cap2Idx = idx;
-    _cap2Start = indexPtr;
+    const GLuint cap2Idx = idx;
 
     vertPtr[0] = 0.f;
     vertPtr[1] = 0.f;
@@ -331,13 +487,13 @@ Cylinder::buildData()
     texPtr[1] = .5f;
     texPtr += 2;
 
-    *indexPtr++ = idx++;
+    idx++;
 
-    theta = _2PI;
     for (i=0; i<_slices; i++)
     {
-        const float cosTheta = (float) cos( theta );
-        const float sinTheta = (float) sin( theta );
+        // Clockwise, so the cap faces negative Z.
+        const float cosTheta = sinCos[ (_slices-i)*2 ];
+        const float sinTheta = sinCos[ (_slices-i)*2+1 ];
 
         vertPtr[0] = cosTheta * _radius;
         vertPtr[1] = sinTheta * _radius;
@@ -353,9 +509,7 @@ Cylinder::buildData()
         texPtr[1] = sinTheta * .5f + .5f;
         texPtr += 2;
 
-        *indexPtr++ = idx++;
-
-        theta -= delta;
+        idx++;
     }
 
     vertPtr[0] = _radius;
@@ -372,9 +526,51 @@ Cylinder::buildData()
     texPtr[1] = .5f;
     texPtr += 2;
 
-    *indexPtr++ = idx++;
+    idx++;
     assert( idx == totalVerts );
-    _idxEnd = idx;
+    _idxEnd = totalVerts - 1;
+
+
+    //
+    // Indices. One triangle list, with two triangles for each quad of
+    //   the body followed by one triangle per slice for each cap.
+    _numIndices = _slices * 6;
+    if (_drawCap1)
+        _numIndices += _slices * 3;
+    if (_drawCap2)
+        _numIndices += _slices * 3;
+    GLuint* indexPtr = _indices.allocate( _numIndices );
+
+    for (i=0; i<_slices; i++)
+    {
+        const GLuint v0 = _idxStart + i*2;
+
+        *indexPtr++ = v0;
+        *indexPtr++ = v0 + 1;
+        *indexPtr++ = v0 + 3;
+
+        *indexPtr++ = v0;
+        *indexPtr++ = v0 + 3;
+        *indexPtr++ = v0 + 2;
+    }
+    if (_drawCap1)
+    {
+        for (i=1; i<=_slices; i++)
+        {
+            *indexPtr++ = cap1Idx;
+            *indexPtr++ = cap1Idx + i;
+            *indexPtr++ = cap1Idx + i + 1;
+        }
+    }
+    if (_drawCap2)
+    {
+        for (i=1; i<=_slices; i++)
+        {
+            *indexPtr++ = cap2Idx;
+            *indexPtr++ = cap2Idx + i;
+            *indexPtr++ = cap2Idx + i + 1;
+        }
+    }
 
     return true;
 }
@@ -401,11 +597,7 @@ Cylinder::storeData()
     glTexCoordPointer( 2, GL_FLOAT, 0, _texCoords );
 
 
-    glDrawElements( GL_QUAD_STRIP, _numVerts, GL_UNSIGNED_SHORT, _indices );
-    if (_drawCap1)
-        glDrawElements( GL_TRIANGLE_FAN, _numCapVerts, GL_UNSIGNED_SHORT, _cap1Start );
-    if (_drawCap2)
-        glDrawElements( GL_TRIANGLE_FAN, _numCapVerts, GL_UNSIGNED_SHORT, _cap2Start );
+    glDrawElements( GL_TRIANGLES, _numIndices, _indices.getType(), _indices.getData() );
 
     glPopClientAttrib();
 
@@ -433,6 +625,7 @@ Cylinder12::Cylinder12( float radius, float length, int slices )
 
 Cylinder12::~Cylinder12()
 {
+    cancelBuild();
 }
 
 
@@ -455,14 +648,8 @@ Cylinder12::storeData()
     glEnableClientState( GL_TEXTURE_COORD_ARRAY );
     glTexCoordPointer( 2, GL_FLOAT, 0, _texCoords );
 
-    glDrawRangeElements( GL_QUAD_STRIP, _idxStart, _cap1Idx-1, _numVerts,
-            GL_UNSIGNED_SHORT, _indices );
-    if (_drawCap1)
-        glDrawRangeElements( GL_TRIANGLE_FAN, _cap1Idx, _cap2Idx-1, _numCapVerts,
-                GL_UNSIGNED_SHORT, _cap1Start );
-    if (_drawCap2)
-        glDrawRangeElements( GL_TRIANGLE_FAN, _cap2Idx, _idxEnd-1, _numCapVerts,
-                GL_UNSIGNED_SHORT, _cap2Start );
+    glDrawRangeElements( GL_TRIANGLES, _idxStart, _idxEnd, _numIndices,
+            _indices.getType(), _indices.getData() );
 
     glPopClientAttrib();
 
@@ -493,6 +680,7 @@ Cylinder13::Cylinder13( float radius, float length, int slices )
 
 Cylinder13::~Cylinder13()
 {
+    cancelBuild();
 }
 
 
@@ -521,14 +709,8 @@ Cylinder13::storeData()
     }
 
 
-    glDrawRangeElements( GL_QUAD_STRIP, _idxStart, _cap1Idx-1, _numVerts,
-            GL_UNSIGNED_SHORT, _indices );
-    if (_drawCap1)
-        glDrawRangeElements( GL_TRIANGLE_FAN, _cap1Idx, _cap2Idx-1, _numCapVerts,
-                GL_UNSIGNED_SHORT, _cap1Start );
-    if (_drawCap2)
-        glDrawRangeElements( GL_TRIANGLE_FAN, _cap2Idx, _idxEnd-1, _numCapVerts,
-                GL_UNSIGNED_SHORT, _cap2Start );
+    glDrawRangeElements( GL_TRIANGLES, _idxStart, _idxEnd, _numIndices,
+            _indices.getType(), _indices.getData() );
 
     glPopClientAttrib();
 
@@ -550,62 +732,146 @@ Cylinder13::storeData()
 #ifdef GL_VERSION_1_5
 
 
-// Static indices into the _vbo vertex buffer array
-int Cylinder15::_vertIdx( 0 );
-int Cylinder15::_normIdx( 1 );
-int Cylinder15::_texIdx( 2 );
-int Cylinder15::_idxIdx( 3 );
+// Layout of the interleaved vertex buffer object: three position
+//   floats, three normal floats, and two texture coordinate floats.
+static const int INTERLEAVED_FLOATS( 8 );
+static const unsigned int NORMAL_OFFSET( 3 * sizeof( GLfloat ) );
+static const unsigned int TEXCOORD_OFFSET( 6 * sizeof( GLfloat ) );
 
 
 Cylinder15::Cylinder15( float radius, float length, int slices )
-  : Cylinder( radius, length, slices )
+  : Cylinder( radius, length, slices ),
+    _vertBlock( NULL ),
+    _idxBlock( NULL )
 {
     assert( OGLDif::instance()->getVersion() >= Ver15 );
 }
 
 Cylinder15::~Cylinder15()
 {
-    if ( _valid )
-        glDeleteBuffers( 4, _vbo );
+    cancelBuild();
+
+    if ( _valid && (_master == NULL) )
+    {
+        BufferArena::instance()->release( _vertBlock );
+        BufferArena::instance()->release( _idxBlock );
+    }
+}
+
+void
+Cylinder15::contextLost()
+{
+    // Return the blocks to their lost page. BufferArena::release()
+    //   makes no OpenGL calls.
+    if ( _valid && (_master == NULL) )
+    {
+        BufferArena::instance()->release( _vertBlock );
+        BufferArena::instance()->release( _idxBlock );
+        _vertBlock = _idxBlock = NULL;
+    }
+
+    Cylinder::contextLost();
 }
 
 void
 Cylinder15::draw()
 {
+    if (drawLOD())
+        return;
+
     if (!_valid)
     {
         if (!init())
             return;
     }
 
+    if (_master)
+    {
+        _master->draw();
+        return;
+    }
+
     glPushClientAttrib( GL_CLIENT_VERTEX_ARRAY_BIT );
 
-    glEnableClientState( GL_VERTEX_ARRAY );
-    glBindBuffer( GL_ARRAY_BUFFER, _vbo[_vertIdx] );
-    glVertexPointer( 3, GL_FLOAT, 0, bufferObjectPtr( 0 ) );
+    if (_vertexFormat == CompactVertexFormat)
+        _compact.pushTransform( _numTextures );
+    setPointers();
 
-    glEnableClientState( GL_NORMAL_ARRAY );
-    glBindBuffer( GL_ARRAY_BUFFER, _vbo[_normIdx] );
-    glNormalPointer( GL_FLOAT, 0, bufferObjectPtr( 0 ) );
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, _idxBlock->getBuffer() );
+    glDrawRangeElements( GL_TRIANGLES, _idxStart, _idxEnd, _numIndices,
+            _indices.getType(), bufferObjectPtr( _idxBlock->getOffset() ) );
 
-    int tIdx;
-    for (tIdx=0; tIdx<_numTextures; tIdx++)
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+
+    glPopClientAttrib();
+
+    if (_vertexFormat == CompactVertexFormat)
+        _compact.popTransform( _numTextures );
+
+
+    OGLDIF_CHECK_ERROR;
+}
+
+void
+Cylinder15::setPointers() const
+{
+    glBindBuffer( GL_ARRAY_BUFFER, _vertBlock->getBuffer() );
+    const GLuint base = (GLuint) _vertBlock->getOffset();
+
+    if (_vertexFormat == CompactVertexFormat)
+        _compact.setPointers( (const GLubyte*) bufferObjectPtr( base ), _numTextures );
+    else
     {
-        glClientActiveTexture( GL_TEXTURE0 + tIdx );
-        glEnableClientState( GL_TEXTURE_COORD_ARRAY );
-        glBindBuffer( GL_ARRAY_BUFFER, _vbo[_texIdx] );
-        glTexCoordPointer( 2, GL_FLOAT, 0, bufferObjectPtr( 0 ) );
+        const GLsizei stride = INTERLEAVED_FLOATS * sizeof( GLfloat );
+
+        glEnableClientState( GL_VERTEX_ARRAY );
+        glVertexPointer( 3, GL_FLOAT, stride, bufferObjectPtr( base ) );
+
+        glEnableClientState( GL_NORMAL_ARRAY );
+        glNormalPointer( GL_FLOAT, stride, bufferObjectPtr( base + NORMAL_OFFSET ) );
+
+        int tIdx;
+        for (tIdx=0; tIdx<_numTextures; tIdx++)
+        {
+            glClientActiveTexture( GL_TEXTURE0 + tIdx );
+            glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+            glTexCoordPointer( 2, GL_FLOAT, stride, bufferObjectPtr( base + TEXCOORD_OFFSET ) );
+        }
     }
+}
 
-    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, _vbo[_idxIdx] );
-    glDrawRangeElements( GL_QUAD_STRIP, _idxStart, _cap1Idx-1, _numVerts,
-            GL_UNSIGNED_SHORT, bufferObjectPtr( 0 ) );
-    if (_drawCap1)
-        glDrawRangeElements( GL_TRIANGLE_FAN, _cap1Idx, _cap2Idx-1, _numCapVerts,
-                GL_UNSIGNED_SHORT, bufferObjectPtr((_cap1Start-_indices)*sizeof(GLushort)) );
-    if (_drawCap2)
-        glDrawRangeElements( GL_TRIANGLE_FAN, _cap2Idx, _idxEnd-1, _numCapVerts,
-                GL_UNSIGNED_SHORT, bufferObjectPtr((_cap2Start-_indices)*sizeof(GLushort)) );
+bool
+Cylinder15::drawInstancedElements( int count, InstanceBuffer& instances )
+{
+#ifdef GL_VERSION_3_3
+    if (!_valid)
+    {
+        // Like draw(), draw nothing until a buildAsync() finishes.
+        if (!init())
+            return true;
+    }
+
+    if (_master)
+    {
+        _master->drawInstanced( count, instances );
+        return true;
+    }
+
+    glPushClientAttrib( GL_CLIENT_VERTEX_ARRAY_BIT );
+
+    setPointers();
+    if (!instances.bind())
+    {
+        glBindBuffer( GL_ARRAY_BUFFER, 0 );
+        glPopClientAttrib();
+        return false;
+    }
+
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, _idxBlock->getBuffer() );
+    glDrawElementsInstanced( GL_TRIANGLES, _numIndices, _indices.getType(), bufferObjectPtr( _idxBlock->getOffset() ), count );
+
+    instances.unbind();
 
     glBindBuffer( GL_ARRAY_BUFFER, 0 );
     glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
@@ -614,6 +880,11 @@ Cylinder15::draw()
 
 
     OGLDIF_CHECK_ERROR;
+
+    return true;
+#else
+    return false;
+#endif
 }
 
 bool
@@ -621,19 +892,41 @@ Cylinder15::storeData()
 {
     const int totalVerts = _numVerts + (_numCapVerts * 2);
 
-    glGenBuffers( 4, _vbo );
-
-    glBindBuffer( GL_ARRAY_BUFFER, _vbo[_texIdx] );
-    glBufferData( GL_ARRAY_BUFFER, totalVerts*2*sizeof(GLfloat), _texCoords, GL_STATIC_DRAW );
+    if (_vertexFormat == CompactVertexFormat)
+    {
+        _compact.build( totalVerts, _vertices, _normals, _texCoords, 2 );
+        _vertBlock = BufferArena::instance()->allocate( GL_ARRAY_BUFFER, _compact.getSizeBytes(), _compact.getData() );
+        _compact.releaseData();
+        _compact.getErrors( _positionError, _normalError, _texCoordError );
+    }
+    else
+    {
+        // Interleave the vertex data so that each vertex is fetched
+        //   from one buffer object with a single bind.
+        GLfloat* interleaved = new GLfloat[ totalVerts * INTERLEAVED_FLOATS ];
+        GLfloat* destPtr = interleaved;
+        const GLfloat* vertPtr = _vertices;
+        const GLfloat* normPtr = _normals;
+        const GLfloat* texPtr = _texCoords;
+        int idx;
+        for (idx=0; idx<totalVerts; idx++)
+        {
+            *destPtr++ = *vertPtr++;
+            *destPtr++ = *vertPtr++;
+            *destPtr++ = *vertPtr++;
+            *destPtr++ = *normPtr++;
+            *destPtr++ = *normPtr++;
+            *destPtr++ = *normPtr++;
+            *destPtr++ = *texPtr++;
+            *destPtr++ = *texPtr++;
+        }
 
-    glBindBuffer( GL_ARRAY_BUFFER, _vbo[_normIdx] );
-    glBufferData( GL_ARRAY_BUFFER, totalVerts*3*sizeof(GLfloat), _normals, GL_STATIC_DRAW );
+        _vertBlock = BufferArena::instance()->allocate( GL_ARRAY_BUFFER, totalVerts*INTERLEAVED_FLOATS*sizeof(GLfloat), interleaved );
 
-    glBindBuffer( GL_ARRAY_BUFFER, _vbo[_vertIdx] );
-    glBufferData( GL_ARRAY_BUFFER, totalVerts*3*sizeof(GLfloat), _vertices, GL_STATIC_DRAW );
+        delete[] interleaved;
+    }
 
-    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, _vbo[_idxIdx] );
-    glBufferData( GL_ELEMENT_ARRAY_BUFFER, totalVerts*sizeof(GLushort), _indices, GL_STATIC_DRAW );
+    _idxBlock = BufferArena::instance()->allocate( GL_ELEMENT_ARRAY_BUFFER, _indices.getSizeBytes(), _indices.getData() );
 
 
     glBindBuffer( GL_ARRAY_BUFFER, 0 );
@@ -0,0 +1,206 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+// 
+
+
+#include "OGLDPlatformGL.h"
+#include "OGLDFrustum.h"
+#include "OGLDView.h"
+#include "OGLDMath.h"
+#include <math.h>
+
+
+
+namespace ogld
+{
+
+
+Frustum::Frustum()
+{
+    // Until set(), accept everything: each plane is 0x+0y+0z+1 >= 0.
+    int idx;
+    for (idx=0; idx<NUM_PLANES; idx++)
+    {
+        _a[ idx ] = _b[ idx ] = _c[ idx ] = 0.f;
+        _absA[ idx ] = _absB[ idx ] = _absC[ idx ] = 0.f;
+        _d[ idx ] = 1.f;
+    }
+}
+
+
+void
+Frustum::set( const View& view, double fovy, double aspect, double zNear, double zFar )
+{
+    const double f = 1. / tan( degreesToRadians( fovy ) * .5 );
+
+    double proj[ 16 ];
+    int idx;
+    for (idx=0; idx<16; idx++)
+        proj[ idx ] = 0.;
+    proj[0] = f / aspect;
+    proj[5] = f;
+    proj[10] = (zFar + zNear) / (zNear - zFar);
+    proj[11] = -1.;
+    proj[14] = 2. * zFar * zNear / (zNear - zFar);
+
+    double modelView[ 16 ];
+    view.getMatrix( modelView );
+
+    set( proj, modelView );
+}
+
+void
+Frustum::set( const double* proj, const double* modelView )
+{
+    // Concatenate, then extract each plane from the sum or difference
+    //   of the clip matrix's fourth row and one of its other rows.
+    double clip[ 16 ];
+    int row, col;
+    for (col=0; col<4; col++)
+    {
+        for (row=0; row<4; row++)
+        {
+            clip[ col*4+row ] = proj[ row ] * modelView[ col*4 ] +
+                    proj[ 4+row ] * modelView[ col*4+1 ] +
+                    proj[ 8+row ] * modelView[ col*4+2 ] +
+                    proj[ 12+row ] * modelView[ col*4+3 ];
+        }
+    }
+
+    int plane;
+    for (plane=0; plane<6; plane++)
+    {
+        row = plane >> 1;
+        const double sign = (plane & 1) ? -1. : 1.;
+
+        const double a = clip[ 3 ] + sign * clip[ row ];
+        const double b = clip[ 7 ] + sign * clip[ 4+row ];
+        const double c = clip[ 11 ] + sign * clip[ 8+row ];
+        const double d = clip[ 15 ] + sign * clip[ 12+row ];
+
+        // Normalize, so that plane distances are in world units and
+        //   bounding sphere radii compare directly.
+        const double len = sqrt( a*a + b*b + c*c );
+        const double scale = (len > 0.) ? (1. / len) : 0.;
+
+        _a[ plane ] = (float)( a * scale );
+        _b[ plane ] = (float)( b * scale );
+        _c[ plane ] = (float)( c * scale );
+        _d[ plane ] = (float)( d * scale );
+        _absA[ plane ] = (float) fabs( _a[ plane ] );
+        _absB[ plane ] = (float) fabs( _b[ plane ] );
+        _absC[ plane ] = (float) fabs( _c[ plane ] );
+    }
+}
+
+void
+Frustum::setFromGL()
+{
+    GLdouble proj[ 16 ], modelView[ 16 ];
+    glGetDoublev( GL_PROJECTION_MATRIX, proj );
+    glGetDoublev( GL_MODELVIEW_MATRIX, modelView );
+
+    set( proj, modelView );
+}
+
+
+bool
+Frustum::intersects( const Bound& bound ) const
+{
+    if (bound.isEmpty())
+        return false;
+
+    const float* minCorner = bound.getMin();
+    const float* maxCorner = bound.getMax();
+    float boxCenter[ 3 ], boxHalfExtent[ 3 ];
+    int idx;
+    for (idx=0; idx<3; idx++)
+    {
+        boxCenter[ idx ] = (minCorner[ idx ] + maxCorner[ idx ]) * .5f;
+        boxHalfExtent[ idx ] = (maxCorner[ idx ] - minCorner[ idx ]) * .5f;
+    }
+
+    return( intersects( bound.getCenter(), bound.getRadius(), boxCenter, boxHalfExtent ) );
+}
+
+bool
+Frustum::intersects( const Bound& bound, const double* m ) const
+{
+    if (bound.isEmpty())
+        return false;
+
+    // Transform the sphere center, and scale its radius by the
+    //   largest axis scale.
+    const float* center = bound.getCenter();
+    float sphereCenter[ 3 ];
+    double maxSqScale = 0.;
+    int idx;
+    for (idx=0; idx<3; idx++)
+    {
+        sphereCenter[ idx ] = (float)( m[ idx ] * center[0] + m[ 4+idx ] * center[1] +
+                m[ 8+idx ] * center[2] + m[ 12+idx ] );
+
+        const double* axis = m + idx*4;
+        const double sqScale = axis[0]*axis[0] + axis[1]*axis[1] + axis[2]*axis[2];
+        if (sqScale > maxSqScale)
+            maxSqScale = sqScale;
+    }
+    const float radius = (float)( bound.getRadius() * sqrt( maxSqScale ) );
+
+    // Transform the box center, and take the extent of the
+    //   transformed box along each axis (Arvo's method).
+    const float* minCorner = bound.getMin();
+    const float* maxCorner = bound.getMax();
+    double localCenter[ 3 ], localHalfExtent[ 3 ];
+    for (idx=0; idx<3; idx++)
+    {
+        localCenter[ idx ] = (minCorner[ idx ] + maxCorner[ idx ]) * .5;
+        localHalfExtent[ idx ] = (maxCorner[ idx ] - minCorner[ idx ]) * .5;
+    }
+    float boxCenter[ 3 ], boxHalfExtent[ 3 ];
+    for (idx=0; idx<3; idx++)
+    {
+        boxCenter[ idx ] = (float)( m[ idx ] * localCenter[0] + m[ 4+idx ] * localCenter[1] +
+                m[ 8+idx ] * localCenter[2] + m[ 12+idx ] );
+        boxHalfExtent[ idx ] = (float)( fabs( m[ idx ] ) * localHalfExtent[0] +
+                fabs( m[ 4+idx ] ) * localHalfExtent[1] +
+                fabs( m[ 8+idx ] ) * localHalfExtent[2] );
+    }
+
+    return( intersects( sphereCenter, radius, boxCenter, boxHalfExtent ) );
+}
+
+bool
+Frustum::intersects( const float* sphereCenter, float radius,
+        const float* boxCenter, const float* boxHalfExtent ) const
+{
+    // Test all planes without branching. A sphere or box is outside
+    //   if it is entirely behind any one plane.
+    int outside = 0;
+    int plane;
+    for (plane=0; plane<NUM_PLANES; plane++)
+    {
+        const float sphereDist = _a[ plane ] * sphereCenter[0] + _b[ plane ] * sphereCenter[1] +
+                _c[ plane ] * sphereCenter[2] + _d[ plane ] + radius;
+
+        const float boxDist = _a[ plane ] * boxCenter[0] + _b[ plane ] * boxCenter[1] +
+                _c[ plane ] * boxCenter[2] + _d[ plane ] +
+                _absA[ plane ] * boxHalfExtent[0] + _absB[ plane ] * boxHalfExtent[1] +
+                _absC[ plane ] * boxHalfExtent[2];
+
+        outside |= (sphereDist < 0.f) | (boxDist < 0.f);
+    }
+
+    return( outside == 0 );
+}
+
+
+}
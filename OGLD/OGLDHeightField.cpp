@@ -0,0 +1,845 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+// 
+
+
+#include "OGLDPlatformGL.h"
+#include "OGLDHeightField.h"
+#include "OGLDif.h"
+#include "OGLDMath.h"
+#include "OGLDFrustum.h"
+#include "OGLDVertexCache.h"
+#include "OGLDMeshCache.h"
+#include "OGLDShapeTuner.h"
+#include <math.h>
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+
+
+namespace ogld
+{
+
+
+// Layout of the interleaved vertex data: three position floats,
+//   three normal floats, and two texture coordinate floats.
+static const int INTERLEAVED_FLOATS( 8 );
+static const unsigned int NORMAL_OFFSET( 3 * sizeof( GLfloat ) );
+static const unsigned int TEXCOORD_OFFSET( 6 * sizeof( GLfloat ) );
+
+
+// Static factory creation methods
+HeightField*
+HeightField::create( float xLen, float yLen, int xUnits, int yUnits, const float* zArray, int chunkUnits )
+{
+    HeightField* hf = newInstance( xLen, yLen, xUnits, yUnits, zArray, chunkUnits );
+    if (hf)
+        hf->initBounds();
+    return hf;
+}
+
+HeightField*
+HeightField::create( float xLen, float yLen, int xUnits, int yUnits, const GLushort* samples, int chunkUnits )
+{
+    HeightField* hf = newInstance( xLen, yLen, xUnits, yUnits, NULL, chunkUnits );
+    if (hf)
+    {
+        // Convert straight into the height field's own z array.
+        convertHeightSamples( hf->_zArray, samples, hf->_xUnits, hf->_yUnits );
+        hf->initBounds();
+    }
+    return hf;
+}
+
+HeightField*
+HeightField::newInstance( float xLen, float yLen, int xUnits, int yUnits, const float* zArray, int chunkUnits )
+{
+    HeightField* hf( NULL );
+
+    switch (ShapeTuner::instance()->getShapeVersion())
+    {
+
+    case VerExtended:
+    case Ver20:
+    case Ver15:
+#ifdef GL_VERSION_1_5
+        hf = new HeightField15( xLen, yLen, xUnits, yUnits, zArray, chunkUnits );
+        break;
+#endif
+
+    case Ver14:
+    case Ver13:
+    case Ver12:
+    case Ver11:
+#ifdef GL_VERSION_1_1
+        hf = new HeightField( xLen, yLen, xUnits, yUnits, zArray, chunkUnits );
+        break;
+#endif
+
+    case Ver10:
+    case VerUnknown:
+    default:
+        assert( false );
+        return NULL;
+        break;
+    }
+
+    return hf;
+}
+
+
+HeightField::HeightField( float xLen, float yLen, int xUnits, int yUnits, const float* zArray, int chunkUnits )
+  : _xLen( xLen ),
+    _yLen( yLen ),
+    _xUnits( xUnits ),
+    _yUnits( yUnits ),
+    _zArray( NULL ),
+    _chunkUnits( chunkUnits ),
+    _numLevels( 0 ),
+    _xChunks( 0 ),
+    _yChunks( 0 ),
+    _chunks( NULL ),
+    _vertices( NULL ),
+    _vertsPerChunk( 0 ),
+    _valid( false ),
+    _chunksDrawn( 0 ),
+    _trianglesDrawn( 0 )
+{
+    assert( OGLDif::instance()->getVersion() >= Ver11 );
+
+    if (_xUnits < 1)
+        _xUnits = 1;
+    if (_yUnits < 1)
+        _yUnits = 1;
+
+    if (_chunkUnits < 2)
+        _chunkUnits = 2;
+    else if (_chunkUnits > MAX_CHUNK_UNITS)
+        _chunkUnits = MAX_CHUNK_UNITS;
+    // Round up to a power of two.
+    for (_numLevels=1; (1 << (_numLevels-1)) < _chunkUnits; _numLevels++)
+        ;
+    _chunkUnits = 1 << (_numLevels-1);
+    _vertsPerChunk = (_chunkUnits+1) * (_chunkUnits+1);
+
+    const int sz = (_xUnits+1) * (_yUnits+1);
+    _zArray = new float[ sz ];
+    if (zArray)
+        memcpy( _zArray, zArray, sz * sizeof( float ) );
+}
+
+void
+HeightField::initBounds()
+{
+    // Bound each chunk, and the whole field, now, so that they're
+    //   available before the first draw().
+    _xChunks = (_xUnits + _chunkUnits - 1) / _chunkUnits;
+    _yChunks = (_yUnits + _chunkUnits - 1) / _chunkUnits;
+    _chunks = new Chunk[ _xChunks * _yChunks ];
+
+    const float halfXLen = _xLen * .5f;
+    const float halfYLen = _yLen * .5f;
+    const float xStep = _xLen / (float)_xUnits;
+    const float yStep = _yLen / (float)_yUnits;
+    float minZ = _zArray[ 0 ], maxZ = _zArray[ 0 ];
+    int cx, cy;
+    for (cx=0; cx<_xChunks; cx++)
+    {
+        for (cy=0; cy<_yChunks; cy++)
+        {
+            const int x0 = gridX( cx, 0 ), x1 = gridX( cx, _chunkUnits );
+            const int y0 = gridY( cy, 0 ), y1 = gridY( cy, _chunkUnits );
+
+            float chunkMinZ = getZ( x0, y0 ), chunkMaxZ = chunkMinZ;
+            int x, y;
+            for (x=x0; x<=x1; x++)
+            {
+                for (y=y0; y<=y1; y++)
+                {
+                    const float z = getZ( x, y );
+                    if (z < chunkMinZ)
+                        chunkMinZ = z;
+                    else if (z > chunkMaxZ)
+                        chunkMaxZ = z;
+                }
+            }
+            if (chunkMinZ < minZ)
+                minZ = chunkMinZ;
+            if (chunkMaxZ > maxZ)
+                maxZ = chunkMaxZ;
+
+            const float xa = -halfXLen + x0 * xStep, xb = -halfXLen + x1 * xStep;
+            const float ya = -halfYLen + y0 * yStep, yb = -halfYLen + y1 * yStep;
+
+            Chunk& chunk = _chunks[ cx*_yChunks + cy ];
+            chunk._bound.setBox( (xa < xb) ? xa : xb, (ya < yb) ? ya : yb, chunkMinZ,
+                    (xa < xb) ? xb : xa, (ya < yb) ? yb : ya, chunkMaxZ );
+            chunk._bound.setSphereFromBox();
+            int level;
+            for (level=0; level<MAX_LEVELS; level++)
+                chunk._error[ level ] = 0.f;
+            chunk._level = 0;
+            chunk._visible = true;
+        }
+    }
+
+    const float halfX = (float) fabs( halfXLen );
+    const float halfY = (float) fabs( halfYLen );
+    _bound.setBox( -halfX, -halfY, minZ, halfX, halfY, maxZ );
+    _bound.setSphereFromBox();
+}
+
+HeightField::~HeightField()
+{
+    cancelBuild();
+
+    IndexMap::iterator it;
+    for (it=_indexMap.begin(); it!=_indexMap.end(); it++)
+        delete it->second;
+    _indexMap.clear();
+
+    freeHostArray( _vertices );
+    if (_chunks)
+        delete[] _chunks;
+    if (_zArray)
+        delete[] _zArray;
+    _chunks = NULL;
+    _zArray = NULL;
+    _valid = false;
+}
+
+
+void
+HeightField::draw()
+{
+    if (!_valid)
+    {
+        if (!init())
+            return;
+    }
+
+    selectLevels();
+
+    _chunksDrawn = _trianglesDrawn = 0;
+
+    beginChunks();
+
+    const int numChunks = _xChunks * _yChunks;
+    int idx;
+    for (idx=0; idx<numChunks; idx++)
+    {
+        if (!_chunks[ idx ]._visible)
+            continue;
+
+        const IndexArray& indices = getIndices( idx );
+        setPointers( idx );
+        glDrawElements( GL_TRIANGLES, indices.getCount(), indices.getType(), indices.getData() );
+
+        _chunksDrawn++;
+        _trianglesDrawn += indices.getCount() / 3;
+    }
+
+    endChunks();
+
+
+    OGLDIF_CHECK_ERROR;
+}
+
+
+int
+HeightField::getNumChunks() const
+{
+    return _xChunks * _yChunks;
+}
+
+int
+HeightField::getChunksDrawn() const
+{
+    return _chunksDrawn;
+}
+
+int
+HeightField::getTrianglesDrawn() const
+{
+    return _trianglesDrawn;
+}
+
+
+bool
+HeightField::init()
+{
+    // Tessellate now, unless buildAsync() already started it.
+    if (!finishBuild())
+        return false;
+
+    if (!storeData())
+        return false;
+
+    return true;
+}
+
+bool
+HeightField::buildGeometry()
+{
+    const int numChunks = _xChunks * _yChunks;
+    _vertices = new GLfloat[ numChunks * _vertsPerChunk * INTERLEAVED_FLOATS ];
+
+    const float halfXLen = _xLen * .5f;
+    const float halfYLen = _yLen * .5f;
+    const float xStep = _xLen / (float)_xUnits;
+    const float yStep = _yLen / (float)_yUnits;
+
+    GLfloat* vertPtr = _vertices;
+    int cx, cy;
+    for (cx=0; cx<_xChunks; cx++)
+    {
+        for (cy=0; cy<_yChunks; cy++)
+        {
+            int i, j;
+            for (i=0; i<=_chunkUnits; i++)
+            {
+                const int x = gridX( cx, i );
+                for (j=0; j<=_chunkUnits; j++)
+                {
+                    const int y = gridY( cy, j );
+
+                    *vertPtr++ = -halfXLen + x * xStep;
+                    *vertPtr++ = -halfYLen + y * yStep;
+                    *vertPtr++ = getZ( x, y );
+
+                    // Normal from the central difference slopes; see
+                    //   Plane::buildData() for the orientation.
+                    const int xa = (x > 0) ? x-1 : x, xb = (x < _xUnits) ? x+1 : x;
+                    const int ya = (y > 0) ? y-1 : y, yb = (y < _yUnits) ? y+1 : y;
+                    const float dzdx = (getZ( xb, y ) - getZ( xa, y )) / (float)( xb - xa );
+                    const float dzdy = (getZ( x, yb ) - getZ( x, ya )) / (float)( yb - ya );
+                    Vec3d normal( -dzdx * yStep, -xStep * dzdy, xStep * yStep );
+                    normal.normalize();
+                    *vertPtr++ = (float) normal[0];
+                    *vertPtr++ = (float) normal[1];
+                    *vertPtr++ = (float) normal[2];
+
+                    *vertPtr++ = (float)x / (float)_xUnits;
+                    *vertPtr++ = (float)y / (float)_yUnits;
+                }
+            }
+
+            // Error of each level: the largest z distance from a grid
+            //   point to the triangles of the level's regular grid.
+            //   Keep it nondecreasing from level to level.
+            Chunk& chunk = _chunks[ cx*_yChunks + cy ];
+            int level;
+            for (level=1; level<_numLevels; level++)
+            {
+                const int step = 1 << level;
+                float error = chunk._error[ level-1 ];
+                for (i=0; i<=_chunkUnits; i++)
+                {
+                    const int ci = (i < _chunkUnits) ? (i / step) * step : _chunkUnits - step;
+                    const float u = (float)( i - ci ) / (float)step;
+                    for (j=0; j<=_chunkUnits; j++)
+                    {
+                        const int cj = (j < _chunkUnits) ? (j / step) * step : _chunkUnits - step;
+                        const float v = (float)( j - cj ) / (float)step;
+
+                        const float z00 = getZ( gridX( cx, ci ), gridY( cy, cj ) );
+                        const float z10 = getZ( gridX( cx, ci+step ), gridY( cy, cj ) );
+                        const float z01 = getZ( gridX( cx, ci ), gridY( cy, cj+step ) );
+                        const float z11 = getZ( gridX( cx, ci+step ), gridY( cy, cj+step ) );
+                        const float z = (u + v <= 1.f) ?
+                                z00 + u * (z10 - z00) + v * (z01 - z00) :
+                                z11 + (1.f - u) * (z01 - z11) + (1.f - v) * (z10 - z11);
+
+                        const float delta = (float) fabs( getZ( gridX( cx, i ), gridY( cy, j ) ) - z );
+                        if (delta > error)
+                            error = delta;
+                    }
+                }
+                chunk._error[ level ] = error;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool
+HeightField::getCacheKey( std::string& key ) const
+{
+    char buf[ 128 ];
+    sprintf( buf, "HeightField %.9g %.9g %d %d %d ", _xLen, _yLen, _xUnits, _yUnits, _chunkUnits );
+    key = std::string( buf ) +
+            MeshCache::hash( _zArray, (_xUnits+1)*(_yUnits+1)*sizeof( float ) );
+    return true;
+}
+
+bool
+HeightField::saveGeometry( MeshCacheWriter& writer ) const
+{
+    const int numChunks = _xChunks * _yChunks;
+    const int counts[ 3 ] = { numChunks, _vertsPerChunk, _numLevels };
+    writer.addInts( counts, 3 );
+    writer.addFloats( _vertices, numChunks * _vertsPerChunk * INTERLEAVED_FLOATS );
+
+    // The chunk errors aren't contiguous; gather them for the writer to copy.
+    std::vector< GLfloat > errors( numChunks * MAX_LEVELS );
+    int idx;
+    for (idx=0; idx<numChunks; idx++)
+        memcpy( &errors[ idx * MAX_LEVELS ], _chunks[ idx ]._error, MAX_LEVELS * sizeof( float ) );
+    writer.addFloats( &errors[ 0 ], numChunks * MAX_LEVELS, true );
+    return true;
+}
+
+bool
+HeightField::loadGeometry( MeshCacheEntry& entry )
+{
+    const int numChunks = _xChunks * _yChunks;
+    int counts[ 3 ];
+    if ( !entry.getInts( counts, 3 ) || (counts[0] != numChunks) ||
+            (counts[1] != _vertsPerChunk) || (counts[2] != _numLevels) )
+        return false;
+    const GLfloat* vertices = entry.getFloats( numChunks * _vertsPerChunk * INTERLEAVED_FLOATS );
+    const GLfloat* errors = vertices ? entry.getFloats( numChunks * MAX_LEVELS ) : NULL;
+    if (errors == NULL)
+        return false;
+
+    _vertices = (GLfloat*) vertices;
+    int idx;
+    for (idx=0; idx<numChunks; idx++)
+        memcpy( _chunks[ idx ]._error, &errors[ idx * MAX_LEVELS ], MAX_LEVELS * sizeof( float ) );
+    return true;
+}
+
+bool
+HeightField::storeData()
+{
+    // Vertices stay in client memory.
+    return( _valid = true );
+}
+
+
+void
+HeightField::selectLevels()
+{
+    GLdouble modelView[ 16 ], proj[ 16 ];
+    GLint viewport[ 4 ];
+    getLODView( modelView, proj, viewport );
+
+    Frustum frustum;
+    frustum.set( proj, modelView );
+
+    // Pixels per object unit, before dividing by eye distance for
+    //   perspective projections. See Shape::drawLOD().
+    double scale = 0.;
+    int col;
+    for (col=0; col<3; col++)
+    {
+        const double* c = modelView + col*4;
+        const double len = sqrt( c[0]*c[0] + c[1]*c[1] + c[2]*c[2] );
+        if (len > scale)
+            scale = len;
+    }
+    const double pixelsPerUnit = fabs( proj[5] ) * viewport[3] * .5 * scale;
+    const bool perspective = (proj[11] != 0.);
+
+    const int numChunks = _xChunks * _yChunks;
+    int idx;
+    for (idx=0; idx<numChunks; idx++)
+    {
+        Chunk& chunk = _chunks[ idx ];
+
+        // Culled chunks still get a level, so that their visible
+        //   neighbors stitch to it consistently from frame to frame.
+        chunk._visible = frustum.intersects( chunk._bound );
+        chunk._level = 0;
+        if (!_lodEnable)
+            continue;
+
+        double ppu = pixelsPerUnit;
+        if (perspective)
+        {
+            const float* c = chunk._bound.getCenter();
+            const double eyeZ = -( modelView[2]*c[0] + modelView[6]*c[1] +
+                    modelView[10]*c[2] + modelView[14] );
+            const double nearest = eyeZ - chunk._bound.getRadius() * scale;
+            if (nearest <= 0.)
+                // The viewer is inside or beside the chunk.
+                continue;
+            ppu /= nearest;
+        }
+
+        int level;
+        for (level=_numLevels-1; level>0; level--)
+        {
+            if (chunk._error[ level ] * ppu <= _lodPixelError)
+                break;
+        }
+        chunk._level = level;
+    }
+}
+
+
+const IndexArray&
+HeightField::getIndices( int idx )
+{
+    const int cx = idx / _yChunks;
+    const int cy = idx % _yChunks;
+    const int level = _chunks[ idx ]._level;
+
+    // Each side samples at the coarser of this chunk's level and its
+    //   neighbor's, so that both draw the same edge.
+    int sideLevel[ 4 ];
+    const int neighbor[ 4 ] = {
+        (cy > 0) ? idx-1 : -1,
+        (cx < _xChunks-1) ? idx+_yChunks : -1,
+        (cy < _yChunks-1) ? idx+1 : -1,
+        (cx > 0) ? idx-_yChunks : -1 };
+    int key = level;
+    int side;
+    for (side=0; side<4; side++)
+    {
+        sideLevel[ side ] = level;
+        if ( (neighbor[ side ] >= 0) && (_chunks[ neighbor[ side ] ]._level > level) )
+            sideLevel[ side ] = _chunks[ neighbor[ side ] ]._level;
+        key |= sideLevel[ side ] << ( (side+1) * 4 );
+    }
+
+    IndexMap::const_iterator it = _indexMap.find( key );
+    if (it != _indexMap.end())
+        return *( it->second );
+
+    IndexArray* indices = new IndexArray;
+    buildChunkIndices( *indices, _chunkUnits, level, sideLevel );
+    _indexMap[ key ] = indices;
+    return *indices;
+}
+
+
+void
+HeightField::beginChunks()
+{
+    glPushClientAttrib( GL_CLIENT_VERTEX_ARRAY_BIT );
+
+    glEnableClientState( GL_VERTEX_ARRAY );
+    glEnableClientState( GL_NORMAL_ARRAY );
+    glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+}
+
+void
+HeightField::setPointers( int chunk )
+{
+    const GLsizei stride = INTERLEAVED_FLOATS * sizeof( GLfloat );
+    const GLfloat* base = _vertices + chunk * _vertsPerChunk * INTERLEAVED_FLOATS;
+
+    glVertexPointer( 3, GL_FLOAT, stride, base );
+    glNormalPointer( GL_FLOAT, stride, base + 3 );
+    glTexCoordPointer( 2, GL_FLOAT, stride, base + 6 );
+}
+
+void
+HeightField::endChunks()
+{
+    glPopClientAttrib();
+}
+
+
+int
+HeightField::gridX( int cx, int i ) const
+{
+    const int x = cx * _chunkUnits + i;
+    return( (x < _xUnits) ? x : _xUnits );
+}
+
+int
+HeightField::gridY( int cy, int j ) const
+{
+    const int y = cy * _chunkUnits + j;
+    return( (y < _yUnits) ? y : _yUnits );
+}
+
+float
+HeightField::getZ( int x, int y ) const
+{
+    return _zArray[ x * (_yUnits+1) + y ];
+}
+
+
+
+// Chunk-local vertex index of point (i,j).
+static inline GLuint
+localIndex( int i, int j, int chunkUnits )
+{
+    return( i * (chunkUnits+1) + j );
+}
+
+// Chunk-local vertex index of the point at distance 'a' along, and
+//   'b' in from, chunk side 'side' (0 through 3: -y, +x, +y, -x).
+//   Each side is a 90 degree rotation of the previous one, so that
+//   triangles with counterclockwise winding in (a,b) stay
+//   counterclockwise on every side.
+static inline GLuint
+sideIndex( int side, int a, int b, int chunkUnits )
+{
+    const int c = chunkUnits;
+    switch (side)
+    {
+    case 0: return localIndex( a, b, c );
+    case 1: return localIndex( c-b, a, c );
+    case 2: return localIndex( c-a, c-b, c );
+    default: return localIndex( b, c-a, c );
+    }
+}
+
+// Triangulates the strip between a chunk side, sampled every
+//   'sideStep' grid units, and the inner edge of the chunk's border
+//   ring, sampled every 'step' units, by zippering the two rows
+//   together. Returns the end of the written indices.
+static GLuint*
+stitchSide( GLuint* dest, int side, int chunkUnits, int step, int sideStep )
+{
+    const int numOuter = chunkUnits / sideStep + 1;
+    const int numInner = chunkUnits / step - 1;
+
+    int outer = 0, inner = 0;
+    while ( (outer < numOuter-1) || (inner < numInner-1) )
+    {
+        const int outerA = outer * sideStep;
+        const int innerA = (inner+1) * step;
+
+        // Advance along whichever row's next segment comes first.
+        bool advanceOuter;
+        if (inner == numInner-1)
+            advanceOuter = true;
+        else if (outer == numOuter-1)
+            advanceOuter = false;
+        else
+            advanceOuter = (outerA*2 + sideStep < innerA*2 + step);
+
+        const GLuint o = sideIndex( side, outerA, 0, chunkUnits );
+        const GLuint p = sideIndex( side, innerA, step, chunkUnits );
+        if (advanceOuter)
+        {
+            *dest++ = o;
+            *dest++ = sideIndex( side, outerA + sideStep, 0, chunkUnits );
+            *dest++ = p;
+            outer++;
+        }
+        else
+        {
+            *dest++ = o;
+            *dest++ = sideIndex( side, innerA + step, step, chunkUnits );
+            *dest++ = p;
+            inner++;
+        }
+    }
+
+    return dest;
+}
+
+void
+buildChunkIndices( IndexArray& indices, int chunkUnits, int level, const int* sideLevel )
+{
+    const int c = chunkUnits;
+    const int step = 1 << level;
+
+    if (step == c)
+    {
+        // A single quad.
+        GLuint* dest = indices.allocate( 6 );
+        *dest++ = localIndex( 0, 0, c );
+        *dest++ = localIndex( c, 0, c );
+        *dest++ = localIndex( 0, c, c );
+        *dest++ = localIndex( 0, c, c );
+        *dest++ = localIndex( c, 0, c );
+        *dest++ = localIndex( c, c, c );
+    }
+    else
+    {
+        // A regular grid of quads inside a ring one quad wide, with
+        //   each side of the ring stitched to its sampling.
+        const int numInterior = c / step - 2;
+        int count = numInterior * numInterior * 6;
+        int side;
+        for (side=0; side<4; side++)
+            count += ( (c >> sideLevel[ side ]) + (c / step) - 2 ) * 3;
+
+        GLuint* dest = indices.allocate( count );
+        int i, j;
+        for (i=step; i<c-step; i+=step)
+        {
+            for (j=step; j<c-step; j+=step)
+            {
+                const GLuint v0 = localIndex( i, j, c );
+                const GLuint v1 = localIndex( i+step, j, c );
+                const GLuint v2 = localIndex( i, j+step, c );
+                const GLuint v3 = localIndex( i+step, j+step, c );
+
+                *dest++ = v0;
+                *dest++ = v1;
+                *dest++ = v2;
+
+                *dest++ = v2;
+                *dest++ = v1;
+                *dest++ = v3;
+            }
+        }
+        for (side=0; side<4; side++)
+            dest = stitchSide( dest, side, c, step, 1 << sideLevel[ side ] );
+        assert( dest == indices.getUIntData() + count );
+
+        optimizeVertexCache( indices.getUIntData(), count, (c+1) * (c+1) );
+    }
+
+    indices.pack( (c+1) * (c+1) );
+}
+
+
+
+// Edge length of the square blocks convertHeightSamples() works in,
+//   so that both the sample rows it reads and the zArray columns it
+//   writes stay in cache.
+static const int CONVERT_BLOCK( 64 );
+
+void
+convertHeightSamples( float* zArray, const GLushort* samples, int xUnits, int yUnits )
+{
+    const int xSize = xUnits+1, ySize = yUnits+1;
+
+    // Network byte order is big-endian.
+    const GLushort one( 1 );
+    const bool swap = (*(const GLubyte*) &one == 1);
+
+    float block[ CONVERT_BLOCK ][ CONVERT_BLOCK ];
+    int bx, by;
+    for (by=0; by<ySize; by+=CONVERT_BLOCK)
+    {
+        const int yCount = (by + CONVERT_BLOCK < ySize) ? CONVERT_BLOCK : ySize - by;
+        for (bx=0; bx<xSize; bx+=CONVERT_BLOCK)
+        {
+            const int xCount = (bx + CONVERT_BLOCK < xSize) ? CONVERT_BLOCK : xSize - bx;
+
+            // Swap and convert each sample row of the block. These
+            //   loops are contiguous, so compilers vectorize them.
+            int i, j;
+            for (j=0; j<yCount; j++)
+            {
+                const GLushort* src = samples + (by+j) * xSize + bx;
+                float* dst = block[ j ];
+                if (swap)
+                {
+                    for (i=0; i<xCount; i++)
+                        dst[ i ] = (float)(GLushort)( (src[ i ] >> 8) | (src[ i ] << 8) );
+                }
+                else
+                {
+                    for (i=0; i<xCount; i++)
+                        dst[ i ] = (float) src[ i ];
+                }
+            }
+
+            // Transpose the block into zArray.
+            for (i=0; i<xCount; i++)
+            {
+                float* dst = zArray + (bx+i) * ySize + by;
+                for (j=0; j<yCount; j++)
+                    dst[ j ] = block[ j ][ i ];
+            }
+        }
+    }
+}
+
+
+
+#ifdef GL_VERSION_1_5
+
+
+HeightField15::HeightField15( float xLen, float yLen, int xUnits, int yUnits, const float* zArray, int chunkUnits )
+  : HeightField( xLen, yLen, xUnits, yUnits, zArray, chunkUnits ),
+    _vbo( 0 )
+{
+    assert( OGLDif::instance()->getVersion() >= Ver15 );
+}
+
+HeightField15::~HeightField15()
+{
+    cancelBuild();
+
+    if (_valid)
+        glDeleteBuffers( 1, &_vbo );
+}
+
+
+bool
+HeightField15::storeData()
+{
+    // All chunks share one buffer object. Indices, which depend on
+    //   the levels chosen each frame, stay in client memory.
+    glGenBuffers( 1, &_vbo );
+    glBindBuffer( GL_ARRAY_BUFFER, _vbo );
+    glBufferData( GL_ARRAY_BUFFER, _xChunks * _yChunks * _vertsPerChunk * INTERLEAVED_FLOATS * sizeof( GLfloat ),
+            _vertices, GL_STATIC_DRAW );
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+
+    OGLDIF_CHECK_ERROR;
+
+    return( _valid = true );
+}
+
+
+void
+HeightField15::beginChunks()
+{
+    glPushClientAttrib( GL_CLIENT_VERTEX_ARRAY_BIT );
+
+    glBindBuffer( GL_ARRAY_BUFFER, _vbo );
+
+    glEnableClientState( GL_VERTEX_ARRAY );
+    glEnableClientState( GL_NORMAL_ARRAY );
+
+    int tIdx;
+    for (tIdx=0; tIdx<_numTextures; tIdx++)
+    {
+        glClientActiveTexture( GL_TEXTURE0 + tIdx );
+        glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+    }
+}
+
+void
+HeightField15::setPointers( int chunk )
+{
+    const GLsizei stride = INTERLEAVED_FLOATS * sizeof( GLfloat );
+    const unsigned int base = chunk * _vertsPerChunk * INTERLEAVED_FLOATS * sizeof( GLfloat );
+
+    glVertexPointer( 3, GL_FLOAT, stride, bufferObjectPtr( base ) );
+    glNormalPointer( GL_FLOAT, stride, bufferObjectPtr( base + NORMAL_OFFSET ) );
+
+    int tIdx;
+    for (tIdx=0; tIdx<_numTextures; tIdx++)
+    {
+        glClientActiveTexture( GL_TEXTURE0 + tIdx );
+        glTexCoordPointer( 2, GL_FLOAT, stride, bufferObjectPtr( base + TEXCOORD_OFFSET ) );
+    }
+}
+
+void
+HeightField15::endChunks()
+{
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+    glPopClientAttrib();
+}
+
+
+#endif
+
+}
@@ -0,0 +1,36 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+// 
+
+#include "OGLDHostData.h"
+
+
+
+namespace ogld
+{
+
+
+static HostDataPolicy defaultPolicy( KeepHostData );
+
+void
+setDefaultHostDataPolicy( HostDataPolicy policy )
+{
+    defaultPolicy = policy;
+}
+
+HostDataPolicy
+getDefaultHostDataPolicy()
+{
+    return defaultPolicy;
+}
+
+
+}
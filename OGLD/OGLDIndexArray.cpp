@@ -0,0 +1,202 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+// 
+
+#include "OGLDPlatformGL.h"
+#include "OGLDif.h"
+#include "OGLDIndexArray.h"
+#include <assert.h>
+#include <string.h>
+
+
+
+namespace ogld
+{
+
+
+IndexArray::IndexArray()
+  : _data( NULL ),
+    _type( GL_UNSIGNED_INT ),
+    _count( 0 )
+{
+}
+
+IndexArray::~IndexArray()
+{
+    clear();
+}
+
+
+GLuint*
+IndexArray::allocate( int count )
+{
+    clear();
+
+    _count = count;
+    _type = GL_UNSIGNED_INT;
+    _data = new GLubyte[ count * sizeof( GLuint ) ];
+
+    return (GLuint*) _data;
+}
+
+void
+IndexArray::pack( int numVerts )
+{
+    if (_type != GL_UNSIGNED_INT)
+        // Already packed.
+        return;
+
+    const GLuint* src = (const GLuint*) _data;
+    int idx;
+
+    if (numVerts <= 256)
+    {
+        GLubyte* packed = new GLubyte[ _count ];
+        for (idx=0; idx<_count; idx++)
+        {
+            assert( src[idx] < 256 );
+            packed[idx] = (GLubyte) src[idx];
+        }
+        delete[] _data;
+        _data = packed;
+        _type = GL_UNSIGNED_BYTE;
+    }
+    else if (numVerts <= 65536)
+    {
+        GLubyte* packed = new GLubyte[ _count * sizeof( GLushort ) ];
+        GLushort* dest = (GLushort*) packed;
+        for (idx=0; idx<_count; idx++)
+        {
+            assert( src[idx] < 65536 );
+            dest[idx] = (GLushort) src[idx];
+        }
+        delete[] _data;
+        _data = packed;
+        _type = GL_UNSIGNED_SHORT;
+    }
+
+    // Otherwise, leave the indices as GL_UNSIGNED_INT.
+}
+
+void
+IndexArray::assign( const GLvoid* data, int count, GLenum type )
+{
+    clear();
+
+    _count = count;
+    _type = type;
+    _data = new GLubyte[ count * getTypeSize() ];
+    memcpy( _data, data, count * getTypeSize() );
+}
+
+void
+IndexArray::clear()
+{
+    if (_data)
+        delete[] _data;
+    _data = NULL;
+    _type = GL_UNSIGNED_INT;
+    _count = 0;
+}
+
+void
+IndexArray::releaseData()
+{
+    if (_data)
+        delete[] _data;
+    _data = NULL;
+}
+
+void
+IndexArray::swap( IndexArray& rhs )
+{
+    GLubyte* data = _data;
+    GLenum type = _type;
+    int count = _count;
+
+    _data = rhs._data;
+    _type = rhs._type;
+    _count = rhs._count;
+
+    rhs._data = data;
+    rhs._type = type;
+    rhs._count = count;
+}
+
+
+int
+IndexArray::getTypeSize() const
+{
+    switch (_type)
+    {
+    case GL_UNSIGNED_BYTE:
+        return sizeof( GLubyte );
+    case GL_UNSIGNED_SHORT:
+        return sizeof( GLushort );
+    case GL_UNSIGNED_INT:
+    default:
+        return sizeof( GLuint );
+    }
+}
+
+int
+IndexArray::getSizeBytes() const
+{
+    return _count * getTypeSize();
+}
+
+
+GLuint*
+IndexArray::getUIntData()
+{
+    assert( _type == GL_UNSIGNED_INT );
+    return (GLuint*) _data;
+}
+
+const GLuint*
+IndexArray::getUIntData() const
+{
+    assert( _type == GL_UNSIGNED_INT );
+    return (const GLuint*) _data;
+}
+
+GLuint
+IndexArray::get( int idx ) const
+{
+    assert( (idx >= 0) && (idx < _count) );
+
+    switch (_type)
+    {
+    case GL_UNSIGNED_BYTE:
+        return _data[ idx ];
+    case GL_UNSIGNED_SHORT:
+        return ((const GLushort*) _data)[ idx ];
+    case GL_UNSIGNED_INT:
+    default:
+        return ((const GLuint*) _data)[ idx ];
+    }
+}
+
+
+const GLvoid*
+IndexArray::address( int idx ) const
+{
+    return (const GLvoid*)( _data + idx * getTypeSize() );
+}
+
+GLvoid*
+IndexArray::offset( int idx ) const
+{
+    return bufferObjectPtr( idx * getTypeSize() );
+}
+
+
+}
@@ -0,0 +1,408 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+//
+
+#include "OGLDPlatformGL.h"
+#include "OGLDif.h"
+#include "OGLDInstanceBuffer.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <assert.h>
+#include <string.h>
+
+
+
+namespace ogld
+{
+
+
+std::map< unsigned int, InstanceBuffer::Program > InstanceBuffer::_programs;
+
+
+static const GLfloat identity[ InstanceBuffer::INSTANCE_FLOATS ] = {
+    1.f, 0.f, 0.f, 0.f,
+    0.f, 1.f, 0.f, 0.f,
+    0.f, 0.f, 1.f, 0.f,
+    0.f, 0.f, 0.f, 1.f,
+    1.f, 1.f, 1.f, 1.f };
+
+// Number of lights the shader evaluates.
+static const int NUM_LIGHTS( 8 );
+
+// Bits of the lighting state key. Each light uses three bits,
+//   starting at LIGHT_SHIFT.
+static const unsigned int LIGHTING_BIT( 0x1 );
+static const unsigned int COLOR_MATERIAL_BIT( 0x2 );
+static const unsigned int LOCAL_VIEWER_BIT( 0x4 );
+static const int LIGHT_SHIFT( 3 );
+static const unsigned int LIGHT_ENABLED_BIT( 0x1 );
+static const unsigned int LIGHT_POSITIONAL_BIT( 0x2 );
+static const unsigned int LIGHT_SPOT_BIT( 0x4 );
+
+
+// Writes a vertex shader for the lighting state 'key': the
+//   fixed-function transformation, with the instance matrix
+//   concatenated onto the model-view matrix, and the lighting
+//   equation for each enabled light, with the instance color in
+//   place of the current color.
+static std::string
+vertexSource( unsigned int key )
+{
+    std::ostringstream src;
+    src << "#version 120\n"
+        "attribute mat4 ogld_InstanceMatrix;\n"
+        "attribute vec4 ogld_InstanceColor;\n"
+        "\n"
+        "void main()\n"
+        "{\n"
+        "    vec4 eyePos = gl_ModelViewMatrix * (ogld_InstanceMatrix * gl_Vertex);\n"
+        "    gl_Position = gl_ProjectionMatrix * eyePos;\n"
+        "    gl_ClipVertex = eyePos;\n"
+        "    gl_FogFragCoord = abs( eyePos.z );\n"
+        "    gl_TexCoord[0] = gl_TextureMatrix[0] * gl_MultiTexCoord0;\n"
+        "    gl_TexCoord[1] = gl_TextureMatrix[1] * gl_MultiTexCoord1;\n";
+
+    if ( (key & LIGHTING_BIT) == 0 )
+    {
+        src << "    gl_FrontColor = ogld_InstanceColor;\n"
+            "}\n";
+        return src.str();
+    }
+
+    const char* ambient = (key & COLOR_MATERIAL_BIT) ? "ogld_InstanceColor" : "gl_FrontMaterial.ambient";
+    const char* diffuse = (key & COLOR_MATERIAL_BIT) ? "ogld_InstanceColor" : "gl_FrontMaterial.diffuse";
+
+    // Like gl_NormalMatrix, the instance matrix transforms normals by
+    //   its inverse transpose, here its cofactor matrix; normalizing
+    //   removes the determinant except for its sign.
+    src << "    mat3 instance = mat3( ogld_InstanceMatrix );\n"
+        "    vec3 cofactor0 = cross( instance[1], instance[2] );\n"
+        "    vec3 instanceNormal = cofactor0 * gl_Normal.x +\n"
+        "            cross( instance[2], instance[0] ) * gl_Normal.y +\n"
+        "            cross( instance[0], instance[1] ) * gl_Normal.z;\n"
+        "    if (dot( instance[0], cofactor0 ) < 0.)\n"
+        "        instanceNormal = -instanceNormal;\n"
+        "    vec3 normal = normalize( gl_NormalMatrix * instanceNormal );\n"
+        "    vec3 eye = " << ((key & LOCAL_VIEWER_BIT) ? "-normalize( eyePos.xyz )" : "vec3( 0., 0., 1. )") << ";\n"
+        "    vec4 ambient = " << ambient << ";\n"
+        "    vec4 diffuse = " << diffuse << ";\n"
+        "    vec4 color = gl_FrontMaterial.emission + ambient * gl_LightModel.ambient;\n"
+        "    vec3 toLight;\n"
+        "    float atten, nDotL;\n";
+
+    int idx;
+    for (idx=0; idx<NUM_LIGHTS; idx++)
+    {
+        const unsigned int light = key >> (LIGHT_SHIFT + idx*3);
+        if ( (light & LIGHT_ENABLED_BIT) == 0 )
+            continue;
+
+        std::ostringstream nameStream;
+        nameStream << "gl_LightSource[" << idx << "]";
+        const std::string name( nameStream.str() );
+
+        src << "\n";
+        if ( (light & LIGHT_POSITIONAL_BIT) == 0 )
+        {
+            src << "    toLight = normalize( " << name << ".position.xyz );\n"
+                "    atten = 1.;\n";
+        }
+        else
+        {
+            src << "    toLight = " << name << ".position.xyz / " << name << ".position.w - eyePos.xyz;\n"
+                "    atten = length( toLight );\n"
+                "    toLight /= atten;\n"
+                "    atten = 1. / (" << name << ".constantAttenuation + " <<
+                    name << ".linearAttenuation * atten + " <<
+                    name << ".quadraticAttenuation * atten * atten);\n";
+            if (light & LIGHT_SPOT_BIT)
+            {
+                src << "    {\n"
+                    "        float spot = dot( -toLight, normalize( " << name << ".spotDirection ) );\n"
+                    "        atten *= (spot < " << name << ".spotCosCutoff) ? 0. : pow( spot, " << name << ".spotExponent );\n"
+                    "    }\n";
+            }
+        }
+        src << "    nDotL = max( dot( normal, toLight ), 0. );\n"
+            "    color += atten * (ambient * " << name << ".ambient + nDotL * diffuse * " << name << ".diffuse);\n"
+            "    if (nDotL > 0.)\n"
+            "        color += atten * pow( max( dot( normal, normalize( toLight + eye ) ), 0. ), gl_FrontMaterial.shininess ) *\n"
+            "                gl_FrontMaterial.specular * " << name << ".specular;\n";
+    }
+
+    src << "\n"
+        "    gl_FrontColor = vec4( color.rgb, diffuse.a );\n"
+        "}\n";
+    return src.str();
+}
+
+
+
+InstanceBuffer::InstanceBuffer()
+  : _bound( NULL ),
+    _prevProgram( 0 ),
+    _vbo( 0 ),
+    _vboAllocated( false ),
+    _dirty( true )
+{
+}
+
+InstanceBuffer::~InstanceBuffer()
+{
+#ifdef GL_VERSION_1_5
+    if (_vboAllocated)
+        glDeleteBuffers( 1, &_vbo );
+#endif
+    _vboAllocated = false;
+}
+
+
+void
+InstanceBuffer::resize( int count )
+{
+    if (count < 0)
+        count = 0;
+
+    int idx = getCount();
+    _data.resize( count * INSTANCE_FLOATS );
+    for ( ; idx<count; idx++)
+        memcpy( &_data[ idx * INSTANCE_FLOATS ], identity, sizeof( identity ) );
+
+    _dirty = true;
+}
+
+int
+InstanceBuffer::getCount() const
+{
+    return( (int)_data.size() / INSTANCE_FLOATS );
+}
+
+void
+InstanceBuffer::set( int idx, const GLfloat* matrix, const GLfloat* color )
+{
+    setMatrix( idx, matrix );
+    setColor( idx, color );
+}
+
+void
+InstanceBuffer::setMatrix( int idx, const GLfloat* matrix )
+{
+    assert( (idx >= 0) && (idx < getCount()) );
+    memcpy( &_data[ idx * INSTANCE_FLOATS ], matrix, MATRIX_FLOATS * sizeof( GLfloat ) );
+    _dirty = true;
+}
+
+void
+InstanceBuffer::setColor( int idx, const GLfloat* color )
+{
+    assert( (idx >= 0) && (idx < getCount()) );
+    memcpy( &_data[ idx * INSTANCE_FLOATS + MATRIX_FLOATS ], color, COLOR_FLOATS * sizeof( GLfloat ) );
+    _dirty = true;
+}
+
+const GLfloat*
+InstanceBuffer::getMatrix( int idx ) const
+{
+    assert( (idx >= 0) && (idx < getCount()) );
+    return &_data[ idx * INSTANCE_FLOATS ];
+}
+
+const GLfloat*
+InstanceBuffer::getColor( int idx ) const
+{
+    assert( (idx >= 0) && (idx < getCount()) );
+    return &_data[ idx * INSTANCE_FLOATS + MATRIX_FLOATS ];
+}
+
+
+bool
+InstanceBuffer::bind()
+{
+#ifdef GL_VERSION_3_3
+    if ( _data.empty() || !OGLDif::instance()->isInstancingSupported() )
+        return false;
+
+    const Program& program = getProgram( getStateKey() );
+    if (program._program == 0)
+        return false;
+    _bound = &program;
+
+    if (!_vboAllocated)
+    {
+        glGenBuffers( 1, &_vbo );
+        _vboAllocated = true;
+        _dirty = true;
+    }
+
+    glBindBuffer( GL_ARRAY_BUFFER, _vbo );
+    if (_dirty)
+    {
+        glBufferData( GL_ARRAY_BUFFER, _data.size() * sizeof( GLfloat ), &_data[0], GL_STATIC_DRAW );
+        _dirty = false;
+    }
+
+    // A mat4 attribute occupies four consecutive locations, one
+    //   per column.
+    const GLsizei stride = INSTANCE_FLOATS * sizeof( GLfloat );
+    int col;
+    for (col=0; col<4; col++)
+    {
+        glEnableVertexAttribArray( program._matrixLoc + col );
+        glVertexAttribPointer( program._matrixLoc + col, 4, GL_FLOAT, GL_FALSE, stride,
+                bufferObjectPtr( col * 4 * sizeof( GLfloat ) ) );
+        glVertexAttribDivisor( program._matrixLoc + col, 1 );
+    }
+    glEnableVertexAttribArray( program._colorLoc );
+    glVertexAttribPointer( program._colorLoc, 4, GL_FLOAT, GL_FALSE, stride,
+            bufferObjectPtr( MATRIX_FLOATS * sizeof( GLfloat ) ) );
+    glVertexAttribDivisor( program._colorLoc, 1 );
+
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+    glGetIntegerv( GL_CURRENT_PROGRAM, &_prevProgram );
+    glUseProgram( program._program );
+
+
+    OGLDIF_CHECK_ERROR;
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+void
+InstanceBuffer::unbind()
+{
+#ifdef GL_VERSION_3_3
+    if (_bound == NULL)
+        return;
+
+    glUseProgram( _prevProgram );
+
+    // The divisor isn't reset by disabling the array, so restore
+    //   the default for whoever uses these locations next.
+    int col;
+    for (col=0; col<4; col++)
+    {
+        glVertexAttribDivisor( _bound->_matrixLoc + col, 0 );
+        glDisableVertexAttribArray( _bound->_matrixLoc + col );
+    }
+    glVertexAttribDivisor( _bound->_colorLoc, 0 );
+    glDisableVertexAttribArray( _bound->_colorLoc );
+
+    _bound = NULL;
+
+    OGLDIF_CHECK_ERROR;
+#endif
+}
+
+
+unsigned int
+InstanceBuffer::getStateKey()
+{
+    if (!glIsEnabled( GL_LIGHTING ))
+        return 0;
+
+    unsigned int key = LIGHTING_BIT;
+    if (glIsEnabled( GL_COLOR_MATERIAL ))
+        key |= COLOR_MATERIAL_BIT;
+
+    GLboolean localViewer;
+    glGetBooleanv( GL_LIGHT_MODEL_LOCAL_VIEWER, &localViewer );
+    if (localViewer)
+        key |= LOCAL_VIEWER_BIT;
+
+    int idx;
+    for (idx=0; idx<NUM_LIGHTS; idx++)
+    {
+        const GLenum light = GL_LIGHT0 + idx;
+        if (!glIsEnabled( light ))
+            continue;
+
+        unsigned int bits = LIGHT_ENABLED_BIT;
+        GLfloat position[ 4 ], cutoff;
+        glGetLightfv( light, GL_POSITION, position );
+        if (position[3] != 0.f)
+        {
+            bits |= LIGHT_POSITIONAL_BIT;
+            glGetLightfv( light, GL_SPOT_CUTOFF, &cutoff );
+            if (cutoff != 180.f)
+                bits |= LIGHT_SPOT_BIT;
+        }
+        key |= bits << (LIGHT_SHIFT + idx*3);
+    }
+
+    return key;
+}
+
+const InstanceBuffer::Program&
+InstanceBuffer::getProgram( unsigned int key )
+{
+    std::map< unsigned int, Program >::iterator it = _programs.find( key );
+    if (it != _programs.end())
+        return it->second;
+
+    Program& program = _programs[ key ];
+    program._program = 0;
+    program._matrixLoc = program._colorLoc = -1;
+
+#ifdef GL_VERSION_3_3
+    const std::string source( vertexSource( key ) );
+    const GLchar* sourcePtr = source.c_str();
+
+    GLuint shader = glCreateShader( GL_VERTEX_SHADER );
+    glShaderSource( shader, 1, &sourcePtr, NULL );
+    glCompileShader( shader );
+
+    GLint status;
+    glGetShaderiv( shader, GL_COMPILE_STATUS, &status );
+    if (status != GL_TRUE)
+    {
+        GLchar log[ 1024 ];
+        glGetShaderInfoLog( shader, sizeof( log ), NULL, log );
+        std::cerr << "InstanceBuffer: shader compile failed: " << log << std::endl;
+        glDeleteShader( shader );
+        return program;
+    }
+
+    GLuint handle = glCreateProgram();
+    glAttachShader( handle, shader );
+    glLinkProgram( handle );
+    // The program keeps the shader until it's deleted.
+    glDeleteShader( shader );
+
+    glGetProgramiv( handle, GL_LINK_STATUS, &status );
+    if (status == GL_TRUE)
+    {
+        program._matrixLoc = glGetAttribLocation( handle, "ogld_InstanceMatrix" );
+        program._colorLoc = glGetAttribLocation( handle, "ogld_InstanceColor" );
+    }
+    if ( (status != GL_TRUE) || (program._matrixLoc < 0) || (program._colorLoc < 0) )
+    {
+        GLchar log[ 1024 ];
+        glGetProgramInfoLog( handle, sizeof( log ), NULL, log );
+        std::cerr << "InstanceBuffer: shader link failed: " << log << std::endl;
+        glDeleteProgram( handle );
+        return program;
+    }
+
+    program._program = handle;
+
+    OGLDIF_CHECK_ERROR;
+#endif
+
+    return program;
+}
+
+
+}
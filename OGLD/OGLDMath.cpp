@@ -11,7 +11,9 @@
 // 
 
 #include "OGLDMath.h"
+#include "OGLDThread.h"
 #include <math.h>
+#include <map>
 
 
 
@@ -59,6 +61,41 @@ matrixTranspose( double m[16] )
 }
 
 
+//
+// sinCosTable
+//
+// Shared by Torus and Cylinder, which would otherwise call cos() and
+//   sin() for every ring and slice of every instance. Locked, because
+//   the BuildThread tessellates too. File scope, so that both are
+//   constructed before any thread calls sinCosTable().
+typedef std::map< int, float* > SinCosTableMap;
+static SinCosTableMap sinCosTables;
+static Mutex sinCosMutex;
+
+const float* sinCosTable( int n )
+{
+    ScopedLock lock( sinCosMutex );
+
+    SinCosTableMap::const_iterator it = sinCosTables.find( n );
+    if (it != sinCosTables.end())
+        return it->second;
+
+    float* table = new float[ (n+1) * 2 ];
+    const double delta = _2PI / n;
+    int idx;
+    for (idx=0; idx<n; idx++)
+    {
+        table[ idx*2 ] = (float) cos( idx * delta );
+        table[ idx*2+1 ] = (float) sin( idx * delta );
+    }
+    table[ n*2 ] = 1.f;
+    table[ n*2+1 ] = 0.f;
+
+    sinCosTables[ n ] = table;
+    return table;
+}
+
+
 Vec3d::Vec3d()
 {
     _v[0] = _v[1] = _v[2] = 0.f;
@@ -0,0 +1,501 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+// 
+
+
+#include "OGLDPlatformGL.h"
+#include "OGLDMeshCache.h"
+#include "OGLDIndexArray.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+// File mapping differs by platform
+#if defined( WIN32 ) && !defined( __CYGWIN__ )
+  #include <windows.h>
+#else
+  #include <sys/types.h>
+  #include <sys/stat.h>
+  #include <sys/mman.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+#endif
+
+
+
+namespace ogld
+{
+
+
+//
+// Cache file layout. Values are native unsigned ints; the files
+//   aren't meant to move between hosts.
+//
+//   "OGLDMESH", FORMAT_VERSION, BYTE_ORDER_MARK, key length, number
+//     of streams;
+//   the key, padded to a multiple of four bytes;
+//   for each stream: type, count, and file offset;
+//   the streams, each aligned to STREAM_ALIGN bytes.
+//
+static const char FILE_MAGIC[ 8 ] = { 'O', 'G', 'L', 'D', 'M', 'E', 'S', 'H' };
+static const unsigned int FORMAT_VERSION( 1 );
+static const unsigned int BYTE_ORDER_MARK( 0x01020304 );
+static const size_t HEADER_SIZE( 8 + 4*4 );
+static const size_t TABLE_ENTRY_SIZE( 3*4 );
+static const size_t STREAM_ALIGN( 16 );
+
+// Stream type for int arrays; the others are OpenGL type enums.
+static const GLenum INT_STREAM( 0 );
+
+
+static int
+typeSize( GLenum type )
+{
+    switch (type)
+    {
+    case GL_UNSIGNED_BYTE:
+        return sizeof( GLubyte );
+    case GL_UNSIGNED_SHORT:
+        return sizeof( GLushort );
+    case GL_UNSIGNED_INT:
+        return sizeof( GLuint );
+    case GL_FLOAT:
+        return sizeof( GLfloat );
+    case INT_STREAM:
+    default:
+        return sizeof( int );
+    }
+}
+
+static unsigned int
+getUInt( const GLubyte* ptr )
+{
+    unsigned int value;
+    memcpy( &value, ptr, sizeof( value ) );
+    return value;
+}
+
+static size_t
+alignUp( size_t offset, size_t align )
+{
+    return( (offset + align - 1) / align * align );
+}
+
+
+
+MeshCacheWriter::MeshCacheWriter()
+{
+}
+
+void
+MeshCacheWriter::addInts( const int* values, int count )
+{
+    Stream stream;
+    stream._type = INT_STREAM;
+    stream._count = count;
+    stream._data = NULL;
+    _streams.push_back( stream );
+
+    const GLubyte* bytes = (const GLubyte*) values;
+    _streams.back()._copy.assign( bytes, bytes + count * sizeof( int ) );
+}
+
+void
+MeshCacheWriter::addFloats( const GLfloat* data, int count, bool copy )
+{
+    Stream stream;
+    stream._type = GL_FLOAT;
+    stream._count = count;
+    stream._data = copy ? NULL : data;
+    _streams.push_back( stream );
+
+    if (copy)
+    {
+        const GLubyte* bytes = (const GLubyte*) data;
+        _streams.back()._copy.assign( bytes, bytes + count * sizeof( GLfloat ) );
+    }
+}
+
+void
+MeshCacheWriter::addIndices( const IndexArray& indices )
+{
+    Stream stream;
+    stream._type = indices.getType();
+    stream._count = indices.getCount();
+    stream._data = indices.getData();
+    _streams.push_back( stream );
+}
+
+
+
+MeshCacheEntry::MeshCacheEntry( const GLubyte* data, size_t size )
+  : _data( data ),
+    _size( size ),
+    _numStreams( 0 ),
+    _stream( 0 ),
+    _table( NULL )
+{
+}
+
+MeshCacheEntry::~MeshCacheEntry()
+{
+#if defined( WIN32 ) && !defined( __CYGWIN__ )
+    UnmapViewOfFile( _data );
+#else
+    munmap( (void*) _data, _size );
+#endif
+}
+
+
+const GLubyte*
+MeshCacheEntry::next( GLenum type, int count, int& actualCount )
+{
+    if (_stream >= _numStreams)
+        return NULL;
+
+    const GLubyte* entry = _table + _stream * TABLE_ENTRY_SIZE;
+    const GLenum streamType = getUInt( entry );
+    actualCount = (int) getUInt( entry + 4 );
+    const size_t offset = getUInt( entry + 8 );
+
+    // Index streams may be in any packed type.
+    const bool typeOK = (type == GL_UNSIGNED_INT) ?
+            ( (streamType == GL_UNSIGNED_BYTE) || (streamType == GL_UNSIGNED_SHORT) ||
+                (streamType == GL_UNSIGNED_INT) ) :
+            (streamType == type);
+    if ( !typeOK || (actualCount < 0) || ( (count >= 0) && (actualCount != count) ) )
+        return NULL;
+    if ( (offset > _size) || ((_size - offset) / typeSize( streamType ) < (size_t) actualCount) )
+        return NULL;
+
+    _stream++;
+    return( _data + offset );
+}
+
+bool
+MeshCacheEntry::getInts( int* values, int count )
+{
+    int actualCount;
+    const GLubyte* data = next( INT_STREAM, count, actualCount );
+    if (data == NULL)
+        return false;
+
+    memcpy( values, data, count * sizeof( int ) );
+    return true;
+}
+
+const GLfloat*
+MeshCacheEntry::getFloats( int count )
+{
+    int actualCount;
+    return (const GLfloat*) next( GL_FLOAT, count, actualCount );
+}
+
+bool
+MeshCacheEntry::getIndices( IndexArray& indices )
+{
+    // Peek at the packed type before next() advances.
+    if (_stream >= _numStreams)
+        return false;
+    const GLenum type = getUInt( _table + _stream * TABLE_ENTRY_SIZE );
+
+    int count;
+    const GLubyte* data = next( GL_UNSIGNED_INT, -1, count );
+    if (data == NULL)
+        return false;
+
+    indices.assign( data, count, type );
+    return true;
+}
+
+
+
+// Created at startup, since Shapes on the BuildThread use it too.
+MeshCache* MeshCache::_instance = new MeshCache;
+
+MeshCache*
+MeshCache::instance()
+{
+    return _instance;
+}
+
+MeshCache::MeshCache()
+  : _hits( 0 ),
+    _misses( 0 ),
+    _stale( 0 ),
+    _stores( 0 ),
+    _tempCount( 0 )
+{
+}
+
+
+void
+MeshCache::setDirectory( const std::string& directory )
+{
+    _directory = directory;
+    if (_directory.empty())
+        return;
+
+    const char last = _directory[ _directory.size()-1 ];
+    if ( (last != '/') && (last != '\\') )
+        _directory += '/';
+}
+
+const std::string&
+MeshCache::getDirectory() const
+{
+    return _directory;
+}
+
+bool
+MeshCache::getEnabled() const
+{
+    return !_directory.empty();
+}
+
+
+MeshCacheEntry*
+MeshCache::load( const std::string& key )
+{
+    if (!getEnabled())
+        return NULL;
+
+    const std::string fileName = getFileName( key );
+
+    const GLubyte* data = NULL;
+    size_t size = 0;
+#if defined( WIN32 ) && !defined( __CYGWIN__ )
+    HANDLE file = CreateFile( fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+    if (file != INVALID_HANDLE_VALUE)
+    {
+        size = GetFileSize( file, NULL );
+        // The view keeps the mapping open once its handles close.
+        HANDLE mapping = (size > 0) ? CreateFileMapping( file, NULL, PAGE_READONLY, 0, 0, NULL ) : NULL;
+        if (mapping != NULL)
+        {
+            data = (const GLubyte*) MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+            CloseHandle( mapping );
+        }
+        CloseHandle( file );
+    }
+#else
+    int fd = open( fileName.c_str(), O_RDONLY );
+    if (fd >= 0)
+    {
+        struct stat st;
+        if ( (fstat( fd, &st ) == 0) && (st.st_size > 0) )
+        {
+            size = (size_t) st.st_size;
+            void* addr = mmap( NULL, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+            if (addr != MAP_FAILED)
+                data = (const GLubyte*) addr;
+        }
+        close( fd );
+    }
+#endif
+
+    if (data == NULL)
+    {
+        ScopedLock lock( _mutex );
+        _misses++;
+        return NULL;
+    }
+
+    MeshCacheEntry* entry = new MeshCacheEntry( data, size );
+
+    // Check the header, key, and stream table. load() leaves checking
+    //   each stream's type, count, and extent to the get functions.
+    bool valid = (size >= HEADER_SIZE) &&
+            (memcmp( data, FILE_MAGIC, sizeof( FILE_MAGIC ) ) == 0) &&
+            (getUInt( data + 8 ) == FORMAT_VERSION) &&
+            (getUInt( data + 12 ) == BYTE_ORDER_MARK);
+    if (valid)
+    {
+        const size_t keyLength = getUInt( data + 16 );
+        const size_t numStreams = getUInt( data + 20 );
+        const size_t tableOffset = HEADER_SIZE + alignUp( keyLength, 4 );
+        valid = (keyLength == key.size()) &&
+                (tableOffset <= size) &&
+                ((size - tableOffset) / TABLE_ENTRY_SIZE >= numStreams) &&
+                (memcmp( data + HEADER_SIZE, key.data(), keyLength ) == 0);
+        entry->_numStreams = (int) numStreams;
+        entry->_table = data + tableOffset;
+    }
+
+    if (!valid)
+    {
+        delete entry;
+        discard( key );
+        return NULL;
+    }
+
+    ScopedLock lock( _mutex );
+    _hits++;
+    return entry;
+}
+
+
+bool
+MeshCache::store( const std::string& key, const MeshCacheWriter& writer )
+{
+    if (!getEnabled())
+        return false;
+
+    const std::vector< MeshCacheWriter::Stream >& streams = writer._streams;
+    const size_t numStreams = streams.size();
+
+    // Lay out the file, and assemble everything but the streams.
+    const size_t tableOffset = HEADER_SIZE + alignUp( key.size(), 4 );
+    const size_t headSize = tableOffset + numStreams * TABLE_ENTRY_SIZE;
+    std::vector< GLubyte > head( headSize, 0 );
+
+    unsigned int header[ 4 ] = { FORMAT_VERSION, BYTE_ORDER_MARK,
+            (unsigned int) key.size(), (unsigned int) numStreams };
+    memcpy( &head[ 0 ], FILE_MAGIC, sizeof( FILE_MAGIC ) );
+    memcpy( &head[ sizeof( FILE_MAGIC ) ], header, sizeof( header ) );
+    if (!key.empty())
+        memcpy( &head[ HEADER_SIZE ], key.data(), key.size() );
+
+    size_t offset = headSize;
+    size_t idx;
+    for (idx=0; idx<numStreams; idx++)
+    {
+        offset = alignUp( offset, STREAM_ALIGN );
+        unsigned int entry[ 3 ] = { streams[ idx ]._type, (unsigned int) streams[ idx ]._count,
+                (unsigned int) offset };
+        memcpy( &head[ tableOffset + idx * TABLE_ENTRY_SIZE ], entry, sizeof( entry ) );
+        offset += streams[ idx ]._count * typeSize( streams[ idx ]._type );
+    }
+
+    // Write a temporary file and rename it, so that load() never sees
+    //   a partly written entry. The name is unique to this writer, as
+    //   other threads and processes may store the same key at once.
+    unsigned int tempCount;
+    {
+        ScopedLock lock( _mutex );
+        tempCount = _tempCount++;
+    }
+#if defined( WIN32 ) && !defined( __CYGWIN__ )
+    const unsigned long pid = GetCurrentProcessId();
+#else
+    const unsigned long pid = (unsigned long) getpid();
+#endif
+    char suffix[ 64 ];
+    sprintf( suffix, ".%lu.%u.tmp", pid, tempCount );
+    const std::string fileName = getFileName( key );
+    const std::string tempName = fileName + suffix;
+    FILE* f = fopen( tempName.c_str(), "wb" );
+    if (f == NULL)
+        return false;
+
+    static const GLubyte padding[ STREAM_ALIGN ] = { 0 };
+    bool result = (fwrite( &head[ 0 ], headSize, 1, f ) == 1);
+    offset = headSize;
+    for (idx=0; result && (idx<numStreams); idx++)
+    {
+        const MeshCacheWriter::Stream& stream = streams[ idx ];
+        const size_t pad = alignUp( offset, STREAM_ALIGN ) - offset;
+        if (pad > 0)
+            result = (fwrite( padding, pad, 1, f ) == 1);
+        offset += pad;
+
+        const size_t size = stream._count * typeSize( stream._type );
+        const GLvoid* data = stream._copy.empty() ? stream._data : &stream._copy[ 0 ];
+        if ( result && (size > 0) )
+            result = (fwrite( data, size, 1, f ) == 1);
+        offset += size;
+    }
+    if (fclose( f ) != 0)
+        result = false;
+
+    if (result)
+    {
+        // rename() doesn't replace existing files on every platform.
+        remove( fileName.c_str() );
+        result = (rename( tempName.c_str(), fileName.c_str() ) == 0);
+    }
+    if (!result)
+    {
+        remove( tempName.c_str() );
+        return false;
+    }
+
+    ScopedLock lock( _mutex );
+    _stores++;
+    return true;
+}
+
+void
+MeshCache::discard( const std::string& key )
+{
+    if (!getEnabled())
+        return;
+
+    remove( getFileName( key ).c_str() );
+
+    ScopedLock lock( _mutex );
+    _stale++;
+}
+
+
+void
+MeshCache::getStatistics( int& hits, int& misses, int& stale, int& stores )
+{
+    ScopedLock lock( _mutex );
+    hits = _hits;
+    misses = _misses;
+    stale = _stale;
+    stores = _stores;
+}
+
+
+std::string
+MeshCache::hash( const void* data, size_t size )
+{
+    // Two independent 32-bit multiplicative hashes over 32-bit words:
+    //   FNV-1a, and a MurmurHash2 style mix.
+    const GLubyte* ptr = (const GLubyte*) data;
+    unsigned int h1 = 2166136261u;
+    unsigned int h2 = 0x9747b28cu ^ (unsigned int) size;
+
+    size_t idx;
+    for (idx=0; idx+4<=size; idx+=4)
+    {
+        unsigned int word;
+        memcpy( &word, ptr + idx, sizeof( word ) );
+        h1 = (h1 ^ word) * 16777619u;
+        word *= 0x5bd1e995u;
+        word ^= word >> 24;
+        h2 = (h2 * 0x5bd1e995u) ^ (word * 0x5bd1e995u);
+    }
+    for (; idx<size; idx++)
+    {
+        h1 = (h1 ^ ptr[ idx ]) * 16777619u;
+        h2 = (h2 ^ ptr[ idx ]) * 0x5bd1e995u;
+    }
+    h2 ^= h2 >> 13;
+    h2 *= 0x5bd1e995u;
+    h2 ^= h2 >> 15;
+
+    char buf[ 17 ];
+    sprintf( buf, "%08x%08x", h1, h2 );
+    return std::string( buf );
+}
+
+std::string
+MeshCache::getFileName( const std::string& key ) const
+{
+    return( _directory + hash( key.data(), key.size() ) + ".ogldmesh" );
+}
+
+
+}
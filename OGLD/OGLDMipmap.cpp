@@ -0,0 +1,396 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+//
+
+
+#include "OGLDPlatformGL.h"
+#include "OGLDPlatformGLU.h"
+#include "OGLDif.h"
+#include "OGLDMipmap.h"
+#include "OGLDThread.h"
+#include <vector>
+#include <string.h>
+#include <assert.h>
+
+
+
+namespace ogld
+{
+
+
+// Levels are filtered in parallel in groups of at least this many
+//   source bytes, so that each thread has enough work to pay for
+//   starting it.
+static const int PARALLEL_GRAIN_BYTES( 64 * 1024 );
+
+
+int
+imageComponents( GLenum format )
+{
+    switch (format)
+    {
+    case GL_RGBA:
+#ifdef GL_BGRA
+    case GL_BGRA:
+#endif
+        return 4;
+    case GL_RGB:
+#ifdef GL_BGR
+    case GL_BGR:
+#endif
+        return 3;
+    case GL_LUMINANCE_ALPHA:
+        return 2;
+    case GL_LUMINANCE:
+    case GL_ALPHA:
+    case GL_RED:
+    case GL_GREEN:
+    case GL_BLUE:
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+
+// The box filter for RGBA and luminance works a word at a time: the
+//   even and odd bytes of a word are summed separately, in 16-bit
+//   lanes, so that four bytes are filtered with a few integer
+//   operations. It needs neither intrinsics nor a vectorizing
+//   compiler, and it doesn't depend on byte order.
+static const GLuint LANE_MASK( 0x00ff00ff );
+
+static inline GLuint
+loadWord( const GLubyte* src )
+{
+    GLuint word;
+    memcpy( &word, src, 4 );
+    return word;
+}
+
+// 'step' is the offset from each source pixel to the one it's
+//   averaged with: one pixel, or 0 if the source is one pixel wide.
+static void
+boxRowRGBA( const GLubyte* a, const GLubyte* b, GLubyte* dst, int width, int step )
+{
+    int x;
+    for (x=0; x<width; x++, a+=8, b+=8, dst+=4)
+    {
+        const GLuint a0 = loadWord( a ), a1 = loadWord( a+step );
+        const GLuint b0 = loadWord( b ), b1 = loadWord( b+step );
+        const GLuint even = (a0 & LANE_MASK) + (a1 & LANE_MASK) +
+                (b0 & LANE_MASK) + (b1 & LANE_MASK) + 0x00020002;
+        const GLuint odd = ((a0 >> 8) & LANE_MASK) + ((a1 >> 8) & LANE_MASK) +
+                ((b0 >> 8) & LANE_MASK) + ((b1 >> 8) & LANE_MASK) + 0x00020002;
+        const GLuint pixel = ((even >> 2) & LANE_MASK) | (((odd >> 2) & LANE_MASK) << 8);
+        memcpy( dst, &pixel, 4 );
+    }
+}
+
+// Two destination pixels from each word of both rows.
+static void
+boxRowL8( const GLubyte* a, const GLubyte* b, GLubyte* dst, int width )
+{
+    int x;
+    for (x=0; x+1<width; x+=2, a+=4, b+=4, dst+=2)
+    {
+        const GLuint wa = loadWord( a );
+        const GLuint wb = loadWord( b );
+        const GLuint sums = ( (wa & LANE_MASK) + ((wa >> 8) & LANE_MASK) +
+                (wb & LANE_MASK) + ((wb >> 8) & LANE_MASK) + 0x00020002 ) >> 2;
+        const GLushort pair = (GLushort)( (sums & 0xff) | ((sums >> 8) & 0xff00) );
+        memcpy( dst, &pair, 2 );
+    }
+    if (x < width)
+        *dst = (GLubyte)( (a[0] + a[1] + b[0] + b[1] + 2) >> 2 );
+}
+
+// The callers pass 'n' as a constant, so that once these are inlined
+//   the compiler can unroll the component loop.
+static inline void
+boxRow( const GLubyte* a, const GLubyte* b, GLubyte* dst, int width, int step, int n )
+{
+    int x;
+    for (x=0; x<width; x++, a+=2*n, b+=2*n, dst+=n)
+    {
+        int c;
+        for (c=0; c<n; c++)
+            dst[ c ] = (GLubyte)( (a[ c ] + a[ c+step ] + b[ c ] + b[ c+step ] + 2) >> 2 );
+    }
+}
+
+// The horizontal half of the tent filter. 'sums' holds the weighted
+//   vertical sums of a source row, with one replicated edge pixel
+//   before it and two after it.
+static inline void
+tentRow( const GLushort* sums, GLubyte* dst, int width, int n )
+{
+    int x;
+    for (x=0; x<width; x++, sums+=2*n, dst+=n)
+    {
+        int c;
+        for (c=0; c<n; c++)
+            dst[ c ] = (GLubyte)( (sums[ c-n ] + 3 * (sums[ c ] + sums[ c+n ]) +
+                    sums[ c+2*n ] + 32) >> 6 );
+    }
+}
+
+
+// Filters a range of rows of one level from the level above it.
+class ReduceTask : public RangeTask
+{
+public:
+    ReduceTask( const GLubyte* src, GLsizei srcWidth, GLsizei srcHeight,
+            GLubyte* dst, GLsizei dstWidth, int components, MipmapFilter filter )
+      : _src( src ), _srcWidth( srcWidth ), _srcHeight( srcHeight ),
+        _dst( dst ), _dstWidth( dstWidth ), _n( components ), _filter( filter ) {}
+
+    virtual void run( int begin, int end )
+    {
+        if (_filter == BoxFilter)
+            box( begin, end );
+        else
+            tent( begin, end );
+    }
+
+protected:
+    void box( int begin, int end )
+    {
+        const int n( _n );
+        const int step = (_srcWidth > 1) ? n : 0;
+
+        int y;
+        for (y=begin; y<end; y++)
+        {
+            const GLubyte* a = row( 2*y );
+            const GLubyte* b = row( 2*y+1 );
+            GLubyte* dst = _dst + y * _dstWidth * n;
+
+            if (n == 4)
+                boxRowRGBA( a, b, dst, _dstWidth, step );
+            else if ( (n == 1) && (step != 0) )
+                boxRowL8( a, b, dst, _dstWidth );
+            else if (n == 3)
+                boxRow( a, b, dst, _dstWidth, step, 3 );
+            else if (n == 2)
+                boxRow( a, b, dst, _dstWidth, step, 2 );
+            else
+                boxRow( a, b, dst, _dstWidth, step, 1 );
+        }
+    }
+
+    void tent( int begin, int end )
+    {
+        const int n( _n );
+        const int rowBytes( _srcWidth * n );
+        std::vector< GLushort > buffer( (_srcWidth + 3) * n );
+        GLushort* sums = &buffer[ n ];
+
+        int y;
+        for (y=begin; y<end; y++)
+        {
+            // Vertical pass, 1-3-3-1.
+            const GLubyte* a = row( 2*y-1 );
+            const GLubyte* b = row( 2*y );
+            const GLubyte* c = row( 2*y+1 );
+            const GLubyte* d = row( 2*y+2 );
+            int k;
+            for (k=0; k<rowBytes; k++)
+                sums[ k ] = (GLushort)( a[ k ] + 3 * (b[ k ] + c[ k ]) + d[ k ] );
+
+            // Replicate the edge pixels.
+            for (k=0; k<n; k++)
+            {
+                sums[ k-n ] = sums[ k ];
+                sums[ rowBytes+k ] = sums[ rowBytes+k+n ] = sums[ rowBytes-n+k ];
+            }
+
+            GLubyte* dst = _dst + y * _dstWidth * n;
+            switch (n)
+            {
+            case 4: tentRow( sums, dst, _dstWidth, 4 ); break;
+            case 3: tentRow( sums, dst, _dstWidth, 3 ); break;
+            case 2: tentRow( sums, dst, _dstWidth, 2 ); break;
+            default: tentRow( sums, dst, _dstWidth, 1 ); break;
+            }
+        }
+    }
+
+    // Source row 'y', clamped to the image.
+    const GLubyte* row( int y ) const
+    {
+        if (y < 0)
+            y = 0;
+        else if (y >= _srcHeight)
+            y = _srcHeight-1;
+        return( _src + y * _srcWidth * _n );
+    }
+
+    const GLubyte* _src;
+    GLsizei _srcWidth, _srcHeight;
+    GLubyte* _dst;
+    GLsizei _dstWidth;
+    int _n;
+    MipmapFilter _filter;
+};
+
+
+
+MipmapChain::MipmapChain()
+  : _format( GL_RGBA ),
+    _type( GL_UNSIGNED_BYTE )
+{
+}
+
+MipmapChain::~MipmapChain()
+{
+}
+
+
+bool
+MipmapChain::isSupported( GLenum format, GLenum type )
+{
+    return( (type == GL_UNSIGNED_BYTE) && (imageComponents( format ) > 0) );
+}
+
+bool
+MipmapChain::build( const GLvoid* pixels, GLsizei width, GLsizei height,
+        GLenum format, GLenum type, MipmapFilter filter )
+{
+    _levels.clear();
+    _data.clear();
+    if ( !isSupported( format, type ) || (pixels == NULL) )
+        return false;
+
+    _format = format;
+    _type = type;
+    const int n = imageComponents( format );
+
+    unsigned int size( 0 );
+    GLsizei w( width ), h( height );
+    while ( (w > 1) || (h > 1) )
+    {
+        Level level;
+        level._width = w = (w > 1) ? w/2 : 1;
+        level._height = h = (h > 1) ? h/2 : 1;
+        level._offset = size;
+        _levels.push_back( level );
+
+        size += w * h * n;
+    }
+    if (_levels.empty())
+        return true;
+    _data.resize( size );
+
+    const GLubyte* src = (const GLubyte*) pixels;
+    GLsizei srcWidth( width ), srcHeight( height );
+    unsigned int idx;
+    for (idx=0; idx<_levels.size(); idx++)
+    {
+        const Level& level = _levels[ idx ];
+        GLubyte* dst = &_data[ level._offset ];
+
+        ReduceTask task( src, srcWidth, srcHeight, dst, level._width, n, filter );
+        parallelFor( task, level._height,
+                PARALLEL_GRAIN_BYTES / (2 * srcWidth * n) + 1 );
+
+        src = dst;
+        srcWidth = level._width;
+        srcHeight = level._height;
+    }
+
+    return true;
+}
+
+
+int
+MipmapChain::getNumLevels() const
+{
+    return (int) _levels.size();
+}
+
+void
+MipmapChain::getLevelSize( int level, GLsizei& width, GLsizei& height ) const
+{
+    assert( (level >= 1) && (level <= getNumLevels()) );
+    width = _levels[ level-1 ]._width;
+    height = _levels[ level-1 ]._height;
+}
+
+const GLubyte*
+MipmapChain::getLevel( int level ) const
+{
+    assert( (level >= 1) && (level <= getNumLevels()) );
+    return( &_data[ _levels[ level-1 ]._offset ] );
+}
+
+const GLubyte*
+MipmapChain::getData() const
+{
+    if (_data.empty())
+        return NULL;
+    return( &_data[ 0 ] );
+}
+
+unsigned int
+MipmapChain::getDataSize() const
+{
+    return (unsigned int) _data.size();
+}
+
+
+void
+MipmapChain::texImage( GLenum target, GLint internalFormat, const GLvoid* data ) const
+{
+    if (_levels.empty())
+        return;
+    if (data == NULL)
+        data = getData();
+
+    // The levels are tightly packed.
+    GLint alignment;
+    glGetIntegerv( GL_UNPACK_ALIGNMENT, &alignment );
+    glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+
+    unsigned int idx;
+    for (idx=0; idx<_levels.size(); idx++)
+    {
+        const Level& level = _levels[ idx ];
+        glTexImage2D( target, idx+1, internalFormat, level._width, level._height,
+                0, _format, _type, (const GLubyte*) data + level._offset );
+    }
+
+    glPixelStorei( GL_UNPACK_ALIGNMENT, alignment );
+
+    OGLDIF_CHECK_ERROR;
+}
+
+
+
+void
+buildMipmaps( GLenum target, GLint internalFormat, GLsizei width, GLsizei height,
+        GLenum format, GLenum type, const GLvoid* pixels, MipmapFilter filter )
+{
+    MipmapChain chain;
+    if (!chain.build( pixels, width, height, format, type, filter ))
+    {
+        gluBuild2DMipmaps( target, internalFormat, width, height,
+                format, type, pixels );
+        return;
+    }
+
+    glTexImage2D( target, 0, internalFormat, width, height,
+            0, format, type, pixels );
+    chain.texImage( target, internalFormat );
+}
+
+
+}
@@ -14,6 +14,8 @@
 #include "OGLDif.h"
 #include "OGLDPixels.h"
 #include "OGLDPixelBuffer.h"
+#include "OGLDResample.h"
+#include "OGLDThread.h"
 #include "tiffio.h"
 #include <string>
 #include <string.h>
@@ -76,78 +78,317 @@ Pixels::unload()
     _valid = false;
 }
 
+// Expands 'n' pixels of 'samples' 8-bit samples each to RGBA. Gray
+//   images have one sample, or two with alpha; RGB images have three,
+//   or four or more with alpha.
 static void
-copyRow( unsigned char* ptr, unsigned char* data, int n, int numSamples )
+expandRow( unsigned char* dst, const unsigned char* src, int n, int samples, bool gray )
 {
-    while (n--)
+    // The word-at-a-time loops below assume little-endian byte order.
+    const GLushort one( 1 );
+    const bool littleEndian = (*(const GLubyte*) &one == 1);
+
+    int idx( 0 );
+    if (gray && (samples == 1))
+    {
+        if (littleEndian)
+        {
+            for (; idx<n; idx++)
+            {
+                const GLuint rgba = src[ idx ] * 0x00010101u | 0xff000000u;
+                memcpy( dst + idx*4, &rgba, 4 );
+            }
+        }
+        for (; idx<n; idx++)
+        {
+            dst[ idx*4 ] = dst[ idx*4+1 ] = dst[ idx*4+2 ] = src[ idx ];
+            dst[ idx*4+3 ] = 255;
+        }
+    }
+    else if (gray)
+    {
+        for (; idx<n; idx++)
+        {
+            dst[ idx*4 ] = dst[ idx*4+1 ] = dst[ idx*4+2 ] = src[ idx*samples ];
+            dst[ idx*4+3 ] = src[ idx*samples+1 ];
+        }
+    }
+    else if (samples == 3)
     {
-        int idx;
-        for (idx = 0; idx < numSamples; idx++)
-            *ptr++ = *data++;
-        if (numSamples == 3)
-            *ptr++ = 255;
+        if (littleEndian)
+        {
+            // Four pixels at a time: three words of RGB in, four words
+            //   of RGBA out.
+            for (; idx+4<=n; idx+=4)
+            {
+                GLuint in[ 3 ], out[ 4 ];
+                memcpy( in, src + idx*3, 12 );
+                out[ 0 ] = in[ 0 ] | 0xff000000u;
+                out[ 1 ] = (in[ 0 ] >> 24) | (in[ 1 ] << 8) | 0xff000000u;
+                out[ 2 ] = (in[ 1 ] >> 16) | (in[ 2 ] << 16) | 0xff000000u;
+                out[ 3 ] = (in[ 2 ] >> 8) | 0xff000000u;
+                memcpy( dst + idx*4, out, 16 );
+            }
+        }
+        for (; idx<n; idx++)
+        {
+            dst[ idx*4 ] = src[ idx*3 ];
+            dst[ idx*4+1 ] = src[ idx*3+1 ];
+            dst[ idx*4+2 ] = src[ idx*3+2 ];
+            dst[ idx*4+3 ] = 255;
+        }
+    }
+    else if (samples == 4)
+        memcpy( dst, src, n*4 );
+    else
+    {
+        // Extra samples beyond alpha are dropped.
+        for (; idx<n; idx++)
+            memcpy( dst + idx*4, src + idx*samples, 4 );
     }
 }
 
-bool
-Pixels::loadImage( const std::string& fileName )
+
+// How loadImage() reads an image: strips or tiles of contiguous
+//   8-bit samples.
+struct TiffLayout
 {
-    unload();
+    uint32 _width, _height;
+    uint16 _samples;
+    bool _gray;
+
+    bool _tiled;
+    uint32 _rowsPerStrip;
+    uint32 _tileWidth, _tileHeight;
+    int _numChunks;
+    tsize_t _chunkSize;
+};
+
+// Decodes strips or tiles 'begin' through end-1 of 'tif' into the
+//   bottom-up RGBA image 'pixels'. Returns false on a read error.
+static bool
+decodeChunks( TIFF* tif, const TiffLayout& layout, unsigned char* pixels, int begin, int end )
+{
+    const uint32 w = layout._width, h = layout._height;
+    const unsigned int rowBytes = w * 4;
+    unsigned char* temp = new unsigned char[ layout._chunkSize ];
 
-    TIFF* tif = NULL;
-    int idx;
-    for( idx = 0; idx < ogld::OGLDif::instance()->getDataPathSize(); idx++)
+    bool result( true );
+    int chunk;
+    for (chunk=begin; chunk<end; chunk++)
     {
-        std::string fullPath = ogld::OGLDif::instance()->getDataPath( idx ) + fileName;
-        tif = TIFFOpen( fullPath.c_str(), "r" );
+        if (layout._tiled)
+        {
+            const uint32 tilesAcross = (w + layout._tileWidth - 1) / layout._tileWidth;
+            const uint32 x0 = (chunk % tilesAcross) * layout._tileWidth;
+            const uint32 y0 = (chunk / tilesAcross) * layout._tileHeight;
+            if (TIFFReadEncodedTile( tif, TIFFComputeTile( tif, x0, y0, 0, 0 ),
+                    temp, layout._chunkSize ) < 0)
+            {
+                result = false;
+                break;
+            }
+
+            // Tiles at the right and bottom edges extend past the image.
+            const uint32 cols = (x0 + layout._tileWidth <= w) ? layout._tileWidth : w - x0;
+            const uint32 rows = (y0 + layout._tileHeight <= h) ? layout._tileHeight : h - y0;
+            uint32 row;
+            for (row=0; row<rows; row++)
+                expandRow( pixels + (h-1-(y0+row)) * rowBytes + x0*4,
+                        temp + row * layout._tileWidth * layout._samples,
+                        cols, layout._samples, layout._gray );
+        }
+        else
+        {
+            const uint32 y0 = chunk * layout._rowsPerStrip;
+            const uint32 rows = (y0 + layout._rowsPerStrip <= h) ? layout._rowsPerStrip : h - y0;
+
+            if ( (layout._samples == 4) && !layout._gray )
+            {
+                // Already RGBA. Decode straight into the destination
+                //   rows, then flip them in place.
+                unsigned char* block = pixels + (h - y0 - rows) * rowBytes;
+                if (TIFFReadEncodedStrip( tif, chunk, block, rows * rowBytes ) < 0)
+                {
+                    result = false;
+                    break;
+                }
+                uint32 top, bottom;
+                for (top=0, bottom=rows-1; top<bottom; top++, bottom--)
+                {
+                    memcpy( temp, block + top*rowBytes, rowBytes );
+                    memcpy( block + top*rowBytes, block + bottom*rowBytes, rowBytes );
+                    memcpy( block + bottom*rowBytes, temp, rowBytes );
+                }
+            }
+            else
+            {
+                if (TIFFReadEncodedStrip( tif, chunk, temp, layout._chunkSize ) < 0)
+                {
+                    result = false;
+                    break;
+                }
+                const unsigned int srcRowBytes = w * layout._samples;
+                uint32 row;
+                for (row=0; row<rows; row++)
+                    expandRow( pixels + (h-1-(y0+row)) * rowBytes, temp + row * srcRowBytes,
+                            w, layout._samples, layout._gray );
+            }
+        }
+    }
+
+    delete[] temp;
+    return result;
+}
+
+// Decodes a range of chunks with a TIFF handle of its own, so that
+//   parallelFor() can decode compressed strips or tiles concurrently.
+class TiffDecodeTask : public RangeTask
+{
+public:
+    TiffDecodeTask( const std::string& path, const TiffLayout& layout, unsigned char* pixels )
+      : _path( path ), _layout( layout ), _pixels( pixels ), _result( true ) {}
+
+    virtual void run( int begin, int end )
+    {
+        TIFF* tif = TIFFOpen( _path.c_str(), "r" );
+        const bool result = (tif != NULL) &&
+                decodeChunks( tif, _layout, _pixels, begin, end );
         if (tif)
-            break;
+            TIFFClose( tif );
+
+        if (!result)
+        {
+            ScopedLock lock( _mutex );
+            _result = false;
+        }
     }
-    if (!tif)
-        return false;
 
-    uint32 w, h;
-    size_t npixels;
-    uint16 photometric;
-    uint16 config;
-    uint16 samples;
+    bool getResult() const { return _result; }
 
-    TIFFGetField( tif, TIFFTAG_PHOTOMETRIC, &photometric );
-    assert( photometric == PHOTOMETRIC_RGB );
-    TIFFGetField( tif, TIFFTAG_PLANARCONFIG, &config );
-    assert( config == PLANARCONFIG_CONTIG );
+protected:
+    const std::string& _path;
+    const TiffLayout& _layout;
+    unsigned char* _pixels;
 
-    TIFFGetField( tif, TIFFTAG_SAMPLESPERPIXEL, &samples );
+    Mutex _mutex;
+    bool _result;
+};
 
-    TIFFGetField( tif, TIFFTAG_IMAGEWIDTH, &w );
-    TIFFGetField( tif, TIFFTAG_IMAGELENGTH, &h );
-    npixels = w * h;
+// Compressed chunks are decoded in parallel in groups of at least
+//   this many bytes, so that each thread has enough work to pay for
+//   opening the file again.
+static const tsize_t PARALLEL_GRAIN_BYTES( 256 * 1024 );
 
-    _width = w;
-    _height = h;
-    int sizeBytes = size();
-    _pixels = new unsigned char[ sizeBytes ];
-    unsigned char* ptr = _pixels + (h-1)*w*4;
+bool
+Pixels::loadImage( const std::string& fileName )
+{
+    unload();
 
-    unsigned char* inBuf = new unsigned char[ TIFFScanlineSize( tif ) ];
-    int row;
-    for (row = 0; row < (int)h; row++)
+    const std::string fullPath( OGLDif::instance()->findDataFile( fileName ) );
+    if (!readImage( fullPath ))
+        return false;
+
+    init();
+
+    return _valid;
+}
+
+bool
+Pixels::readImage( const std::string& fullPath )
+{
+    if (fullPath.empty())
+        return false;
+    TIFF* tif = TIFFOpen( fullPath.c_str(), "r" );
+    if (!tif)
+        return false;
+
+    TiffLayout layout;
+    uint16 photometric( PHOTOMETRIC_RGB ), config, bitsPerSample, compression;
+    TIFFGetField( tif, TIFFTAG_PHOTOMETRIC, &photometric );
+    TIFFGetFieldDefaulted( tif, TIFFTAG_PLANARCONFIG, &config );
+    TIFFGetFieldDefaulted( tif, TIFFTAG_BITSPERSAMPLE, &bitsPerSample );
+    TIFFGetFieldDefaulted( tif, TIFFTAG_SAMPLESPERPIXEL, &layout._samples );
+    TIFFGetFieldDefaulted( tif, TIFFTAG_COMPRESSION, &compression );
+    TIFFGetField( tif, TIFFTAG_IMAGEWIDTH, &layout._width );
+    TIFFGetField( tif, TIFFTAG_IMAGELENGTH, &layout._height );
+
+    _width = layout._width;
+    _height = layout._height;
+    _pixels = new unsigned char[ size() ];
+
+    layout._gray = (photometric == PHOTOMETRIC_MINISBLACK);
+    const bool direct = (config == PLANARCONFIG_CONTIG) && (bitsPerSample == 8) &&
+            ( (layout._gray && (layout._samples <= 2)) ||
+            ((photometric == PHOTOMETRIC_RGB) && (layout._samples >= 3)) );
+
+    bool result;
+    if (direct)
     {
-        if (TIFFReadScanline( tif, inBuf, row, 0 ) < 0)
+        layout._tiled = (TIFFIsTiled( tif ) != 0);
+        if (layout._tiled)
+        {
+            TIFFGetField( tif, TIFFTAG_TILEWIDTH, &layout._tileWidth );
+            TIFFGetField( tif, TIFFTAG_TILELENGTH, &layout._tileHeight );
+            layout._numChunks = (int) TIFFNumberOfTiles( tif );
+            layout._chunkSize = TIFFTileSize( tif );
+        }
+        else
+        {
+            TIFFGetFieldDefaulted( tif, TIFFTAG_ROWSPERSTRIP, &layout._rowsPerStrip );
+            if (layout._rowsPerStrip > layout._height)
+                layout._rowsPerStrip = layout._height;
+            layout._numChunks = (int) TIFFNumberOfStrips( tif );
+            layout._chunkSize = TIFFStripSize( tif );
+        }
+
+        if ( (compression == COMPRESSION_NONE) || (layout._numChunks == 1) ||
+                (getNumProcessors() == 1) )
+            // Nothing to gain from more threads.
+            result = decodeChunks( tif, layout, _pixels, 0, layout._numChunks );
+        else
         {
-            assert( false );
-            break;
+            TiffDecodeTask task( fullPath, layout, _pixels );
+            const int grain = (int)( PARALLEL_GRAIN_BYTES / layout._chunkSize ) + 1;
+            parallelFor( task, layout._numChunks, grain );
+            result = task.getResult();
         }
-        copyRow( ptr, inBuf, w, samples );
-        ptr -= 4*w;
     }
-    delete[] inBuf;
-    _valid = true;
+    else
+    {
+        // Palette, 16-bit, planar, YCbCr, and other layouts. libtiff
+        //   converts them to RGBA words, bottom row first.
+        result = (TIFFReadRGBAImageOriented( tif, _width, _height,
+                (uint32*) _pixels, ORIENTATION_BOTLEFT, 0 ) != 0);
 
+        const GLushort one( 1 );
+        if (*(const GLubyte*) &one != 1)
+        {
+            // Red is the low byte of each word.
+            const uint32* src = (const uint32*) _pixels;
+            unsigned char* dst = _pixels;
+            int idx;
+            for (idx=0; idx<_width*_height; idx++, src++)
+            {
+                const uint32 abgr = *src;
+                *dst++ = (unsigned char) TIFFGetR( abgr );
+                *dst++ = (unsigned char) TIFFGetG( abgr );
+                *dst++ = (unsigned char) TIFFGetB( abgr );
+                *dst++ = (unsigned char) TIFFGetA( abgr );
+            }
+        }
+    }
 
     TIFFClose( tif );
 
-    init();
+    if (!result)
+    {
+        delete[] _pixels;
+        _pixels = NULL;
+        return false;
+    }
+
+    _valid = true;
 
     return _valid;
 }
@@ -170,6 +411,26 @@ Pixels::loadDirect( GLsizei width, GLsizei height, GLubyte* pixels )
     return _valid;
 }
 
+void
+Pixels::resample( GLsizei width, GLsizei height )
+{
+    if ( (width == _width) && (height == _height) )
+        return;
+
+    const GLsizei oldW( _width ), oldH( _height );
+    _width = width;
+    _height = height;
+    if (_pixels == NULL)
+        return;
+
+    unsigned char* newData = new unsigned char[ size() ];
+    scaleImage( _format, oldW, oldH, _type, _pixels,
+            _width, _height, _type, (GLvoid*) newData );
+
+    delete[] _pixels;
+    _pixels = newData;
+}
+
 
 void
 Pixels::apply()
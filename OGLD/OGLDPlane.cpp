@@ -14,7 +14,12 @@
 #include "OGLDPlane.h"
 #include "OGLDif.h"
 #include "OGLDMath.h"
+#include "OGLDVertexCache.h"
+#include "OGLDMeshCache.h"
+#include "OGLDShapeTuner.h"
 #include <assert.h>
+#include <math.h>
+#include <stdio.h>
 #include <string.h>
 
 
@@ -25,9 +30,11 @@ namespace ogld
 
 // Static factory creation methods
 Plane*
-Plane::create( float xLen, float yLen, int xUnits, int yUnits, float z )
+Plane::create( float xLen, float yLen, int xUnits, int yUnits, float z, VertexFormat format )
 {
-    switch (OGLDif::instance()->getVersion())
+    Plane* plane( NULL );
+
+    switch (ShapeTuner::instance()->getShapeVersion())
     {
 
     case VerExtended:
@@ -40,29 +47,25 @@ Plane::create( float xLen, float yLen, int xUnits, int yUnits, float z )
         // The Plane15 class is known to produce incorrect results
         // using an ATI Radeon 9600, driver version 1.4.18, on a G4
         // Power Macintosh with Mac OS X 10.4.4. Workaround:
-        // Comment out the next two lines, allowing the switch to fall
-        // through and create a Plane14 instance.
+        // call ShapeTuner::instance()->setShapeVersion( Ver13 ) for
+        // that renderer, so the switch starts at Ver13 and creates a
+        // Plane13 instance.
         //
-        return new Plane15( xLen, yLen, xUnits, yUnits, z );
+        plane = new Plane15( xLen, yLen, xUnits, yUnits, z );
         break;
 #endif
 
     case Ver14:
-#ifdef GL_VERSION_1_4
-        return new Plane14( xLen, yLen, xUnits, yUnits, z );
-        break;
-#endif
-
     case Ver13:
 #ifdef GL_VERSION_1_3
-        return new Plane13( xLen, yLen, xUnits, yUnits, z );
+        plane = new Plane13( xLen, yLen, xUnits, yUnits, z );
         break;
 #endif
 
     case Ver12:
     case Ver11:
 #ifdef GL_VERSION_1_1
-        return new Plane( xLen, yLen, xUnits, yUnits, z );
+        plane = new Plane( xLen, yLen, xUnits, yUnits, z );
         break;
 #endif
 
@@ -73,12 +76,17 @@ Plane::create( float xLen, float yLen, int xUnits, int yUnits, float z )
         return NULL;
         break;
     }
+
+    plane->_vertexFormat = format;
+    return plane;
 }
 
 Plane*
-Plane::create( float xLen, float yLen, int xUnits, int yUnits, float* zArray )
+Plane::create( float xLen, float yLen, int xUnits, int yUnits, float* zArray, VertexFormat format )
 {
-    switch (OGLDif::instance()->getVersion())
+    Plane* plane( NULL );
+
+    switch (ShapeTuner::instance()->getShapeVersion())
     {
 
     case VerExtended:
@@ -91,29 +99,25 @@ Plane::create( float xLen, float yLen, int xUnits, int yUnits, float* zArray )
         // The Plane15 class is known to produce incorrect results
         // using an ATI Radeon 9600, driver version 1.4.18, on a G4
         // Power Macintosh with Mac OS X 10.4.4. Workaround:
-        // Comment out the next two lines, allowing the switch to fall
-        // through and create a Plane14 instance.
+        // call ShapeTuner::instance()->setShapeVersion( Ver13 ) for
+        // that renderer, so the switch starts at Ver13 and creates a
+        // Plane13 instance.
         //
-        return new Plane15( xLen, yLen, xUnits, yUnits, zArray );
+        plane = new Plane15( xLen, yLen, xUnits, yUnits, zArray );
         break;
 #endif
 
     case Ver14:
-#ifdef GL_VERSION_1_4
-        return new Plane14( xLen, yLen, xUnits, yUnits, zArray );
-        break;
-#endif
-
     case Ver13:
 #ifdef GL_VERSION_1_3
-        return new Plane13( xLen, yLen, xUnits, yUnits, zArray );
+        plane = new Plane13( xLen, yLen, xUnits, yUnits, zArray );
         break;
 #endif
 
     case Ver12:
     case Ver11:
 #ifdef GL_VERSION_1_1
-        return new Plane( xLen, yLen, xUnits, yUnits, zArray );
+        plane = new Plane( xLen, yLen, xUnits, yUnits, zArray );
         break;
 #endif
 
@@ -124,6 +128,9 @@ Plane::create( float xLen, float yLen, int xUnits, int yUnits, float* zArray )
         return NULL;
         break;
     }
+
+    plane->_vertexFormat = format;
+    return plane;
 }
 
 
@@ -137,9 +144,6 @@ Plane::Plane( float xLen, float yLen, int xUnits, int yUnits, float z )
     _vertices( NULL ),
     _normals( NULL ),
     _texCoords( NULL ),
-    _indices( NULL ),
-    _idxAddrs( NULL ),
-    _idxCounts( NULL ),
     _valid( false ),
     _numVerts( 0 ),
     _numIndices( 0 ),
@@ -151,6 +155,8 @@ Plane::Plane( float xLen, float yLen, int xUnits, int yUnits, float z )
         _xUnits = 1;
     if (_yUnits < 1)
         _yUnits = 1;
+
+    setBound( _z, _z );
 }
 
 Plane::Plane( float xLen, float yLen, int xUnits, int yUnits, float* zArray )
@@ -163,9 +169,6 @@ Plane::Plane( float xLen, float yLen, int xUnits, int yUnits, float* zArray )
     _vertices( NULL ),
     _normals( NULL ),
     _texCoords( NULL ),
-    _indices( NULL ),
-    _idxAddrs( NULL ),
-    _idxCounts( NULL ),
     _valid( false ),
     _numVerts( 0 ),
     _numIndices( 0 ),
@@ -181,39 +184,46 @@ Plane::Plane( float xLen, float yLen, int xUnits, int yUnits, float* zArray )
     int sz = (_xUnits+1) * (_yUnits+1);
     _zArray = new float[ sz ];
     memcpy( _zArray, zArray, sz * sizeof( float ) );
+
+    float minZ = _zArray[ 0 ], maxZ = _zArray[ 0 ];
+    int idx;
+    for (idx=1; idx<sz; idx++)
+    {
+        if (_zArray[ idx ] < minZ)
+            minZ = _zArray[ idx ];
+        else if (_zArray[ idx ] > maxZ)
+            maxZ = _zArray[ idx ];
+    }
+    setBound( minZ, maxZ );
 }
 
 Plane::~Plane()
 {
-    if ( _valid )
-    {
-        if (_dListAllocated)
-        {
-            glDeleteLists( _dList, 1 );
-            _dListAllocated = false;
-        }
+    cancelBuild();
 
-        if (_vertices)
-            delete[] _vertices;
-        if (_normals)
-            delete[] _normals;
-        if (_texCoords)
-            delete[] _texCoords;
-        if (_indices)
-            delete[] _indices;
-        if (_idxAddrs)
-            delete[] _idxAddrs;
-        if (_idxCounts)
-            delete[] _idxCounts;
-        if (_zArray)
-            delete[] _zArray;
-        _vertices = _normals = _texCoords = NULL;
-        _indices = NULL;
-        _idxAddrs = NULL;
-        _idxCounts = NULL;
-        _zArray = NULL;
-        _valid = false;
+    if (_dListAllocated)
+    {
+        glDeleteLists( _dList, 1 );
+        _dListAllocated = false;
     }
+
+    freeHostArray( _vertices );
+    freeHostArray( _normals );
+    freeHostArray( _texCoords );
+    _indices.clear();
+    if (_zArray)
+        delete[] _zArray;
+    _zArray = NULL;
+    _valid = false;
+}
+
+void
+Plane::setBound( float minZ, float maxZ )
+{
+    const float halfX = (float) fabs( _xLen ) * .5f;
+    const float halfY = (float) fabs( _yLen ) * .5f;
+    _bound.setBox( -halfX, -halfY, minZ, halfX, halfY, maxZ );
+    _bound.setSphereFromBox();
 }
 
 void
@@ -225,20 +235,156 @@ Plane::draw()
             return;
     }
 
+    if (_master)
+    {
+        _master->draw();
+        return;
+    }
+
     glCallList( _dList );
 
     OGLDIF_CHECK_ERROR;
 }
 
+bool
+Plane::getShareKey( std::string& key ) const
+{
+    if (_zArray)
+        // Height fields aren't shared.
+        return false;
+
+    char buf[ 128 ];
+    sprintf( buf, "Plane %.9g %.9g %d %d %.9g %d %d", _xLen, _yLen, _xUnits, _yUnits, _z,
+            _numTextures, (int) _vertexFormat );
+    key = buf;
+    return true;
+}
+
+Shape*
+Plane::createMaster() const
+{
+    Plane* master = Plane::create( _xLen, _yLen, _xUnits, _yUnits, _z, _vertexFormat );
+    master->setShared( false );
+    master->setTextures( _numTextures );
+    return master;
+}
+
+bool
+Plane::getCacheKey( std::string& key ) const
+{
+    if (!_zArray)
+        return getShareKey( key );
+
+    // Height fields aren't shared, but they're cached by their z values.
+    char buf[ 128 ];
+    sprintf( buf, "Plane %.9g %.9g %d %d %d %d zArray ", _xLen, _yLen, _xUnits, _yUnits,
+            _numTextures, (int) _vertexFormat );
+    key = std::string( buf ) +
+            MeshCache::hash( _zArray, (_xUnits+1)*(_yUnits+1)*sizeof( float ) );
+    return true;
+}
+
+bool
+Plane::saveGeometry( MeshCacheWriter& writer ) const
+{
+    const int counts[ 2 ] = { _numVerts, _numIndices };
+    writer.addInts( counts, 2 );
+    writer.addFloats( _vertices, _numVerts * 3 );
+    writer.addFloats( _normals, _numVerts * 3 );
+    writer.addFloats( _texCoords, _numVerts * 2 );
+    writer.addIndices( _indices );
+    return true;
+}
+
+bool
+Plane::loadGeometry( MeshCacheEntry& entry )
+{
+    int counts[ 2 ];
+    if ( !entry.getInts( counts, 2 ) || (counts[0] < 0) )
+        return false;
+    const GLfloat* vertices = entry.getFloats( counts[0] * 3 );
+    const GLfloat* normals = vertices ? entry.getFloats( counts[0] * 3 ) : NULL;
+    const GLfloat* texCoords = normals ? entry.getFloats( counts[0] * 2 ) : NULL;
+    if ( (texCoords == NULL) || !entry.getIndices( _indices ) )
+        return false;
+    if (_indices.getCount() != counts[1])
+    {
+        _indices.clear();
+        return false;
+    }
+
+    _numVerts = counts[0];
+    _numIndices = counts[1];
+    _vertices = (GLfloat*) vertices;
+    _normals = (GLfloat*) normals;
+    _texCoords = (GLfloat*) texCoords;
+    return true;
+}
+
+bool
+Plane::getTriangles( int& numVerts, const float*& vertices, const float*& normals,
+        const float*& texCoords, int& texCoordSize, const IndexArray*& indices ) const
+{
+    numVerts = _numVerts;
+    vertices = _vertices;
+    normals = _normals;
+    texCoords = _texCoords;
+    texCoordSize = 2;
+    indices = &_indices;
+    return( _vertices != NULL );
+}
+
+void
+Plane::contextLost()
+{
+    Shape::contextLost();
+    if (_master)
+        return;
+
+    // The display list or buffer objects went with the context.
+    _dListAllocated = false;
+    _valid = false;
+}
+
+bool
+Plane::freeHostData()
+{
+    // _zArray stays; buildData() needs it.
+    freeHostArray( _vertices );
+    freeHostArray( _normals );
+    freeHostArray( _texCoords );
+    _indices.releaseData();
+    return true;
+}
+
 bool
 Plane::init()
 {
-    if (!buildData())
+    if (acquireMaster())
+        return( _valid = true );
+
+    // Tessellate now, unless buildAsync() already started it.
+    if (!finishBuild())
         return false;
 
     if (!storeData())
         return false;
 
+    releaseHostData();
+    return true;
+}
+
+bool
+Plane::buildGeometry()
+{
+    if (!buildData())
+        return false;
+
+    optimizeTriangleList( _indices.getUIntData(), _numIndices, _numVerts,
+            _vertices, _normals, _texCoords, 2 );
+
+    _indices.pack( _numVerts );
+
     return true;
 }
 
@@ -247,13 +393,10 @@ bool
 Plane::buildData()
 {
     _numVerts = (_xUnits+1)*(_yUnits+1);
-    _numIndices = (_yUnits+1)*2*_xUnits;
+    _numIndices = _xUnits*_yUnits*6;
     float halfXLen = _xLen * .5f;
     float halfYLen = _yLen * .5f;
 
-    if (_numIndices > 65535)
-        return false;
-
 
     // Plane normal points in positive Z as long as sign of xLen and
     //   yLen are the same; negative Z otherwise.
@@ -304,26 +447,28 @@ Plane::buildData()
 
 
     //
-    // Create indices. We'll have _xUnits quad strips with _yUnits quads
-    //   in each strip.
-    _indices = new GLushort[ _numIndices ];
-    GLushort* indexPtr = _indices;
-
-    int iterations = (_yUnits+1)*_xUnits;
-    for (xIdx=0; xIdx<iterations; xIdx++)
-    {
-        *indexPtr++ = xIdx;
-        *indexPtr++ = xIdx + _yUnits + 1;
-    }
+    // Create indices. We'll have one triangle list with two triangles
+    //   for each of the _xUnits * _yUnits quads.
+    GLuint* indexPtr = _indices.allocate( _numIndices );
 
-    _idxAddrs = new GLushort*[ _xUnits ];
-    _idxCounts = new GLsizei[ _xUnits ];
-    int count = 0;
     for (xIdx=0; xIdx<_xUnits; xIdx++)
     {
-        _idxAddrs[xIdx] = indexAddress( count );
-        _idxCounts[xIdx] = (_yUnits+1)*2;
-        count += _idxCounts[xIdx];
+        int yIdx;
+        for (yIdx=0; yIdx<_yUnits; yIdx++)
+        {
+            const GLuint v0 = xIdx*(_yUnits+1) + yIdx;
+            const GLuint v1 = v0 + _yUnits + 1;
+            const GLuint v2 = v0 + 1;
+            const GLuint v3 = v1 + 1;
+
+            *indexPtr++ = v0;
+            *indexPtr++ = v1;
+            *indexPtr++ = v2;
+
+            *indexPtr++ = v2;
+            *indexPtr++ = v1;
+            *indexPtr++ = v3;
+        }
     }
 
     return true;
@@ -349,9 +494,7 @@ Plane::storeData()
     glNormalPointer( GL_FLOAT, 0, _normals );
     glTexCoordPointer( 2, GL_FLOAT, 0, _texCoords );
 
-    int idx;
-    for (idx=0; idx<_xUnits; idx++)
-        glDrawElements( GL_TRIANGLE_STRIP, _idxCounts[idx], GL_UNSIGNED_SHORT, _idxAddrs[idx] );
+    glDrawElements( GL_TRIANGLES, _numIndices, _indices.getType(), _indices.getData() );
 
     glPopClientAttrib();
 
@@ -364,13 +507,6 @@ Plane::storeData()
     return( _valid = true );
 }
 
-GLushort*
-Plane::indexAddress( int count )
-{
-    return ( &_indices[ count ] );
-}
-
-
 
 
 
@@ -391,6 +527,7 @@ Plane13::Plane13( float xLen, float yLen, int xUnits, int yUnits, float* zArray
 
 Plane13::~Plane13()
 {
+    cancelBuild();
 }
 
 
@@ -419,72 +556,7 @@ Plane13::storeData()
         glTexCoordPointer( 2, GL_FLOAT, 0, _texCoords );
     }
 
-    for (idx=0; idx<_xUnits; idx++)
-        glDrawElements( GL_TRIANGLE_STRIP, _idxCounts[idx], GL_UNSIGNED_SHORT, _idxAddrs[idx] );
-
-    glPopClientAttrib();
-
-
-    glEndList();
-
-
-    OGLDIF_CHECK_ERROR;
-
-    return( _valid = true );
-}
-
-#endif
-
-
-
-
-#ifdef GL_VERSION_1_4 
-
-
-Plane14::Plane14( float xLen, float yLen, int xUnits, int yUnits, float z )
-  : Plane( xLen, yLen, xUnits, yUnits, z )
-{
-    assert( OGLDif::instance()->getVersion() >= Ver14 );
-}
-
-Plane14::Plane14( float xLen, float yLen, int xUnits, int yUnits, float* zArray )
-  : Plane( xLen, yLen, xUnits, yUnits, zArray )
-{
-    assert( OGLDif::instance()->getVersion() >= Ver14 );
-}
-
-Plane14::~Plane14()
-{
-}
-
-
-bool
-Plane14::storeData()
-{
-    _dList = glGenLists( 1 );
-    assert( _dList != 0 );
-    _dListAllocated = true;
-    glNewList( _dList, GL_COMPILE );
-
-    glPushClientAttrib( GL_CLIENT_VERTEX_ARRAY_BIT );
-
-    glEnableClientState( GL_VERTEX_ARRAY );
-    glEnableClientState( GL_NORMAL_ARRAY );
-
-    glVertexPointer( 3, GL_FLOAT, 0, _vertices );
-    glNormalPointer( GL_FLOAT, 0, _normals );
-
-    glTexCoordPointer( 2, GL_FLOAT, 0, _texCoords );
-
-    int idx;
-    for (idx=0; idx<_numTextures; idx++)
-    {
-        glClientActiveTexture( GL_TEXTURE0 + idx );
-        glEnableClientState( GL_TEXTURE_COORD_ARRAY );
-        glTexCoordPointer( 2, GL_FLOAT, 0, _texCoords );
-    }
-
-    glMultiDrawElements( GL_TRIANGLE_STRIP, _idxCounts, GL_UNSIGNED_SHORT, (const void**) _idxAddrs, _xUnits );
+    glDrawElements( GL_TRIANGLES, _numIndices, _indices.getType(), _indices.getData() );
 
     glPopClientAttrib();
 
@@ -497,7 +569,6 @@ Plane14::storeData()
     return( _valid = true );
 }
 
-
 #endif
 
 
@@ -506,29 +577,53 @@ Plane14::storeData()
 #ifdef GL_VERSION_1_5
 
 
-// Static indices into the _vbo vertex buffer array
-int Plane15::_vertIdx( 0 );
-int Plane15::_normIdx( 1 );
-int Plane15::_texIdx( 2 );
-int Plane15::_idxIdx( 3 );
+// Layout of the interleaved vertex buffer object: three position
+//   floats, three normal floats, and two texture coordinate floats.
+static const int INTERLEAVED_FLOATS( 8 );
+static const unsigned int NORMAL_OFFSET( 3 * sizeof( GLfloat ) );
+static const unsigned int TEXCOORD_OFFSET( 6 * sizeof( GLfloat ) );
 
 
 Plane15::Plane15( float xLen, float yLen, int xUnits, int yUnits, float z )
-  : Plane( xLen, yLen, xUnits, yUnits, z )
+  : Plane( xLen, yLen, xUnits, yUnits, z ),
+    _vertBlock( NULL ),
+    _idxBlock( NULL )
 {
     assert( OGLDif::instance()->getVersion() >= Ver15 );
 }
 
 Plane15::Plane15( float xLen, float yLen, int xUnits, int yUnits, float* zArray )
-  : Plane( xLen, yLen, xUnits, yUnits, zArray )
+  : Plane( xLen, yLen, xUnits, yUnits, zArray ),
+    _vertBlock( NULL ),
+    _idxBlock( NULL )
 {
     assert( OGLDif::instance()->getVersion() >= Ver15 );
 }
 
 Plane15::~Plane15()
 {
-    if ( _valid )
-        glDeleteBuffers( 4, _vbo );
+    cancelBuild();
+
+    if ( _valid && (_master == NULL) )
+    {
+        BufferArena::instance()->release( _vertBlock );
+        BufferArena::instance()->release( _idxBlock );
+    }
+}
+
+void
+Plane15::contextLost()
+{
+    // Return the blocks to their lost page. BufferArena::release()
+    //   makes no OpenGL calls.
+    if ( _valid && (_master == NULL) )
+    {
+        BufferArena::instance()->release( _vertBlock );
+        BufferArena::instance()->release( _idxBlock );
+        _vertBlock = _idxBlock = NULL;
+    }
+
+    Plane::contextLost();
 }
 
 void
@@ -540,61 +635,95 @@ Plane15::draw()
             return;
     }
 
-    glPushClientAttrib( GL_CLIENT_VERTEX_ARRAY_BIT );
+    if (_master)
+    {
+        _master->draw();
+        return;
+    }
 
-    glEnableClientState( GL_VERTEX_ARRAY );
-    glBindBuffer( GL_ARRAY_BUFFER, _vbo[_vertIdx] );
-    glVertexPointer( 3, GL_FLOAT, 0, bufferObjectPtr( 0 ) );
+    glPushClientAttrib( GL_CLIENT_VERTEX_ARRAY_BIT );
 
-    glEnableClientState( GL_NORMAL_ARRAY );
-    glBindBuffer( GL_ARRAY_BUFFER, _vbo[_normIdx] );
-    glNormalPointer( GL_FLOAT, 0, bufferObjectPtr( 0 ) );
+    glBindBuffer( GL_ARRAY_BUFFER, _vertBlock->getBuffer() );
+    const GLuint base = (GLuint) _vertBlock->getOffset();
 
-    int tIdx;
-    for (tIdx=0; tIdx<_numTextures; tIdx++)
+    if (_vertexFormat == CompactVertexFormat)
     {
-        glClientActiveTexture( GL_TEXTURE0 + tIdx );
-        glEnableClientState( GL_TEXTURE_COORD_ARRAY );
-        glBindBuffer( GL_ARRAY_BUFFER, _vbo[_texIdx] );
-        glTexCoordPointer( 2, GL_FLOAT, 0, bufferObjectPtr( 0 ) );
+        _compact.pushTransform( _numTextures );
+        _compact.setPointers( (const GLubyte*) bufferObjectPtr( base ), _numTextures );
+    }
+    else
+    {
+        const GLsizei stride = INTERLEAVED_FLOATS * sizeof( GLfloat );
+
+        glEnableClientState( GL_VERTEX_ARRAY );
+        glVertexPointer( 3, GL_FLOAT, stride, bufferObjectPtr( base ) );
+
+        glEnableClientState( GL_NORMAL_ARRAY );
+        glNormalPointer( GL_FLOAT, stride, bufferObjectPtr( base + NORMAL_OFFSET ) );
+
+        int tIdx;
+        for (tIdx=0; tIdx<_numTextures; tIdx++)
+        {
+            glClientActiveTexture( GL_TEXTURE0 + tIdx );
+            glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+            glTexCoordPointer( 2, GL_FLOAT, stride, bufferObjectPtr( base + TEXCOORD_OFFSET ) );
+        }
     }
 
-    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, _vbo[_idxIdx] );
-    glMultiDrawElements( GL_TRIANGLE_STRIP, _idxCounts, GL_UNSIGNED_SHORT, (const void**) _idxAddrs, _xUnits );
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, _idxBlock->getBuffer() );
+    glDrawRangeElements( GL_TRIANGLES, 0, _numVerts-1, _numIndices, _indices.getType(), bufferObjectPtr( _idxBlock->getOffset() ) );
 
     glBindBuffer( GL_ARRAY_BUFFER, 0 );
     glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
 
     glPopClientAttrib();
 
-
-    OGLDIF_CHECK_ERROR;
-}
+    if (_vertexFormat == CompactVertexFormat)
+        _compact.popTransform( _numTextures );
 
 
-GLushort*
-Plane15::indexAddress( int count )
-{
-    return (GLushort*) bufferObjectPtr( count * sizeof( GLushort ) );
+    OGLDIF_CHECK_ERROR;
 }
 
 
 bool
 Plane15::storeData()
 {
-    glGenBuffers( 4, _vbo );
-
-    glBindBuffer( GL_ARRAY_BUFFER, _vbo[_vertIdx] );
-    glBufferData( GL_ARRAY_BUFFER, _numVerts*3*sizeof(GLfloat), _vertices, GL_STATIC_DRAW );
+    if (_vertexFormat == CompactVertexFormat)
+    {
+        _compact.build( _numVerts, _vertices, _normals, _texCoords, 2 );
+        _vertBlock = BufferArena::instance()->allocate( GL_ARRAY_BUFFER, _compact.getSizeBytes(), _compact.getData() );
+        _compact.releaseData();
+        _compact.getErrors( _positionError, _normalError, _texCoordError );
+    }
+    else
+    {
+        // Interleave the vertex data so that each vertex is fetched
+        //   from one buffer object with a single bind.
+        GLfloat* interleaved = new GLfloat[ _numVerts * INTERLEAVED_FLOATS ];
+        GLfloat* destPtr = interleaved;
+        const GLfloat* vertPtr = _vertices;
+        const GLfloat* normPtr = _normals;
+        const GLfloat* texPtr = _texCoords;
+        int idx;
+        for (idx=0; idx<_numVerts; idx++)
+        {
+            *destPtr++ = *vertPtr++;
+            *destPtr++ = *vertPtr++;
+            *destPtr++ = *vertPtr++;
+            *destPtr++ = *normPtr++;
+            *destPtr++ = *normPtr++;
+            *destPtr++ = *normPtr++;
+            *destPtr++ = *texPtr++;
+            *destPtr++ = *texPtr++;
+        }
 
-    glBindBuffer( GL_ARRAY_BUFFER, _vbo[_normIdx] );
-    glBufferData( GL_ARRAY_BUFFER, _numVerts*3*sizeof(GLfloat), _normals, GL_STATIC_DRAW );
+        _vertBlock = BufferArena::instance()->allocate( GL_ARRAY_BUFFER, _numVerts*INTERLEAVED_FLOATS*sizeof(GLfloat), interleaved );
 
-    glBindBuffer( GL_ARRAY_BUFFER, _vbo[_texIdx] );
-    glBufferData( GL_ARRAY_BUFFER, _numVerts*2*sizeof(GLfloat), _texCoords, GL_STATIC_DRAW );
+        delete[] interleaved;
+    }
 
-    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, _vbo[_idxIdx] );
-    glBufferData( GL_ELEMENT_ARRAY_BUFFER, _numIndices*sizeof(GLushort), _indices, GL_STATIC_DRAW );
+    _idxBlock = BufferArena::instance()->allocate( GL_ELEMENT_ARRAY_BUFFER, _indices.getSizeBytes(), _indices.getData() );
     
     
     glBindBuffer( GL_ARRAY_BUFFER, 0 );
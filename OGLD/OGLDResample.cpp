@@ -0,0 +1,286 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+//
+
+
+#include "OGLDPlatformGL.h"
+#include "OGLDPlatformGLU.h"
+#include "OGLDif.h"
+#include "OGLDMipmap.h"
+#include "OGLDResample.h"
+#include "OGLDThread.h"
+#include <vector>
+#include <math.h>
+
+
+
+namespace ogld
+{
+
+
+// Rows are resampled in parallel in groups of at least this many
+//   source and destination bytes.
+static const int PARALLEL_GRAIN_BYTES( 64 * 1024 );
+
+// Filter weights are fixed point with WEIGHT_BITS fractional bits.
+//   The vertical pass keeps 8 of them, so that its sums fit in a
+//   GLushort and the horizontal pass's fit in an int.
+static const int WEIGHT_BITS( 14 );
+static const int WEIGHT_ONE( 1 << WEIGHT_BITS );
+static const int VERTICAL_SHIFT( WEIGHT_BITS - 8 );
+static const int HORIZONTAL_SHIFT( WEIGHT_BITS + 8 );
+
+
+void
+roundToPower2( GLsizei& width, GLsizei& height, Power2Rounding rounding )
+{
+    GLsizei* dims[ 2 ] = { &width, &height };
+    int idx;
+    for (idx=0; idx<2; idx++)
+    {
+        GLsizei& dim = *(dims[ idx ]);
+        if ( (dim <= 0) || ((dim & (dim-1)) == 0) )
+            continue;
+
+        GLsizei power( 1 );
+        while (power < dim)
+            power <<= 1;
+        dim = (rounding == RoundDownPower2) ? power >> 1 : power;
+    }
+}
+
+
+// The source texels, and their weights, that make up each
+//   destination texel along one axis.
+class Contributions
+{
+public:
+    Contributions( GLsizei srcSize, GLsizei dstSize );
+
+    // Texel 'idx' is the sum of _count[ idx ] source texels from
+    //   _first[ idx ] on, weighted by _weights[ idx * _stride ] on.
+    std::vector< int > _first;
+    std::vector< int > _count;
+    std::vector< int > _weights;
+    int _stride;
+};
+
+Contributions::Contributions( GLsizei srcSize, GLsizei dstSize )
+  : _first( dstSize ),
+    _count( dstSize )
+{
+    const double scale = (double) srcSize / (double) dstSize;
+    _stride = (scale > 1.) ? (int) ceil( scale ) + 1 : 2;
+    _weights.resize( dstSize * _stride );
+    std::vector< double > weights( _stride );
+
+    int idx;
+    for (idx=0; idx<dstSize; idx++)
+    {
+        int first, count;
+        if (scale > 1.)
+        {
+            // Shrinking: the area of each source texel the
+            //   destination texel covers.
+            const double lo = idx * scale;
+            const double hi = lo + scale;
+            first = (int) floor( lo );
+            count = (int) ceil( hi ) - first;
+            int j;
+            for (j=0; j<count; j++)
+            {
+                const double left = (first+j > lo) ? first+j : lo;
+                const double right = (first+j+1 < hi) ? first+j+1 : hi;
+                weights[ j ] = right - left;
+            }
+        }
+        else
+        {
+            // Enlarging: linear interpolation between the two source
+            //   texels nearest the destination texel's center.
+            const double center = (idx + .5) * scale - .5;
+            first = (int) floor( center );
+            count = 2;
+            weights[ 1 ] = center - first;
+            weights[ 0 ] = 1. - weights[ 1 ];
+        }
+
+        // Drop texels outside the source, which clamps to its edges.
+        int skip( 0 );
+        if (first < 0)
+            skip = -first;
+        if (first + count > srcSize)
+            count = srcSize - first;
+        first += skip;
+        count -= skip;
+
+        double total( 0. );
+        int j;
+        for (j=0; j<count; j++)
+            total += weights[ skip+j ];
+
+        // Round the weights to fixed point, giving any error to the
+        //   largest, so that they sum to exactly WEIGHT_ONE.
+        int* w = &_weights[ idx * _stride ];
+        int sum( 0 ), largest( 0 );
+        for (j=0; j<count; j++)
+        {
+            w[ j ] = (int)( weights[ skip+j ] / total * WEIGHT_ONE + .5 );
+            sum += w[ j ];
+            if (w[ j ] > w[ largest ])
+                largest = j;
+        }
+        w[ largest ] += WEIGHT_ONE - sum;
+
+        _first[ idx ] = first;
+        _count[ idx ] = count;
+    }
+}
+
+
+// The horizontal pass. 'sums' is a source row from the vertical
+//   pass. The callers pass 'n' as a constant, so that once this is
+//   inlined the compiler can unroll the component loop.
+static inline void
+resampleRow( const GLushort* sums, GLubyte* dst, int width,
+        const Contributions& contrib, int n )
+{
+    const int* weights = &contrib._weights[ 0 ];
+    int x;
+    for (x=0; x<width; x++, dst+=n, weights+=contrib._stride)
+    {
+        const GLushort* src = sums + contrib._first[ x ] * n;
+        const int count = contrib._count[ x ];
+        int c;
+        for (c=0; c<n; c++)
+        {
+            int total( 1 << (HORIZONTAL_SHIFT-1) );
+            int j;
+            for (j=0; j<count; j++)
+                total += weights[ j ] * src[ j*n + c ];
+            dst[ c ] = (GLubyte)( total >> HORIZONTAL_SHIFT );
+        }
+    }
+}
+
+
+// Resamples a range of destination rows.
+class ResampleTask : public RangeTask
+{
+public:
+    ResampleTask( const GLubyte* src, GLsizei srcWidth, GLubyte* dst, GLsizei dstWidth,
+            int components, const Contributions& columns, const Contributions& rows )
+      : _src( src ), _srcWidth( srcWidth ), _dst( dst ), _dstWidth( dstWidth ),
+        _n( components ), _columns( columns ), _rows( rows ) {}
+
+    virtual void run( int begin, int end )
+    {
+        const int n( _n );
+        const int rowBytes( _srcWidth * n );
+        std::vector< int > totals( rowBytes );
+        std::vector< GLushort > sums( rowBytes );
+
+        int y;
+        for (y=begin; y<end; y++)
+        {
+            // Vertical pass.
+            const int* weights = &_rows._weights[ y * _rows._stride ];
+            const GLubyte* src = _src + _rows._first[ y ] * rowBytes;
+            int k;
+            for (k=0; k<rowBytes; k++)
+                totals[ k ] = weights[ 0 ] * src[ k ];
+            int j;
+            for (j=1; j<_rows._count[ y ]; j++)
+            {
+                src += rowBytes;
+                const int w = weights[ j ];
+                for (k=0; k<rowBytes; k++)
+                    totals[ k ] += w * src[ k ];
+            }
+            for (k=0; k<rowBytes; k++)
+                sums[ k ] = (GLushort)( (totals[ k ] + (1 << (VERTICAL_SHIFT-1))) >> VERTICAL_SHIFT );
+
+            GLubyte* dst = _dst + y * _dstWidth * n;
+            switch (n)
+            {
+            case 4: resampleRow( &sums[ 0 ], dst, _dstWidth, _columns, 4 ); break;
+            case 3: resampleRow( &sums[ 0 ], dst, _dstWidth, _columns, 3 ); break;
+            case 2: resampleRow( &sums[ 0 ], dst, _dstWidth, _columns, 2 ); break;
+            default: resampleRow( &sums[ 0 ], dst, _dstWidth, _columns, 1 ); break;
+            }
+        }
+    }
+
+protected:
+    const GLubyte* _src;
+    GLsizei _srcWidth;
+    GLubyte* _dst;
+    GLsizei _dstWidth;
+    int _n;
+    const Contributions& _columns;
+    const Contributions& _rows;
+};
+
+
+bool
+isResampleSupported( GLenum format, GLenum type )
+{
+    return( (type == GL_UNSIGNED_BYTE) && (imageComponents( format ) > 0) );
+}
+
+bool
+resampleImage( const GLvoid* src, GLsizei srcWidth, GLsizei srcHeight,
+        GLenum format, GLenum type, GLvoid* dst, GLsizei dstWidth, GLsizei dstHeight )
+{
+    if ( !isResampleSupported( format, type ) || (src == NULL) || (dst == NULL) ||
+            (srcWidth <= 0) || (srcHeight <= 0) || (dstWidth <= 0) || (dstHeight <= 0) )
+        return false;
+
+    const int n = imageComponents( format );
+    const Contributions columns( srcWidth, dstWidth );
+    const Contributions rows( srcHeight, dstHeight );
+
+    ResampleTask task( (const GLubyte*) src, srcWidth, (GLubyte*) dst, dstWidth,
+            n, columns, rows );
+    parallelFor( task, dstHeight,
+            PARALLEL_GRAIN_BYTES / ((srcWidth + dstWidth) * n) + 1 );
+
+    return true;
+}
+
+
+void
+scaleImage( GLenum format, GLsizei widthIn, GLsizei heightIn, GLenum typeIn,
+        const GLvoid* dataIn, GLsizei widthOut, GLsizei heightOut,
+        GLenum typeOut, GLvoid* dataOut )
+{
+    if ( (typeIn == typeOut) && resampleImage( dataIn, widthIn, heightIn,
+            format, typeIn, dataOut, widthOut, heightOut ) )
+        return;
+
+    // gluScaleImage() follows the pixel store state.
+    GLint packAlignment, unpackAlignment;
+    glGetIntegerv( GL_PACK_ALIGNMENT, &packAlignment );
+    glGetIntegerv( GL_UNPACK_ALIGNMENT, &unpackAlignment );
+    glPixelStorei( GL_PACK_ALIGNMENT, 1 );
+    glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+
+    gluScaleImage( format, widthIn, heightIn, typeIn, dataIn,
+            widthOut, heightOut, typeOut, dataOut );
+
+    glPixelStorei( GL_PACK_ALIGNMENT, packAlignment );
+    glPixelStorei( GL_UNPACK_ALIGNMENT, unpackAlignment );
+
+    OGLDIF_CHECK_ERROR;
+}
+
+
+}
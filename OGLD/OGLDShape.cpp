@@ -13,7 +13,13 @@
 #include "OGLDPlatformGL.h"
 #include "OGLDif.h"
 #include "OGLDShape.h"
+#include "OGLDShapeCache.h"
+#include "OGLDBuildThread.h"
+#include "OGLDMeshCache.h"
+#include "OGLDInstanceBuffer.h"
 #include <algorithm>
+#include <math.h>
+#include <string.h>
 
 
 
@@ -21,13 +27,57 @@ namespace ogld
 {
 
 
+bool Shape::_lodProjSet( false );
+double Shape::_lodProj[ 16 ];
+bool Shape::_lodViewportSet( false );
+GLint Shape::_lodViewport[ 4 ];
+
+
 Shape::Shape()
-  : _numTextures( 1 )
+  : _numTextures( 1 ),
+    _vertexFormat( FloatVertexFormat ),
+    _positionError( 0.f ),
+    _normalError( 0.f ),
+    _texCoordError( 0.f ),
+    _shared( true ),
+    _master( NULL ),
+    _buildJob( NULL ),
+    _cacheEntry( NULL ),
+    _hostDataPolicy( getDefaultHostDataPolicy() ),
+    _hostDataReleased( false ),
+    _lodEnable( false ),
+    _lodPixelError( 1.f ),
+    _lodLevel( 0 ),
+    _lodModelViewSet( false )
 {
+    int idx;
+    for (idx=0; idx<MAX_LODS; idx++)
+        _lods[ idx ] = NULL;
 }
 
 Shape::~Shape()
 {
+    cancelBuild();
+    if (_buildJob)
+        delete _buildJob;
+    _buildJob = NULL;
+
+    // Derived class destructors have freed any arrays within it.
+    if (_cacheEntry)
+        delete _cacheEntry;
+    _cacheEntry = NULL;
+
+    int idx;
+    for (idx=0; idx<MAX_LODS; idx++)
+    {
+        if (_lods[ idx ])
+            delete _lods[ idx ];
+        _lods[ idx ] = NULL;
+    }
+
+    if (_master)
+        ShapeCache::instance()->release( _shareKey );
+    _master = NULL;
 }
 
 
@@ -43,5 +93,432 @@ Shape::getTextures() const
     return _numTextures;
 }
 
+void
+Shape::setShared( bool shared )
+{
+    _shared = shared;
+}
+
+bool
+Shape::getShared() const
+{
+    return _shared;
+}
+
+VertexFormat
+Shape::getVertexFormat() const
+{
+    return _vertexFormat;
+}
+
+void
+Shape::getVertexFormatError( float& position, float& normal, float& texCoord ) const
+{
+    if (_master)
+    {
+        _master->getVertexFormatError( position, normal, texCoord );
+        return;
+    }
+
+    position = _positionError;
+    normal = _normalError;
+    texCoord = _texCoordError;
+}
+
+void
+Shape::setLOD( bool enable, float pixelError )
+{
+    _lodEnable = enable;
+    _lodPixelError = pixelError;
+}
+
+bool
+Shape::getLOD() const
+{
+    return _lodEnable;
+}
+
+float
+Shape::getLODPixelError() const
+{
+    return _lodPixelError;
+}
+
+int
+Shape::getLODLevel() const
+{
+    return _lodLevel;
+}
+
+const Bound&
+Shape::getBound() const
+{
+    return _bound;
+}
+
+float
+Shape::getBoundingRadius() const
+{
+    if (_bound.isEmpty())
+        return 0.f;
+
+    const float* center = _bound.getCenter();
+    return( (float) sqrt( center[0]*center[0] + center[1]*center[1] +
+            center[2]*center[2] ) + _bound.getRadius() );
+}
+
+
+void
+Shape::drawInstanced( int count, InstanceBuffer& instances )
+{
+    if (count > instances.getCount())
+        count = instances.getCount();
+    if (count <= 0)
+        return;
+
+    // Every instance would draw at the level of detail chosen for
+    //   the current matrix, so LOD Shapes draw one at a time.
+    if ( !_lodEnable && (_vertexFormat == FloatVertexFormat) &&
+            OGLDif::instance()->isInstancingSupported() )
+    {
+        if (drawInstancedElements( count, instances ))
+            return;
+    }
+
+    // GL_TRANSFORM_BIT restores the caller's matrix mode.
+    glPushAttrib( GL_CURRENT_BIT | GL_TRANSFORM_BIT );
+    glMatrixMode( GL_MODELVIEW );
+
+    int idx;
+    for (idx=0; idx<count; idx++)
+    {
+        glPushMatrix();
+        glMultMatrixf( instances.getMatrix( idx ) );
+        glColor4fv( instances.getColor( idx ) );
+        draw();
+        glPopMatrix();
+    }
+
+    glPopAttrib();
+}
+
+bool
+Shape::drawInstancedElements( int count, InstanceBuffer& instances )
+{
+    return false;
+}
+
+
+BuildJob*
+Shape::buildAsync()
+{
+    if (_buildJob)
+        return _buildJob;
+
+    if (acquireMaster())
+        return( _master->buildAsync() );
+
+    _buildJob = new BuildJob( this );
+    BuildThread::instance()->submit( _buildJob );
+    return _buildJob;
+}
+
+
+void
+Shape::setHostDataPolicy( HostDataPolicy policy )
+{
+    _hostDataPolicy = policy;
+}
+
+HostDataPolicy
+Shape::getHostDataPolicy() const
+{
+    return _hostDataPolicy;
+}
+
+void
+Shape::contextLost()
+{
+    int idx;
+    for (idx=0; idx<MAX_LODS; idx++)
+    {
+        if (_lods[ idx ])
+            _lods[ idx ]->contextLost();
+    }
+
+    if (_master)
+    {
+        _master->contextLost();
+        return;
+    }
+
+    if (_hostDataReleased)
+    {
+        // Forget the finished build, so that finishBuild()
+        //   tessellates (or reads the MeshCache) again.
+        cancelBuild();
+        delete _buildJob;
+        _buildJob = NULL;
+        _hostDataReleased = false;
+    }
+}
+
+void
+Shape::releaseHostData()
+{
+    if (_hostDataPolicy == ReleaseHostData)
+        _hostDataReleased = freeHostData();
+
+    if ( _hostDataReleased && _cacheEntry )
+    {
+        delete _cacheEntry;
+        _cacheEntry = NULL;
+    }
+}
+
+bool
+Shape::freeHostData()
+{
+    return false;
+}
+
+
+bool
+Shape::acquireMaster()
+{
+    if (_master)
+        return true;
+
+    if (!_shared)
+        return false;
+
+    if (!getShareKey( _shareKey ))
+        return false;
+
+    _master = ShapeCache::instance()->acquire( _shareKey, this );
+    return( _master != NULL );
+}
+
+bool
+Shape::getShareKey( std::string& key ) const
+{
+    return false;
+}
+
+Shape*
+Shape::createMaster() const
+{
+    return NULL;
+}
+
+
+bool
+Shape::buildGeometry()
+{
+    return false;
+}
+
+bool
+Shape::finishBuild()
+{
+    if (_buildJob == NULL)
+    {
+        if (!buildCachedGeometry())
+            return false;
+
+        // Record a finished job, so that a later buildAsync() doesn't
+        //   tessellate again.
+        _buildJob = new BuildJob( this );
+        _buildJob->_state = BuildJob::Done;
+        _buildJob->_result = true;
+        return true;
+    }
+
+    if (!_buildJob->isDone())
+        return false;
+
+    return _buildJob->getResult();
+}
+
+bool
+Shape::buildCachedGeometry()
+{
+    MeshCache* cache = MeshCache::instance();
+    std::string key;
+    if ( !cache->getEnabled() || !getCacheKey( key ) )
+        return buildGeometry();
+
+    MeshCacheEntry* entry = cache->load( key );
+    if (entry)
+    {
+        // Keep the entry mapped; the loaded arrays may point into it.
+        if (loadGeometry( *entry ))
+        {
+            _cacheEntry = entry;
+            return true;
+        }
+        delete entry;
+        cache->discard( key );
+    }
+
+    if (!buildGeometry())
+        return false;
+
+    MeshCacheWriter writer;
+    if (saveGeometry( writer ))
+        cache->store( key, writer );
+    return true;
+}
+
+bool
+Shape::getCacheKey( std::string& key ) const
+{
+    return getShareKey( key );
+}
+
+bool
+Shape::saveGeometry( MeshCacheWriter& writer ) const
+{
+    return false;
+}
+
+bool
+Shape::loadGeometry( MeshCacheEntry& entry )
+{
+    return false;
+}
+
+void
+Shape::freeHostArray( GLfloat*& data )
+{
+    if ( data && (_cacheEntry == NULL) )
+        delete[] data;
+    data = NULL;
+}
+
+bool
+Shape::getTriangles( int& numVerts, const float*& vertices, const float*& normals,
+        const float*& texCoords, int& texCoordSize, const IndexArray*& indices ) const
+{
+    return false;
+}
+
+void
+Shape::cancelBuild()
+{
+    if (_buildJob)
+        BuildThread::instance()->cancel( _buildJob );
+}
+
+
+bool
+Shape::drawLOD()
+{
+    _lodLevel = 0;
+    if (!_lodEnable)
+        return false;
+
+    GLdouble modelView[ 16 ], proj[ 16 ];
+    GLint viewport[ 4 ];
+    getLODView( modelView, proj, viewport );
+
+    // Largest scale the model-view matrix applies to object units.
+    double scale = 0.;
+    int col;
+    for (col=0; col<3; col++)
+    {
+        const double* c = modelView + col*4;
+        const double len = sqrt( c[0]*c[0] + c[1]*c[1] + c[2]*c[2] );
+        if (len > scale)
+            scale = len;
+    }
+
+    // Pixels per eye coordinate unit, measured at the point of the
+    //   bounding sphere nearest the viewer for perspective projections.
+    double pixelsPerUnit = fabs( proj[5] ) * viewport[3] * .5;
+    if (proj[11] != 0.)
+    {
+        const double nearest = -modelView[14] - getBoundingRadius() * scale;
+        if (nearest <= 0.)
+            // The viewer is inside or beside the bound.
+            return false;
+        pixelsPerUnit /= nearest;
+    }
+    pixelsPerUnit *= scale;
+
+    int level;
+    for (level=MAX_LODS-1; level>0; level--)
+    {
+        const float error = getLODError( level );
+        if ( (error >= 0.f) && (error * pixelsPerUnit <= _lodPixelError) )
+            break;
+    }
+    if (level == 0)
+        return false;
+
+    if (_lods[ level ] == NULL)
+    {
+        _lods[ level ] = createLOD( level );
+        if (_lods[ level ] == NULL)
+            return false;
+        _lods[ level ]->setHostDataPolicy( _hostDataPolicy );
+    }
+
+    _lodLevel = level;
+    _lods[ level ]->draw();
+    return true;
+}
+
+void
+Shape::setLODView( const double* proj, const GLint* viewport )
+{
+    _lodProjSet = (proj != NULL);
+    if (_lodProjSet)
+        memcpy( _lodProj, proj, sizeof( _lodProj ) );
+    _lodViewportSet = (viewport != NULL);
+    if (_lodViewportSet)
+        memcpy( _lodViewport, viewport, sizeof( _lodViewport ) );
+}
+
+void
+Shape::setLODModelView( const double* modelView )
+{
+    _lodModelViewSet = (modelView != NULL);
+    if (_lodModelViewSet)
+        memcpy( _lodModelView, modelView, sizeof( _lodModelView ) );
+}
+
+void
+Shape::getLODView( double* modelView, double* proj, GLint* viewport )
+{
+    if (_lodModelViewSet)
+        memcpy( modelView, _lodModelView, sizeof( _lodModelView ) );
+    else
+        glGetDoublev( GL_MODELVIEW_MATRIX, modelView );
+    _lodModelViewSet = false;
+
+    if (_lodProjSet)
+        memcpy( proj, _lodProj, sizeof( _lodProj ) );
+    else
+        glGetDoublev( GL_PROJECTION_MATRIX, proj );
+
+    if (_lodViewportSet)
+        memcpy( viewport, _lodViewport, sizeof( _lodViewport ) );
+    else
+        glGetIntegerv( GL_VIEWPORT, viewport );
+}
+
+float
+Shape::getLODError( int level ) const
+{
+    return( (level == 0) ? 0.f : -1.f );
+}
+
+Shape*
+Shape::createLOD( int level ) const
+{
+    return NULL;
+}
+
 
 }
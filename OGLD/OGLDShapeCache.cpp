@@ -0,0 +1,85 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+// 
+
+
+#include "OGLDShapeCache.h"
+#include "OGLDShape.h"
+#include <assert.h>
+
+
+
+namespace ogld
+{
+
+
+ShapeCache* ShapeCache::_instance = 0;
+
+
+ShapeCache*
+ShapeCache::instance()
+{
+    if (!_instance)
+        _instance = new ShapeCache;
+
+    return _instance;
+}
+
+
+ShapeCache::ShapeCache()
+{
+}
+
+
+Shape*
+ShapeCache::acquire( const std::string& key, const Shape* proto )
+{
+    EntryMap::iterator it = _entries.find( key );
+    if (it == _entries.end())
+    {
+        Shape* master = proto->createMaster();
+        if (master == NULL)
+            return NULL;
+        master->setHostDataPolicy( proto->getHostDataPolicy() );
+
+        Entry entry;
+        entry._master = master;
+        entry._refCount = 0;
+        it = _entries.insert( EntryMap::value_type( key, entry ) ).first;
+    }
+
+    it->second._refCount++;
+    return it->second._master;
+}
+
+void
+ShapeCache::release( const std::string& key )
+{
+    EntryMap::iterator it = _entries.find( key );
+    assert( it != _entries.end() );
+    if (it == _entries.end())
+        return;
+
+    if (--(it->second._refCount) == 0)
+    {
+        delete it->second._master;
+        _entries.erase( it );
+    }
+}
+
+int
+ShapeCache::getSize() const
+{
+    return (int) _entries.size();
+}
+
+
+}
@@ -0,0 +1,307 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+//
+
+#include "OGLDPlatformGL.h"
+#include "OGLDif.h"
+#include "OGLDShapeTuner.h"
+#include "OGLDSphere.h"
+#include <fstream>
+#include <sstream>
+#include <string>
+
+// Timing differs by platform
+#if defined( WIN32 ) && !defined( __CYGWIN__ )
+  #include <windows.h>
+#else
+  #include <sys/time.h>
+#endif
+
+
+
+namespace ogld
+{
+
+
+// calibrate() draws a DRAWS-draw batch of the representative Sphere
+//   TRIALS times per path, and keeps the fastest batch. Subdivision 3
+//   gives 642 vertices and 1280 triangles, about the size of the
+//   Shapes in the example scenes.
+static const int TRIALS( 5 );
+static const int DRAWS( 200 );
+static const int SUBDIVISIONS( 3 );
+
+
+// Seconds since an arbitrary start.
+static double
+now()
+{
+#if defined( WIN32 ) && !defined( __CYGWIN__ )
+    LARGE_INTEGER count, frequency;
+    QueryPerformanceCounter( &count );
+    QueryPerformanceFrequency( &frequency );
+    return( (double) count.QuadPart / (double) frequency.QuadPart );
+#else
+    struct timeval tv;
+    gettimeofday( &tv, NULL );
+    return( tv.tv_sec + tv.tv_usec * 1e-6 );
+#endif
+}
+
+// The results file stores versions as their numbers, for example
+//   13 for Ver13, so that it doesn't depend on the enum's values.
+static int
+versionNumber( OpenGLVersion version )
+{
+    switch (version)
+    {
+    case Ver10: return 10;
+    case Ver11: return 11;
+    case Ver12: return 12;
+    case Ver13: return 13;
+    case Ver14: return 14;
+    case Ver15: return 15;
+    case Ver20: return 20;
+    default: return 0;
+    }
+}
+
+static OpenGLVersion
+versionFromNumber( int number )
+{
+    switch (number)
+    {
+    case 10: return Ver10;
+    case 11: return Ver11;
+    case 12: return Ver12;
+    case 13: return Ver13;
+    case 14: return Ver14;
+    case 15: return Ver15;
+    case 20: return Ver20;
+    default: return VerUnknown;
+    }
+}
+
+
+ShapeTuner* ShapeTuner::_instance = 0;
+
+ShapeTuner*
+ShapeTuner::instance()
+{
+    if (!_instance)
+        _instance = new ShapeTuner;
+
+    return _instance;
+}
+
+ShapeTuner::ShapeTuner()
+  : _loaded( false ),
+    _override( VerUnknown )
+{
+    int idx;
+    for (idx=0; idx<=VerExtended; idx++)
+        _times[ idx ] = -1.;
+}
+
+
+void
+ShapeTuner::setFileName( const std::string& fileName )
+{
+    _fileName = fileName;
+    _results.clear();
+    _loaded = false;
+}
+
+const std::string&
+ShapeTuner::getFileName() const
+{
+    return _fileName;
+}
+
+
+OpenGLVersion
+ShapeTuner::calibrate( bool force )
+{
+    const OpenGLVersion version = OGLDif::instance()->getVersion();
+    const std::string key = getRendererKey();
+    if (key.empty())
+        return version;
+
+    int idx;
+    for (idx=0; idx<=VerExtended; idx++)
+        _times[ idx ] = -1.;
+
+    if (!_loaded)
+        load();
+    ResultMap::const_iterator it = _results.find( key );
+    if ( !force && (it != _results.end()) && (it->second <= version) )
+        return it->second;
+
+    // Only one path to choose from.
+    if (version < Ver15)
+        return version;
+
+    glPushAttrib( GL_ALL_ATTRIB_BITS );
+    glMatrixMode( GL_PROJECTION );
+    glPushMatrix();
+    glLoadIdentity();
+    glMatrixMode( GL_MODELVIEW );
+    glPushMatrix();
+    glLoadIdentity();
+
+    // A single pixel keeps rasterization from hiding the difference
+    //   in vertex submission and transformation.
+    glViewport( 0, 0, 1, 1 );
+    glDisable( GL_DEPTH_TEST );
+    glDisable( GL_TEXTURE_2D );
+
+    _times[ Ver13 ] = timePath( Ver13 );
+    _times[ Ver15 ] = timePath( Ver15 );
+
+    glMatrixMode( GL_PROJECTION );
+    glPopMatrix();
+    glMatrixMode( GL_MODELVIEW );
+    glPopMatrix();
+    glPopAttrib();
+
+    OGLDIF_CHECK_ERROR;
+
+    setShapeVersion( (_times[ Ver13 ] < _times[ Ver15 ]) ? Ver13 : Ver15 );
+    return _results[ key ];
+}
+
+void
+ShapeTuner::setShapeVersion( OpenGLVersion version )
+{
+    const std::string key = getRendererKey();
+    if (key.empty())
+        return;
+
+    if (!_loaded)
+        load();
+    _results[ key ] = version;
+    save();
+}
+
+OpenGLVersion
+ShapeTuner::getShapeVersion()
+{
+    if (_override != VerUnknown)
+        return _override;
+
+    const OpenGLVersion version = OGLDif::instance()->getVersion();
+    if ( !_loaded && !_fileName.empty() )
+        load();
+    if (_results.empty())
+        return version;
+
+    ResultMap::const_iterator it = _results.find( getRendererKey() );
+    if ( (it == _results.end()) || (it->second > version) )
+        return version;
+    return it->second;
+}
+
+double
+ShapeTuner::getTime( OpenGLVersion version ) const
+{
+    if ( (version < VerUnknown) || (version > VerExtended) )
+        return -1.;
+    return _times[ version ];
+}
+
+
+std::string
+ShapeTuner::getRendererKey()
+{
+    const GLubyte* renderer = glGetString( GL_RENDERER );
+    const GLubyte* version = glGetString( GL_VERSION );
+    if ( (renderer == NULL) || (version == NULL) )
+        return std::string( "" );
+
+    return( std::string( (const char*) renderer ) + " / " + std::string( (const char*) version ) );
+}
+
+double
+ShapeTuner::timePath( OpenGLVersion version )
+{
+    _override = version;
+    Sphere* sphere = Sphere::create( 1.f, SUBDIVISIONS );
+    _override = VerUnknown;
+
+    // A shared Sphere might draw the other path's master.
+    sphere->setShared( false );
+
+    // The first draw() tessellates and stores the data.
+    sphere->draw();
+    glFinish();
+
+    double best = -1.;
+    int trial;
+    for (trial=0; trial<TRIALS; trial++)
+    {
+        const double start = now();
+        int idx;
+        for (idx=0; idx<DRAWS; idx++)
+            sphere->draw();
+        glFinish();
+
+        const double ms = (now() - start) * 1000. / DRAWS;
+        if ( (best < 0.) || (ms < best) )
+            best = ms;
+    }
+
+    delete sphere;
+
+    return best;
+}
+
+
+void
+ShapeTuner::load()
+{
+    _loaded = true;
+    if (_fileName.empty())
+        return;
+
+    // Each line is a version number, a tab, and a renderer key.
+    std::ifstream in( _fileName.c_str() );
+    std::string line;
+    while (std::getline( in, line ))
+    {
+        const std::string::size_type tab = line.find( '\t' );
+        if (tab == std::string::npos)
+            continue;
+
+        int number( 0 );
+        std::istringstream numberStream( line.substr( 0, tab ) );
+        numberStream >> number;
+        const OpenGLVersion version = versionFromNumber( number );
+        if (version != VerUnknown)
+            _results[ line.substr( tab+1 ) ] = version;
+    }
+}
+
+bool
+ShapeTuner::save() const
+{
+    if (_fileName.empty())
+        return true;
+
+    std::ofstream out( _fileName.c_str() );
+    ResultMap::const_iterator it;
+    for (it=_results.begin(); it!=_results.end(); it++)
+        out << versionNumber( it->second ) << '\t' << it->first << std::endl;
+
+    return( !out.fail() );
+}
+
+
+}
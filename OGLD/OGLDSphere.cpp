@@ -19,9 +19,13 @@
 #include "OGLDSphere.h"
 #include "OGLDif.h"
 #include "OGLDMath.h"
+#include "OGLDVertexCache.h"
+#include "OGLDMeshCache.h"
+#include "OGLDInstanceBuffer.h"
+#include "OGLDShapeTuner.h"
 #include <math.h>
-#include <map>
 #include <assert.h>
+#include <stdio.h>
 #include <string.h>
 
 
@@ -30,37 +34,43 @@ namespace ogld
 {
 
 
+// Marks an unused slot in the Sphere::buildData() edge table.
+static const GLuint EMPTY_EDGE( 0xffffffff );
+
+
 // Static factory creation methods
 Sphere*
-Sphere::create( float radius, int subdivisions )
+Sphere::create( float radius, int subdivisions, VertexFormat format )
 {
-    switch (OGLDif::instance()->getVersion())
+    Sphere* sphere( NULL );
+
+    switch (ShapeTuner::instance()->getShapeVersion())
     {
 
     case VerExtended:
     case Ver20:
     case Ver15:
 #ifdef GL_VERSION_1_5
-        return new Sphere15( radius, subdivisions );
+        sphere = new Sphere15( radius, subdivisions );
         break;
 #endif
 
     case Ver14:
     case Ver13:
 #ifdef GL_VERSION_1_3
-        return new Sphere13( radius, subdivisions );
+        sphere = new Sphere13( radius, subdivisions );
         break;
 #endif
 
     case Ver12:
 #ifdef GL_VERSION_1_2
-        return new Sphere12( radius, subdivisions );
+        sphere = new Sphere12( radius, subdivisions );
         break;
 #endif
 
     case Ver11:
 #ifdef GL_VERSION_1_1
-        return new Sphere( radius, subdivisions );
+        sphere = new Sphere( radius, subdivisions );
         break;
 #endif
 
@@ -71,6 +81,9 @@ Sphere::create( float radius, int subdivisions )
         return NULL;
         break;
     }
+
+    sphere->_vertexFormat = format;
+    return sphere;
 }
 
 Sphere::Sphere( float radius, int subdivisions )
@@ -79,7 +92,6 @@ Sphere::Sphere( float radius, int subdivisions )
     _vertices( NULL ),
     _normals( NULL ),
     _texCoords( NULL ),
-    _indices( NULL ),
     _idxStart( 0 ),
     _idxEnd( 0 ),
     _valid( false ),
@@ -91,60 +103,239 @@ Sphere::Sphere( float radius, int subdivisions )
 
     if (_subdivisions < 0)
         _subdivisions = 0;
+
+    const float r = (float) fabs( _radius );
+    _bound.setBox( -r, -r, -r, r, r, r );
+    _bound.setSphere( 0.f, 0.f, 0.f, r );
 }
 
 Sphere::~Sphere()
 {
-    if ( _valid )
-    {
-        if (_dListAllocated)
-        {
-            glDeleteLists( _dList, 1 );
-            _dListAllocated = false;
-        }
+    cancelBuild();
 
-        if (_vertices)
-            delete[] _vertices;
-        if (_normals)
-            delete[] _normals;
-        if (_texCoords)
-            delete[] _texCoords;
-        if (_indices)
-            delete[] _indices;
-        _vertices = _normals = _texCoords = NULL;
-        _indices = NULL;
-        _valid = false;
+    if (_dListAllocated)
+    {
+        glDeleteLists( _dList, 1 );
+        _dListAllocated = false;
     }
+
+    freeHostArray( _vertices );
+    freeHostArray( _normals );
+    freeHostArray( _texCoords );
+    _indices.clear();
+    _valid = false;
 }
 
 void
 Sphere::draw()
 {
+    if (drawLOD())
+        return;
+
     if (!_valid)
     {
         if (!init())
             return;
     }
 
+    if (_master)
+    {
+        _master->draw();
+        return;
+    }
+
     glCallList( _dList );
 
     OGLDIF_CHECK_ERROR;
 }
 
 
+bool
+Sphere::getShareKey( std::string& key ) const
+{
+    char buf[ 128 ];
+    sprintf( buf, "Sphere %.9g %d %d %d", _radius, _subdivisions, _numTextures, (int) _vertexFormat );
+    key = buf;
+    return true;
+}
+
+Shape*
+Sphere::createMaster() const
+{
+    Sphere* master = Sphere::create( _radius, _subdivisions, _vertexFormat );
+    master->setShared( false );
+    master->setTextures( _numTextures );
+    return master;
+}
+
+bool
+Sphere::saveGeometry( MeshCacheWriter& writer ) const
+{
+    const int counts[ 4 ] = { _numVerts, _numIndices, (int) _idxStart, (int) _idxEnd };
+    writer.addInts( counts, 4 );
+    writer.addFloats( _vertices, _numVerts * 3 );
+    writer.addFloats( _normals, _numVerts * 3 );
+    writer.addFloats( _texCoords, _numVerts * 3 );
+    writer.addIndices( _indices );
+    return true;
+}
+
+bool
+Sphere::loadGeometry( MeshCacheEntry& entry )
+{
+    int counts[ 4 ];
+    if ( !entry.getInts( counts, 4 ) || (counts[0] < 0) )
+        return false;
+    const GLfloat* vertices = entry.getFloats( counts[0] * 3 );
+    const GLfloat* normals = vertices ? entry.getFloats( counts[0] * 3 ) : NULL;
+    const GLfloat* texCoords = normals ? entry.getFloats( counts[0] * 3 ) : NULL;
+    if ( (texCoords == NULL) || !entry.getIndices( _indices ) )
+        return false;
+    if (_indices.getCount() != counts[1])
+    {
+        _indices.clear();
+        return false;
+    }
+
+    _numVerts = counts[0];
+    _numIndices = counts[1];
+    _idxStart = counts[2];
+    _idxEnd = counts[3];
+    _vertices = (GLfloat*) vertices;
+    _normals = (GLfloat*) normals;
+    _texCoords = (GLfloat*) texCoords;
+    return true;
+}
+
+bool
+Sphere::getTriangles( int& numVerts, const float*& vertices, const float*& normals,
+        const float*& texCoords, int& texCoordSize, const IndexArray*& indices ) const
+{
+    numVerts = _numVerts;
+    vertices = _vertices;
+    normals = _normals;
+    texCoords = _texCoords;
+    texCoordSize = 3;
+    indices = &_indices;
+    return( _vertices != NULL );
+}
+
+float
+Sphere::getLODError( int level ) const
+{
+    const int subdivisions = _subdivisions - level;
+    if ( (level < 0) || (subdivisions < 0) )
+        return -1.f;
+
+    // The surface is farthest from the sphere at the center of each
+    //   triangle. The angle between a triangle's vertex and its center
+    //   is its edge angle over sqrt(3); icosahedron edges subtend
+    //   atan(2) radians, halved by each subdivision.
+    const double edgeAngle = atan( 2. ) / (double)( 1 << subdivisions );
+    return( (float)( _radius * (1. - cos( edgeAngle / sqrt( 3. ) )) ) );
+}
+
+Shape*
+Sphere::createLOD( int level ) const
+{
+    if (getLODError( level ) < 0.f)
+        return NULL;
+
+    Sphere* lod = Sphere::create( _radius, _subdivisions - level, _vertexFormat );
+    lod->setShared( _shared );
+    lod->setTextures( _numTextures );
+    return lod;
+}
+
+void
+Sphere::contextLost()
+{
+    Shape::contextLost();
+    if (_master)
+        return;
+
+    // The display list or buffer objects went with the context.
+    _dListAllocated = false;
+    _valid = false;
+}
+
+bool
+Sphere::freeHostData()
+{
+    freeHostArray( _vertices );
+    freeHostArray( _normals );
+    freeHostArray( _texCoords );
+    _indices.releaseData();
+    return true;
+}
+
 bool
 Sphere::init()
 {
-    if (!buildData())
+    if (acquireMaster())
+        return( _valid = true );
+
+    // Tessellate now, unless buildAsync() already started it.
+    if (!finishBuild())
         return false;
 
     if (!storeData())
         return false;
 
+    releaseHostData();
+    return true;
+}
+
+bool
+Sphere::buildGeometry()
+{
+    if (!buildData())
+        return false;
+
+    // Subdivision order scatters each vertex's triangles across the
+    //   index array. Reorder the triangles for the post-transform
+    //   vertex cache, then renumber the vertices in order of first use.
+    optimizeTriangleList( _indices.getUIntData(), _numIndices, _numVerts,
+            _vertices, _normals, _texCoords, 3 );
+
+    _indices.pack( _numVerts );
+
     return true;
 }
 
 
+GLuint
+Sphere::midpoint( EdgeEntry* edgeTable, int tableBits, GLuint a, GLuint b )
+{
+    if (a > b)
+    {
+        GLuint t = a;
+        a = b;
+        b = t;
+    }
+
+    // Multiplicative (Fibonacci) hash of the edge. The high bits
+    //   of the product are the well-mixed ones.
+    const unsigned int mask = (1 << tableBits) - 1;
+    unsigned int slot = (((a * 2654435769u) ^ b) * 2654435769u) >> (32 - tableBits);
+
+    while (edgeTable[slot]._a != EMPTY_EDGE)
+    {
+        if ( (edgeTable[slot]._a == a) && (edgeTable[slot]._b == b) )
+            return edgeTable[slot]._vert;
+        slot = (slot + 1) & mask;
+    }
+
+    // First time we've seen this edge. Create its midpoint vertex.
+    edgeTable[slot]._a = a;
+    edgeTable[slot]._b = b;
+    edgeTable[slot]._vert = ++_idxEnd;
+    average3fv( &(_vertices[ _idxEnd*3 ]), &(_vertices[ a*3 ]), &(_vertices[ b*3 ]) );
+
+    return edgeTable[slot]._vert;
+}
+
+
 bool
 Sphere::buildData()
 {
@@ -166,16 +357,12 @@ Sphere::buildData()
     _numVerts = 12;
     _numIndices = faces * 3;
 
-    if (_numIndices > 65535)
-        return false;
-
 
     int vertsSize = _numVerts * 3;
     _vertices = new GLfloat[ vertsSize ];
     memcpy( _vertices, vertData, sizeof( vertData ) );
 
-    _indices = new GLushort[ _numIndices ];
-    GLushort* indexPtr = _indices;
+    GLuint* indexPtr = _indices.allocate( _numIndices );
     *indexPtr++ = 0;
     *indexPtr++ = 7;
     *indexPtr++ = 4;
@@ -245,47 +432,48 @@ Sphere::buildData()
     int i;
     for (i=_subdivisions; i; i--)
     {
-        // Make a map of edges
-        typedef std::map< unsigned int, GLushort> EdgeMapType;
-        EdgeMapType edgeMap;
-        indexPtr = _indices;
-        int f;
-        for (f=faces; f; f--)
-        {
-            unsigned int key = makeKey(indexPtr[0], indexPtr[1]);
-            if (edgeMap.find( key ) == edgeMap.end())
-                edgeMap[key] = ++_idxEnd;
-
-            key = makeKey(indexPtr[1], indexPtr[2]);
-            if (edgeMap.find( key ) == edgeMap.end())
-                edgeMap[key] = ++_idxEnd;
-            
-            key = makeKey(indexPtr[2], indexPtr[0]);
-            if (edgeMap.find( key ) == edgeMap.end())
-                edgeMap[key] = ++_idxEnd;
-
-            indexPtr += 3;
-        }
+        // Every face has three edges and every edge is shared by two
+        //   faces, so this level adds exactly faces*3/2 new vertices.
+        const int numEdges = faces * 3 / 2;
+
+        // Make a table of edges. Open addressing with linear probing
+        //   into a single power-of-2 sized array keeps the whole table
+        //   in one allocation and each lookup in one or two cache lines.
+        //   Keep the load factor at or below 1/2.
+        int tableBits = 1;
+        while ( (1 << tableBits) < numEdges * 2 )
+            tableBits++;
+        const unsigned int tableSize = 1 << tableBits;
+        EdgeEntry* edgeTable = new EdgeEntry[ tableSize ];
+        unsigned int t;
+        for (t=0; t<tableSize; t++)
+            edgeTable[t]._a = EMPTY_EDGE;
 
         GLfloat* oldVerts = _vertices;
-        GLushort* oldIndices = _indices;
+        IndexArray oldIndices;
+        oldIndices.swap( _indices );
 
-        _numVerts += (int)(faces * 1.5f);
+        _numVerts += numEdges;
         int newFaces = faces * 4;
         _numIndices = newFaces * 3;
 
+        // Copy old vertices into new vertices. New vertices at the
+        //   midpoint of each edge are appended as edges are found.
+        _vertices = new GLfloat[ _numVerts * 3 ];
+        memcpy( _vertices, oldVerts, vertsSize * sizeof( GLfloat ) );
+
         // Create new indices
-        _indices = new GLushort[ _numIndices ];
-        GLushort* oldIdxPtr = oldIndices;
-        indexPtr = _indices;
+        const GLuint* oldIdxPtr = oldIndices.getUIntData();
+        indexPtr = _indices.allocate( _numIndices );
+        int f;
         for (f=faces; f; f--)
         {
-            GLushort vertA = *oldIdxPtr++;
-            GLushort vertB = *oldIdxPtr++;
-            GLushort vertC = *oldIdxPtr++;
-            GLushort edgeAB = edgeMap[ makeKey(vertA,vertB) ];
-            GLushort edgeBC = edgeMap[ makeKey(vertB,vertC) ];
-            GLushort edgeCA = edgeMap[ makeKey(vertC,vertA) ];
+            GLuint vertA = *oldIdxPtr++;
+            GLuint vertB = *oldIdxPtr++;
+            GLuint vertC = *oldIdxPtr++;
+            GLuint edgeAB = midpoint( edgeTable, tableBits, vertA, vertB );
+            GLuint edgeBC = midpoint( edgeTable, tableBits, vertB, vertC );
+            GLuint edgeCA = midpoint( edgeTable, tableBits, vertC, vertA );
 
             *indexPtr++ = vertA;
             *indexPtr++ = edgeAB;
@@ -300,32 +488,13 @@ Sphere::buildData()
             *indexPtr++ = edgeBC;
             *indexPtr++ = vertC;
         }
-
-        // Copy old vertices into new vertices
-        _vertices = new GLfloat[ _numVerts * 3 ];
-        memcpy( _vertices, oldVerts, vertsSize * sizeof( GLfloat ) );
-
-        // Create new vertices at midpoint of each edge
-        EdgeMapType::const_iterator it = edgeMap.begin();
-        while (it != edgeMap.end())
-        {
-            GLushort idxA, idxB;
-            idxA = ((*it).first) >> 16;
-            idxB = ((*it).first) & 0xffff;
-
-            GLfloat* dest = &(_vertices[ ((*it).second * 3) ]);
-            GLfloat* srcA = &(_vertices[idxA*3]);
-            GLfloat* srcB = &(_vertices[idxB*3]);
-            average3fv( dest, srcA, srcB );
-
-            it++;
-        }
+        assert( (int)_idxEnd == _numVerts-1 );
 
 
         faces = newFaces;
         vertsSize = _numVerts * 3;
+        delete[] edgeTable;
         delete[] oldVerts;
-        delete[] oldIndices;
     }
 
 
@@ -379,7 +548,7 @@ Sphere::storeData()
     glTexCoordPointer( 3, GL_FLOAT, 0, _normals );
 
 
-    glDrawElements( GL_TRIANGLES, _numIndices, GL_UNSIGNED_SHORT, _indices );
+    glDrawElements( GL_TRIANGLES, _numIndices, _indices.getType(), _indices.getData() );
 
     glPopClientAttrib();
 
@@ -406,6 +575,7 @@ Sphere12::Sphere12( float radius, int subdivisions )
 
 Sphere12::~Sphere12()
 {
+    cancelBuild();
 }
 
 bool
@@ -429,7 +599,7 @@ Sphere12::storeData()
     glTexCoordPointer( 3, GL_FLOAT, 0, _texCoords );
 
 
-    glDrawRangeElements( GL_TRIANGLES, _idxStart, _idxEnd, _numIndices, GL_UNSIGNED_SHORT, _indices );
+    glDrawRangeElements( GL_TRIANGLES, _idxStart, _idxEnd, _numIndices, _indices.getType(), _indices.getData() );
 
     glPopClientAttrib();
 
@@ -459,6 +629,7 @@ Sphere13::Sphere13( float radius, int subdivisions )
 
 Sphere13::~Sphere13()
 {
+    cancelBuild();
 }
 
 bool
@@ -487,7 +658,7 @@ Sphere13::storeData()
     }
 
 
-    glDrawRangeElements( GL_TRIANGLES, _idxStart, _idxEnd, _numIndices, GL_UNSIGNED_SHORT, _indices );
+    glDrawRangeElements( GL_TRIANGLES, _idxStart, _idxEnd, _numIndices, _indices.getType(), _indices.getData() );
 
     glPopClientAttrib();
 
@@ -509,56 +680,147 @@ Sphere13::storeData()
 #ifdef GL_VERSION_1_5
 
 
-// Static indices into the _vbo vertex buffer array
-int Sphere15::_vertIdx( 0 );
-int Sphere15::_normIdx( 1 );
-int Sphere15::_texIdx( 2 );
-int Sphere15::_idxIdx( 3 );
+// Layout of the interleaved vertex buffer object: three position
+//   floats followed by three normal floats. The unit sphere normals
+//   double as the texture coordinates, so the texture coordinate
+//   array aliases the normals.
+static const int INTERLEAVED_FLOATS( 6 );
+static const unsigned int NORMAL_OFFSET( 3 * sizeof( GLfloat ) );
 
 
 Sphere15::Sphere15( float radius, int subdivisions )
-  : Sphere( radius, subdivisions )
+  : Sphere( radius, subdivisions ),
+    _vertBlock( NULL ),
+    _idxBlock( NULL )
 {
     assert( OGLDif::instance()->getVersion() >= Ver13 );
 }
 
 Sphere15::~Sphere15()
 {
-    if ( _valid )
-        glDeleteBuffers( 4, _vbo );
+    cancelBuild();
+
+    if ( _valid && (_master == NULL) )
+    {
+        BufferArena::instance()->release( _vertBlock );
+        BufferArena::instance()->release( _idxBlock );
+    }
+}
+
+void
+Sphere15::contextLost()
+{
+    // Return the blocks to their lost page. BufferArena::release()
+    //   makes no OpenGL calls.
+    if ( _valid && (_master == NULL) )
+    {
+        BufferArena::instance()->release( _vertBlock );
+        BufferArena::instance()->release( _idxBlock );
+        _vertBlock = _idxBlock = NULL;
+    }
+
+    Sphere::contextLost();
 }
 
 void
 Sphere15::draw()
 {
+    if (drawLOD())
+        return;
+
     if (!_valid)
     {
         if (!init())
             return;
     }
 
+    if (_master)
+    {
+        _master->draw();
+        return;
+    }
+
     glPushClientAttrib( GL_CLIENT_VERTEX_ARRAY_BIT );
 
-    glEnableClientState( GL_VERTEX_ARRAY );
-    glBindBuffer( GL_ARRAY_BUFFER, _vbo[_vertIdx] );
-    glVertexPointer( 3, GL_FLOAT, 0, bufferObjectPtr( 0 ) );
+    if (_vertexFormat == CompactVertexFormat)
+        _compact.pushTransform( _numTextures );
+    setPointers();
 
-    glEnableClientState( GL_NORMAL_ARRAY );
-    glBindBuffer( GL_ARRAY_BUFFER, _vbo[_normIdx] );
-    glNormalPointer( GL_FLOAT, 0, bufferObjectPtr( 0 ) );
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, _idxBlock->getBuffer() );
+    glDrawRangeElements( GL_TRIANGLES, _idxStart, _idxEnd, _numIndices, _indices.getType(), bufferObjectPtr( _idxBlock->getOffset() ) );
 
-    int tIdx;
-    for (tIdx=0; tIdx<_numTextures; tIdx++)
+
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+
+    glPopClientAttrib();
+
+    if (_vertexFormat == CompactVertexFormat)
+        _compact.popTransform( _numTextures );
+
+
+    OGLDIF_CHECK_ERROR;
+}
+
+void
+Sphere15::setPointers() const
+{
+    glBindBuffer( GL_ARRAY_BUFFER, _vertBlock->getBuffer() );
+    const GLuint base = (GLuint) _vertBlock->getOffset();
+
+    if (_vertexFormat == CompactVertexFormat)
+        _compact.setPointers( (const GLubyte*) bufferObjectPtr( base ), _numTextures );
+    else
     {
-        glClientActiveTexture( GL_TEXTURE0 + tIdx );
-        glEnableClientState( GL_TEXTURE_COORD_ARRAY );
-        glBindBuffer( GL_ARRAY_BUFFER, _vbo[_texIdx] );
-        glTexCoordPointer( 3, GL_FLOAT, 0, bufferObjectPtr( 0 ) );
+        const GLsizei stride = INTERLEAVED_FLOATS * sizeof( GLfloat );
+
+        glEnableClientState( GL_VERTEX_ARRAY );
+        glVertexPointer( 3, GL_FLOAT, stride, bufferObjectPtr( base ) );
+
+        glEnableClientState( GL_NORMAL_ARRAY );
+        glNormalPointer( GL_FLOAT, stride, bufferObjectPtr( base + NORMAL_OFFSET ) );
+
+        int tIdx;
+        for (tIdx=0; tIdx<_numTextures; tIdx++)
+        {
+            glClientActiveTexture( GL_TEXTURE0 + tIdx );
+            glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+            glTexCoordPointer( 3, GL_FLOAT, stride, bufferObjectPtr( base + NORMAL_OFFSET ) );
+        }
+    }
+}
+
+bool
+Sphere15::drawInstancedElements( int count, InstanceBuffer& instances )
+{
+#ifdef GL_VERSION_3_3
+    if (!_valid)
+    {
+        // Like draw(), draw nothing until a buildAsync() finishes.
+        if (!init())
+            return true;
     }
 
-    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, _vbo[_idxIdx] );
-    glDrawRangeElements( GL_TRIANGLES, _idxStart, _idxEnd, _numIndices, GL_UNSIGNED_SHORT, 0 );
+    if (_master)
+    {
+        _master->drawInstanced( count, instances );
+        return true;
+    }
 
+    glPushClientAttrib( GL_CLIENT_VERTEX_ARRAY_BIT );
+
+    setPointers();
+    if (!instances.bind())
+    {
+        glBindBuffer( GL_ARRAY_BUFFER, 0 );
+        glPopClientAttrib();
+        return false;
+    }
+
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, _idxBlock->getBuffer() );
+    glDrawElementsInstanced( GL_TRIANGLES, _numIndices, _indices.getType(), bufferObjectPtr( _idxBlock->getOffset() ), count );
+
+    instances.unbind();
 
     glBindBuffer( GL_ARRAY_BUFFER, 0 );
     glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
@@ -567,25 +829,48 @@ Sphere15::draw()
 
 
     OGLDIF_CHECK_ERROR;
-}
 
+    return true;
+#else
+    return false;
+#endif
+}
 
 bool
 Sphere15::storeData()
 {
-    glGenBuffers( 4, _vbo );
-
-    glBindBuffer( GL_ARRAY_BUFFER, _vbo[_normIdx] );
-    glBufferData( GL_ARRAY_BUFFER, _numVerts*3*sizeof(GLfloat), _normals, GL_STATIC_DRAW );
+    if (_vertexFormat == CompactVertexFormat)
+    {
+        _compact.build( _numVerts, _vertices, _normals, _normals, 3 );
+        _vertBlock = BufferArena::instance()->allocate( GL_ARRAY_BUFFER, _compact.getSizeBytes(), _compact.getData() );
+        _compact.releaseData();
+        _compact.getErrors( _positionError, _normalError, _texCoordError );
+    }
+    else
+    {
+        // Interleave the vertex data so that each vertex is fetched
+        //   from one buffer object with a single bind.
+        GLfloat* interleaved = new GLfloat[ _numVerts * INTERLEAVED_FLOATS ];
+        GLfloat* destPtr = interleaved;
+        const GLfloat* vertPtr = _vertices;
+        const GLfloat* normPtr = _normals;
+        int idx;
+        for (idx=0; idx<_numVerts; idx++)
+        {
+            *destPtr++ = *vertPtr++;
+            *destPtr++ = *vertPtr++;
+            *destPtr++ = *vertPtr++;
+            *destPtr++ = *normPtr++;
+            *destPtr++ = *normPtr++;
+            *destPtr++ = *normPtr++;
+        }
 
-    glBindBuffer( GL_ARRAY_BUFFER, _vbo[_vertIdx] );
-    glBufferData( GL_ARRAY_BUFFER, _numVerts*3*sizeof(GLfloat), _vertices, GL_STATIC_DRAW );
+        _vertBlock = BufferArena::instance()->allocate( GL_ARRAY_BUFFER, _numVerts*INTERLEAVED_FLOATS*sizeof(GLfloat), interleaved );
 
-    glBindBuffer( GL_ARRAY_BUFFER, _vbo[_texIdx] );
-    glBufferData( GL_ARRAY_BUFFER, _numVerts*3*sizeof(GLfloat), _normals, GL_STATIC_DRAW );
+        delete[] interleaved;
+    }
 
-    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, _vbo[_idxIdx] );
-    glBufferData( GL_ELEMENT_ARRAY_BUFFER, _numIndices*sizeof(GLushort), _indices, GL_STATIC_DRAW );
+    _idxBlock = BufferArena::instance()->allocate( GL_ELEMENT_ARRAY_BUFFER, _indices.getSizeBytes(), _indices.getData() );
 
 
     glBindBuffer( GL_ARRAY_BUFFER, 0 );
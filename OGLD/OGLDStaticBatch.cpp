@@ -0,0 +1,540 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+// 
+
+#include "OGLDPlatformGL.h"
+#include "OGLDStaticBatch.h"
+#include "OGLDif.h"
+#include "OGLDShapeTuner.h"
+#include <algorithm>
+#include <math.h>
+#include <assert.h>
+#include <string.h>
+
+
+
+namespace ogld
+{
+
+
+// Floats per vertex ahead of the texture coordinates: position,
+//   normal, and RGBA color.
+static const int NORMAL_FLOATS( 3 );
+static const int COLOR_FLOATS( 6 );
+static const int TEXCOORD_FLOATS( 10 );
+
+
+// Orders entries by material, keeping the order of add() calls
+//   within a material.
+class EntryLess
+{
+public:
+    EntryLess( const std::vector< StaticBatch::Material >& materials )
+      : _materials( materials ) {}
+
+    bool operator()( int a, int b ) const
+    {
+        return( _materials[ a ] < _materials[ b ] );
+    }
+
+protected:
+    const std::vector< StaticBatch::Material >& _materials;
+};
+
+// Transforms point 'in' by the column-major 'm'.
+static void
+transformPoint( GLfloat* out, const GLfloat* m, const GLfloat* in )
+{
+    out[0] = m[0]*in[0] + m[4]*in[1] + m[8]*in[2] + m[12];
+    out[1] = m[1]*in[0] + m[5]*in[1] + m[9]*in[2] + m[13];
+    out[2] = m[2]*in[0] + m[6]*in[1] + m[10]*in[2] + m[14];
+}
+
+
+StaticBatch::Material::Material( const GLfloat* color, const GLfloat* specular, GLfloat shininess )
+  : _shininess( shininess )
+{
+    memcpy( _color, color, sizeof( _color ) );
+    memcpy( _specular, specular, sizeof( _specular ) );
+}
+
+bool
+StaticBatch::Material::operator<( const Material& rhs ) const
+{
+    // Only the state draw() sets per group distinguishes materials.
+    int idx;
+    for (idx=0; idx<4; idx++)
+    {
+        if (_specular[ idx ] != rhs._specular[ idx ])
+            return( _specular[ idx ] < rhs._specular[ idx ] );
+    }
+    return( _shininess < rhs._shininess );
+}
+
+bool
+StaticBatch::Material::operator==( const Material& rhs ) const
+{
+    return( !(*this < rhs) && !(rhs < *this) );
+}
+
+
+
+// Static factory creation method
+StaticBatch*
+StaticBatch::create()
+{
+    StaticBatch* batch( NULL );
+
+    switch (ShapeTuner::instance()->getShapeVersion())
+    {
+
+    case VerExtended:
+    case Ver20:
+    case Ver15:
+#ifdef GL_VERSION_1_5
+        batch = new StaticBatch15();
+        break;
+#endif
+
+    case Ver14:
+    case Ver13:
+    case Ver12:
+    case Ver11:
+#ifdef GL_VERSION_1_1
+        batch = new StaticBatch();
+        break;
+#endif
+
+    case Ver10:
+    case VerUnknown:
+    default:
+        assert( false );
+        return NULL;
+        break;
+    }
+
+    return batch;
+}
+
+StaticBatch::StaticBatch()
+  : _vertices( NULL ),
+    _numVerts( 0 ),
+    _vertexFloats( 0 ),
+    _texCoordSize( 0 ),
+    _valid( false ),
+    _dListAllocated( false )
+{
+    assert( OGLDif::instance()->getVersion() >= Ver11 );
+
+    int idx;
+    for (idx=0; idx<3; idx++)
+    {
+        _min[ idx ] = 0.f;
+        _max[ idx ] = 0.f;
+    }
+}
+
+StaticBatch::~StaticBatch()
+{
+    cancelBuild();
+
+    if (_dListAllocated)
+    {
+        glDeleteLists( _dList, 1 );
+        _dListAllocated = false;
+    }
+
+    unsigned int idx;
+    for (idx=0; idx<_entries.size(); idx++)
+    {
+        if (_entries[ idx ]._shape)
+            delete _entries[ idx ]._shape;
+    }
+    _entries.clear();
+
+    if (_vertices)
+        delete[] _vertices;
+    _vertices = NULL;
+    _indices.clear();
+    _valid = false;
+}
+
+void
+StaticBatch::draw()
+{
+    if (!_valid)
+    {
+        if (!init())
+            return;
+    }
+
+    glCallList( _dList );
+
+    OGLDIF_CHECK_ERROR;
+}
+
+bool
+StaticBatch::add( const Shape* shape, const GLfloat* matrix, const Material& material )
+{
+    assert( !_valid && (_buildJob == NULL) );
+
+    std::string key;
+    if ( (shape == NULL) || !shape->getShareKey( key ) )
+        return false;
+    Shape* copy = shape->createMaster();
+    if (copy == NULL)
+        return false;
+
+    Entry entry = { copy, { 0.f }, material };
+    memcpy( entry._matrix, matrix, sizeof( entry._matrix ) );
+    _entries.push_back( entry );
+
+    // Grow the box by the eight transformed corners of the Shape's box.
+    const Bound& bound = shape->getBound();
+    const float* extents[ 2 ] = { bound.getMin(), bound.getMax() };
+    int corner;
+    for (corner=0; corner<8; corner++)
+    {
+        const GLfloat in[ 3 ] = { extents[ corner & 1 ][0],
+                extents[ (corner >> 1) & 1 ][1], extents[ corner >> 2 ][2] };
+        GLfloat out[ 3 ];
+        transformPoint( out, matrix, in );
+
+        int idx;
+        for (idx=0; idx<3; idx++)
+        {
+            if ( (_entries.size() == 1) && (corner == 0) )
+                _min[ idx ] = _max[ idx ] = out[ idx ];
+            else if (out[ idx ] < _min[ idx ])
+                _min[ idx ] = out[ idx ];
+            else if (out[ idx ] > _max[ idx ])
+                _max[ idx ] = out[ idx ];
+        }
+    }
+    _bound.setBox( _min[0], _min[1], _min[2], _max[0], _max[1], _max[2] );
+    _bound.setSphereFromBox();
+
+    return true;
+}
+
+int
+StaticBatch::getNumDraws() const
+{
+    return (int) _groups.size();
+}
+
+
+bool
+StaticBatch::init()
+{
+    // Merge now, unless buildAsync() already started it.
+    if (!finishBuild())
+        return false;
+
+    if (!storeData())
+        return false;
+
+    return true;
+}
+
+bool
+StaticBatch::buildGeometry()
+{
+    if (_entries.empty())
+        return false;
+
+    // Tessellate every entry, and size the combined arrays.
+    const int numEntries = (int) _entries.size();
+    _numVerts = 0;
+    int numIndices = 0;
+    _texCoordSize = 0;
+    int idx;
+    for (idx=0; idx<numEntries; idx++)
+    {
+        Shape* shape = _entries[ idx ]._shape;
+        if (!shape->buildCachedGeometry())
+            return false;
+
+        int numVerts, texCoordSize;
+        const float *vertices, *normals, *texCoords;
+        const IndexArray* indices;
+        if (!shape->getTriangles( numVerts, vertices, normals, texCoords, texCoordSize, indices ))
+            return false;
+        _numVerts += numVerts;
+        numIndices += indices->getCount();
+        if (texCoordSize > _texCoordSize)
+            _texCoordSize = texCoordSize;
+    }
+    _vertexFloats = TEXCOORD_FLOATS + _texCoordSize;
+
+    std::vector< Material > materials;
+    std::vector< int > order( numEntries );
+    for (idx=0; idx<numEntries; idx++)
+    {
+        materials.push_back( _entries[ idx ]._material );
+        order[ idx ] = idx;
+    }
+    std::stable_sort( order.begin(), order.end(), EntryLess( materials ) );
+
+    // Append the entries in material order, so that each material's
+    //   vertices and indices are contiguous.
+    _vertices = new GLfloat[ _numVerts * _vertexFloats ];
+    GLuint* indexPtr = _indices.allocate( numIndices );
+    GLfloat* destPtr = _vertices;
+    int baseVert = 0, baseIndex = 0;
+    for (idx=0; idx<numEntries; idx++)
+    {
+        Entry& entry = _entries[ order[ idx ] ];
+        if ( _groups.empty() || !(_groups.back()._material == entry._material) )
+        {
+            Group group = { entry._material, baseIndex, 0, (GLuint) baseVert, (GLuint) baseVert };
+            _groups.push_back( group );
+        }
+
+        int numVerts, texCoordSize;
+        const float *vertices, *normals, *texCoords;
+        const IndexArray* indices;
+        entry._shape->getTriangles( numVerts, vertices, normals, texCoords, texCoordSize, indices );
+
+        // Normals transform by the inverse transpose of the upper 3x3,
+        //   which is proportional to its cofactor matrix; the sign of
+        //   the determinant keeps mirroring transforms from flipping them.
+        const GLfloat* m = entry._matrix;
+        GLfloat n[ 9 ];
+        n[0] = m[5]*m[10] - m[6]*m[9];
+        n[1] = m[6]*m[8] - m[4]*m[10];
+        n[2] = m[4]*m[9] - m[5]*m[8];
+        n[3] = m[9]*m[2] - m[10]*m[1];
+        n[4] = m[10]*m[0] - m[8]*m[2];
+        n[5] = m[8]*m[1] - m[9]*m[0];
+        n[6] = m[1]*m[6] - m[2]*m[5];
+        n[7] = m[2]*m[4] - m[0]*m[6];
+        n[8] = m[0]*m[5] - m[1]*m[4];
+        const GLfloat det = m[0]*n[0] + m[4]*n[3] + m[8]*n[6];
+        const GLfloat sign = (det < 0.f) ? -1.f : 1.f;
+
+        int vIdx;
+        for (vIdx=0; vIdx<numVerts; vIdx++)
+        {
+            transformPoint( destPtr, m, vertices + vIdx*3 );
+
+            const float* normal = normals + vIdx*3;
+            GLfloat* normOut = destPtr + NORMAL_FLOATS;
+            normOut[0] = n[0]*normal[0] + n[3]*normal[1] + n[6]*normal[2];
+            normOut[1] = n[1]*normal[0] + n[4]*normal[1] + n[7]*normal[2];
+            normOut[2] = n[2]*normal[0] + n[5]*normal[1] + n[8]*normal[2];
+            const GLfloat length = (GLfloat) sqrt( normOut[0]*normOut[0] +
+                    normOut[1]*normOut[1] + normOut[2]*normOut[2] );
+            if (length > 0.f)
+            {
+                normOut[0] *= sign / length;
+                normOut[1] *= sign / length;
+                normOut[2] *= sign / length;
+            }
+
+            memcpy( destPtr + COLOR_FLOATS, entry._material._color, 4 * sizeof( GLfloat ) );
+
+            // Texture coordinates stay in object space; pad shorter
+            //   ones with zeros.
+            GLfloat* texOut = destPtr + TEXCOORD_FLOATS;
+            int tIdx;
+            for (tIdx=0; tIdx<_texCoordSize; tIdx++)
+                texOut[ tIdx ] = (tIdx < texCoordSize) ? texCoords[ vIdx*texCoordSize + tIdx ] : 0.f;
+
+            destPtr += _vertexFloats;
+        }
+
+        const int count = indices->getCount();
+        int iIdx;
+        for (iIdx=0; iIdx<count; iIdx++)
+            *indexPtr++ = indices->get( iIdx ) + baseVert;
+
+        Group& group = _groups.back();
+        group._numIndices += count;
+        group._idxEnd = baseVert + numVerts - 1;
+        baseVert += numVerts;
+        baseIndex += count;
+
+        // The copy is no longer needed.
+        delete entry._shape;
+        entry._shape = NULL;
+    }
+
+    _indices.pack( _numVerts );
+
+    return true;
+}
+
+bool
+StaticBatch::storeData()
+{
+    _dList = glGenLists( 1 );
+    assert( _dList != 0 );
+    _dListAllocated = true;
+    glNewList( _dList, GL_COMPILE );
+
+    glPushClientAttrib( GL_CLIENT_VERTEX_ARRAY_BIT );
+    setPointers( (const GLubyte*) _vertices );
+    drawGroups();
+    glPopClientAttrib();
+
+    glEndList();
+
+
+    OGLDIF_CHECK_ERROR;
+
+    return( _valid = true );
+}
+
+void
+StaticBatch::setPointers( const GLubyte* base ) const
+{
+    const GLsizei stride = _vertexFloats * sizeof( GLfloat );
+
+    glEnableClientState( GL_VERTEX_ARRAY );
+    glVertexPointer( 3, GL_FLOAT, stride, base );
+
+    glEnableClientState( GL_NORMAL_ARRAY );
+    glNormalPointer( GL_FLOAT, stride, base + NORMAL_FLOATS * sizeof( GLfloat ) );
+
+    glEnableClientState( GL_COLOR_ARRAY );
+    glColorPointer( 4, GL_FLOAT, stride, base + COLOR_FLOATS * sizeof( GLfloat ) );
+
+    if ( (_numTextures > 0) && (_texCoordSize > 0) )
+    {
+        const GLubyte* texCoords = base + TEXCOORD_FLOATS * sizeof( GLfloat );
+#ifdef GL_VERSION_1_3
+        if (OGLDif::instance()->getVersion() >= Ver13)
+        {
+            int tIdx;
+            for (tIdx=0; tIdx<_numTextures; tIdx++)
+            {
+                glClientActiveTexture( GL_TEXTURE0 + tIdx );
+                glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+                glTexCoordPointer( _texCoordSize, GL_FLOAT, stride, texCoords );
+            }
+            glClientActiveTexture( GL_TEXTURE0 );
+            return;
+        }
+#endif
+        glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+        glTexCoordPointer( _texCoordSize, GL_FLOAT, stride, texCoords );
+    }
+}
+
+void
+StaticBatch::drawGroups() const
+{
+    // Restores the material and the current color, which the color
+    //   array leaves undefined.
+    glPushAttrib( GL_LIGHTING_BIT | GL_CURRENT_BIT );
+
+    unsigned int idx;
+    for (idx=0; idx<_groups.size(); idx++)
+    {
+        const Group& group = _groups[ idx ];
+        glMaterialfv( GL_FRONT, GL_SPECULAR, group._material._specular );
+        glMaterialf( GL_FRONT, GL_SHININESS, group._material._shininess );
+
+        // The display list reads indices from client memory;
+        //   StaticBatch15 reads them from its element array buffer.
+        const GLvoid* indices = _dListAllocated ?
+                _indices.address( group._firstIndex ) : _indices.offset( group._firstIndex );
+#ifdef GL_VERSION_1_2
+        if (OGLDif::instance()->getVersion() >= Ver12)
+        {
+            glDrawRangeElements( GL_TRIANGLES, group._idxStart, group._idxEnd,
+                    group._numIndices, _indices.getType(), indices );
+            continue;
+        }
+#endif
+        glDrawElements( GL_TRIANGLES, group._numIndices, _indices.getType(), indices );
+    }
+
+    glPopAttrib();
+}
+
+
+
+
+#ifdef GL_VERSION_1_5
+
+
+// Static indices into the _vbo buffer object array
+int StaticBatch15::_vertIdx( 0 );
+int StaticBatch15::_idxIdx( 1 );
+
+
+StaticBatch15::StaticBatch15()
+  : StaticBatch()
+{
+    assert( OGLDif::instance()->getVersion() >= Ver15 );
+}
+
+StaticBatch15::~StaticBatch15()
+{
+    cancelBuild();
+
+    if (_valid)
+        glDeleteBuffers( 2, _vbo );
+}
+
+void
+StaticBatch15::draw()
+{
+    if (!_valid)
+    {
+        if (!init())
+            return;
+    }
+
+    glPushClientAttrib( GL_CLIENT_VERTEX_ARRAY_BIT );
+
+    glBindBuffer( GL_ARRAY_BUFFER, _vbo[_vertIdx] );
+    setPointers( (const GLubyte*) bufferObjectPtr( 0 ) );
+
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, _vbo[_idxIdx] );
+    drawGroups();
+
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+
+    glPopClientAttrib();
+
+
+    OGLDIF_CHECK_ERROR;
+}
+
+bool
+StaticBatch15::storeData()
+{
+    glGenBuffers( 2, _vbo );
+
+    glBindBuffer( GL_ARRAY_BUFFER, _vbo[_vertIdx] );
+    glBufferData( GL_ARRAY_BUFFER, _numVerts * _vertexFloats * sizeof( GLfloat ),
+            _vertices, GL_STATIC_DRAW );
+
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, _vbo[_idxIdx] );
+    glBufferData( GL_ELEMENT_ARRAY_BUFFER, _indices.getSizeBytes(), _indices.getData(), GL_STATIC_DRAW );
+
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+
+    OGLDIF_CHECK_ERROR;
+
+    return( _valid = true );
+}
+
+
+#endif
+
+
+}
@@ -11,10 +11,11 @@
 // 
 
 #include "OGLDPlatformGL.h"
-#include "OGLDPlatformGLU.h"
 #include "OGLDif.h"
 #include "OGLDPixels.h"
+#include "OGLDPixelBuffer.h"
 #include "OGLDTexture.h"
+#include "OGLDBuildThread.h"
 #include "OGLDMath.h"
 #include <string>
 #include <assert.h>
@@ -25,6 +26,82 @@ namespace ogld
 {
 
 
+// Decodes an image file for Texture::loadImageAsync().
+class TextureLoadJob : public BuildJob
+{
+public:
+    // 'fullPath' is 'fileName' resolved on the data path; the worker
+    //   only reads it. If 'power2' is true, the image is also
+    //   resampled to power-of-two dimensions rounded by 'rounding',
+    //   when that needs no OpenGL calls.
+    TextureLoadJob( const std::string& fileName, const std::string& fullPath,
+            GLenum format, GLenum type, bool power2, Power2Rounding rounding )
+      : _fileName( fileName ),
+        _fullPath( fullPath ),
+        _power2( power2 ),
+        _rounding( rounding )
+    {
+        _image.setFormat( format );
+        _image.setType( type );
+    }
+    virtual ~TextureLoadJob() {}
+
+    const std::string& getFileName() const { return _fileName; }
+
+    // Call once, after getResult() returns true. The caller owns the
+    //   returned pixels.
+    unsigned char* takePixels( GLsizei& width, GLsizei& height )
+    {
+        unsigned char* pixels = _image._pixels;
+        _image.getWidthHeight( width, height );
+        _image._pixels = NULL;
+        _image._valid = false;
+        return pixels;
+    }
+
+protected:
+    virtual bool execute()
+    {
+        if (!_image.readImage( _fullPath ))
+            return false;
+
+        if ( _power2 && isResampleSupported( _image.getFormat(), _image.getType() ) )
+        {
+            GLsizei width, height;
+            _image.getWidthHeight( width, height );
+            roundToPower2( width, height, _rounding );
+            _image.resample( width, height );
+        }
+        return true;
+    }
+
+    const std::string _fileName;
+    const std::string _fullPath;
+    const bool _power2;
+    const Power2Rounding _rounding;
+    Pixels _image;
+};
+
+
+// True if finishLoad() can store images through a pixel unpack
+//   buffer.
+static bool
+unpackBufferAvailable()
+{
+#ifdef PIXELBUFFER_BUILD_PBO
+    const std::string pboStr( "GL_ARB_pixel_buffer_object" );
+    return( (OGLDif::instance()->getVersion() >= Ver15) &&
+            (OGLDif::instance()->isExtensionSupported(
+            pboStr, glGetString( GL_EXTENSIONS ) )) );
+#else
+    return false;
+#endif
+}
+
+
+GLuint Texture::_placeholder( 0 );
+bool Texture::_placeholderAllocated( false );
+
 // Static factory creation method
 Texture*
 Texture::create()
@@ -71,7 +148,14 @@ Texture::create()
 Texture::Texture()
   : _texId( 0 ),
     _textureObjectAllocated( false ),
-    _mode( GL_MODULATE )
+    _mode( GL_MODULATE ),
+    _mipmap( true ),
+    _mipmapFilter( BoxFilter ),
+    _power2Rounding( RoundUpPower2 ),
+    _hostDataPolicy( getDefaultHostDataPolicy() ),
+    _loadJob( NULL ),
+    _loading( false ),
+    _uploadFromBuffer( false )
 {
     assert( OGLDif::instance()->getVersion() >= Ver11 );
 }
@@ -84,14 +168,42 @@ Texture::~Texture()
 bool
 Texture::loadImage( const std::string& fileName )
 {
-    Pixels::loadImage( fileName );
+    // Pixels::loadImage() ends by calling init(), which creates the
+    //   texture object.
+    if (!Pixels::loadImage( fileName ))
+        return false;
 
-    if (_valid)
-        initTextureObject();
+    _fileName = fileName;
+    releaseHostPixels();
 
     return _valid;
 }
 
+BuildJob*
+Texture::loadImageAsync( const std::string& fileName )
+{
+    unload();
+
+    // Find the file, and decide whether the worker should resample
+    //   the image, here on the OpenGL thread, so that the worker only
+    //   reads and decodes. initTextureObject() resamples otherwise.
+    const bool power2 = (OGLDif::instance()->getVersion() != VerUnknown) &&
+            !OGLDif::instance()->isTextureNPOTSupported();
+    _loadJob = new TextureLoadJob( fileName,
+            OGLDif::instance()->findDataFile( fileName ),
+            _format, _type, power2, _power2Rounding );
+    _loading = true;
+    BuildThread::instance()->submit( _loadJob );
+
+    return _loadJob;
+}
+
+bool
+Texture::isLoading() const
+{
+    return _loading;
+}
+
 bool
 Texture::loadDirect( GLsizei width, GLsizei height, GLubyte* pixels )
 {
@@ -122,10 +234,19 @@ Texture::reserve( GLsizei width, GLsizei height )
 void
 Texture::unload()
 {
+    if (_loadJob != NULL)
+    {
+        BuildThread::instance()->cancel( _loadJob );
+        delete _loadJob;
+        _loadJob = NULL;
+    }
+    _loading = false;
+
     if (_textureObjectAllocated)
         glDeleteTextures( 1, &_texId );
     _texId = 0;
     _textureObjectAllocated = false;
+    _fileName.clear();
 
     Pixels::unload();
 }
@@ -133,7 +254,13 @@ Texture::unload()
 void
 Texture::apply()
 {
-    if (!_valid)
+    if ( _loading && !finishLoad() )
+    {
+        applyPlaceholder();
+        return;
+    }
+
+    if (!_textureObjectAllocated)
     {
         if (!init())
             return;
@@ -149,6 +276,13 @@ Texture::apply()
 bool
 Texture::init()
 {
+    if ( _valid && (_pixels == NULL) && !_fileName.empty() )
+    {
+        // contextLost() after loadImage() released the pixels.
+        const std::string fileName( _fileName );
+        return loadImage( fileName );
+    }
+
     Pixels::init();
 
     if (_valid)
@@ -164,7 +298,7 @@ void Texture::initTextureObject()
 
     glBindTexture( GL_TEXTURE_2D, _texId );
 
-    bool useMipmaps = (_pixels != NULL);
+    bool useMipmaps = ( _mipmap && (_pixels != NULL) );
 
     glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
     glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
@@ -173,36 +307,133 @@ void Texture::initTextureObject()
     glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
 
 
-    // Non-power-of-2 texture dimensions not supported. Resample if necessary.
-    bool wNPOT = ( (_width & (_width-1)) != 0);
-    bool hNPOT = ( (_height & (_height-1)) != 0);
-    if (wNPOT || hNPOT)
+    resampleToPower2();
+
+    if (useMipmaps)
+        buildMipmaps( GL_TEXTURE_2D, _format, _width, _height,
+                _format, _type, _pixels, _mipmapFilter );
+    else
+        glTexImage2D( GL_TEXTURE_2D, 0, _format, _width, _height,
+                0, _format, _type, _pixels );
+
+
+    OGLDIF_CHECK_ERROR;
+}
+
+bool
+Texture::finishLoad()
+{
+    if (!_loadJob->isDone())
+        return false;
+
+    _loading = false;
+    if (!_loadJob->getResult())
+        // apply() goes on to init() the default image.
+        return true;
+
+    _pixels = _loadJob->takePixels( _width, _height );
+    _valid = true;
+
+    _uploadFromBuffer = unpackBufferAvailable();
+    initTextureObject();
+    _uploadFromBuffer = false;
+
+    _fileName = _loadJob->getFileName();
+    releaseHostPixels();
+
+    return true;
+}
+
+void
+Texture::applyPlaceholder()
+{
+    if (!_placeholderAllocated)
     {
-        GLsizei oldW = _width;
-        GLsizei oldH = _height;
-        _width = ceilPower2( _width );
-        _height = ceilPower2( _height );
-        int sizeBytes = size();
-        unsigned char* newData = new unsigned char[ sizeBytes ];
+        const GLubyte white[ 4 ] = { 255, 255, 255, 255 };
 
-        gluScaleImage( _format, oldW, oldH, _type, _pixels,
-            _width, _height, _type, (GLvoid*) newData );
+        glGenTextures( 1, &_placeholder );
+        _placeholderAllocated = true;
 
-        delete[] _pixels;
-        _pixels = newData;
+        glBindTexture( GL_TEXTURE_2D, _placeholder );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+        glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+        glTexImage2D( GL_TEXTURE_2D, 0, GL_RGBA, 1, 1,
+                0, GL_RGBA, GL_UNSIGNED_BYTE, white );
     }
-
-    if (_pixels != NULL)
-        gluBuild2DMipmaps( GL_TEXTURE_2D, _format, _width, _height,
-                _format, _type, _pixels );
     else
-        glTexImage2D( GL_TEXTURE_2D, 0, _format, _width, _height,
-                0, _format, _type, _pixels );
+        glBindTexture( GL_TEXTURE_2D, _placeholder );
 
+    glTexEnvi( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, _mode );
 
     OGLDIF_CHECK_ERROR;
 }
 
+void
+Texture::texImage2D( bool mipmaps )
+{
+    MipmapChain chain;
+    if ( mipmaps && !chain.build( _pixels, _width, _height, _format, _type, _mipmapFilter ) )
+    {
+        // Not a format MipmapChain handles; let OpenGL build them.
+#ifdef GL_VERSION_1_4
+        glTexParameteri( GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE );
+#endif
+    }
+
+#ifdef PIXELBUFFER_BUILD_PBO
+    if ( _uploadFromBuffer && (_pixels != NULL) )
+    {
+        // Like PixelBuffer. glTexImage2D() returns without waiting for
+        //   the driver to copy and convert the pixels. Deleting the
+        //   buffer right away is fine; OpenGL keeps it until the copy
+        //   is done.
+        const int levelBytes = size();
+        GLuint pbo;
+        glGenBuffers( 1, &pbo );
+        glBindBuffer( GL_PIXEL_UNPACK_BUFFER_ARB, pbo );
+        glBufferData( GL_PIXEL_UNPACK_BUFFER_ARB, levelBytes + chain.getDataSize(),
+                NULL, GL_STREAM_DRAW );
+        glBufferSubData( GL_PIXEL_UNPACK_BUFFER_ARB, 0, levelBytes, _pixels );
+        if (chain.getNumLevels() > 0)
+            glBufferSubData( GL_PIXEL_UNPACK_BUFFER_ARB, levelBytes,
+                    chain.getDataSize(), chain.getData() );
+
+        glTexImage2D( GL_TEXTURE_2D, 0, _format, _width, _height,
+                0, _format, _type, bufferObjectPtr( 0 ) );
+        chain.texImage( GL_TEXTURE_2D, _format, bufferObjectPtr( levelBytes ) );
+
+        glBindBuffer( GL_PIXEL_UNPACK_BUFFER_ARB, 0 );
+        glDeleteBuffers( 1, &pbo );
+        return;
+    }
+#endif
+
+    glTexImage2D( GL_TEXTURE_2D, 0, _format, _width, _height,
+            0, _format, _type, _pixels );
+    chain.texImage( GL_TEXTURE_2D, _format );
+}
+
+void
+Texture::resampleToPower2()
+{
+    if (OGLDif::instance()->isTextureNPOTSupported())
+        return;
+
+    GLsizei width( _width ), height( _height );
+    roundToPower2( width, height, _power2Rounding );
+    resample( width, height );
+}
+
+void
+Texture::releaseHostPixels()
+{
+    if ( (_hostDataPolicy == ReleaseHostData) && _pixels )
+    {
+        delete[] _pixels;
+        _pixels = NULL;
+    }
+}
+
 
 void
 Texture::setUnit( GLenum unit )
@@ -234,6 +465,65 @@ Texture::getObject() const
     return _texId;
 }
 
+void
+Texture::setMipmap( bool mipmap )
+{
+    _mipmap = mipmap;
+}
+
+bool
+Texture::getMipmap() const
+{
+    return _mipmap;
+}
+
+void
+Texture::setMipmapFilter( MipmapFilter filter )
+{
+    _mipmapFilter = filter;
+}
+
+MipmapFilter
+Texture::getMipmapFilter() const
+{
+    return _mipmapFilter;
+}
+
+void
+Texture::setPower2Rounding( Power2Rounding rounding )
+{
+    _power2Rounding = rounding;
+}
+
+Power2Rounding
+Texture::getPower2Rounding() const
+{
+    return _power2Rounding;
+}
+
+void
+Texture::setHostDataPolicy( HostDataPolicy policy )
+{
+    _hostDataPolicy = policy;
+}
+
+HostDataPolicy
+Texture::getHostDataPolicy() const
+{
+    return _hostDataPolicy;
+}
+
+void
+Texture::contextLost()
+{
+    // The texture object went with the context.
+    _texId = 0;
+    _textureObjectAllocated = false;
+
+    _placeholder = 0;
+    _placeholderAllocated = false;
+}
+
 
 
 
@@ -255,7 +545,14 @@ Texture13::~Texture13()
 void
 Texture13::apply()
 {
-    if (!_valid)
+    if ( _loading && !finishLoad() )
+    {
+        glActiveTexture( _unit );
+        applyPlaceholder();
+        return;
+    }
+
+    if (!_textureObjectAllocated)
     {
         if (!init())
             return;
@@ -313,7 +610,7 @@ void Texture14::initTextureObject()
     }
     else
     {
-        useMipmaps = (_pixels != NULL);
+        useMipmaps = ( _mipmap && (_pixels != NULL) );
 
         glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
         glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
@@ -322,29 +619,9 @@ void Texture14::initTextureObject()
         glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
     }
 
-    // Non-power-of-2 texture dimensions not supported. Resample if necessary.
-    bool wNPOT = ( (_width & (_width-1)) != 0);
-    bool hNPOT = ( (_height & (_height-1)) != 0);
-    if (wNPOT || hNPOT)
-    {
-        GLsizei oldW = _width;
-        GLsizei oldH = _height;
-        _width = ceilPower2( _width );
-        _height = ceilPower2( _height );
-        int sizeBytes = size();
-        unsigned char* newData = new unsigned char[ sizeBytes ];
+    resampleToPower2();
 
-        gluScaleImage( _format, oldW, oldH, _type, _pixels,
-            _width, _height, _type, (GLvoid*) newData );
-
-        delete[] _pixels;
-        _pixels = newData;
-    }
-
-    if (useMipmaps)
-        glTexParameteri( GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE );
-    glTexImage2D( GL_TEXTURE_2D, 0, _format, _width, _height,
-            0, _format, _type, _pixels );
+    texImage2D( useMipmaps );
 
 
     OGLDIF_CHECK_ERROR;
@@ -392,7 +669,7 @@ void Texture20::initTextureObject()
     }
     else
     {
-        useMipmaps = (_pixels != NULL);
+        useMipmaps = ( _mipmap && (_pixels != NULL) );
 
         glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT );
         glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT );
@@ -401,10 +678,7 @@ void Texture20::initTextureObject()
         glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
     }
 
-    if (useMipmaps)
-        glTexParameteri( GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE );
-    glTexImage2D( GL_TEXTURE_2D, 0, _format, _width, _height,
-            0, _format, _type, _pixels );
+    texImage2D( useMipmaps );
 
 
     OGLDIF_CHECK_ERROR;
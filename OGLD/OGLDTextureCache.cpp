@@ -0,0 +1,187 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+//
+
+
+#include "OGLDPlatformGL.h"
+#include "OGLDif.h"
+#include "OGLDTextureCache.h"
+#include "OGLDTexture.h"
+#include <sstream>
+#include <string>
+#include <assert.h>
+
+
+
+namespace ogld
+{
+
+
+TextureCache* TextureCache::_instance = 0;
+
+
+TextureCache*
+TextureCache::instance()
+{
+    if (!_instance)
+        _instance = new TextureCache;
+
+    return _instance;
+}
+
+
+TextureCache::TextureCache()
+  : _unusedBytes( 0 ),
+    _unusedBudget( 0 )
+{
+}
+
+
+Texture*
+TextureCache::acquire( const std::string& fileName, GLenum format, GLenum type,
+        bool mipmap, MipmapFilter filter, Power2Rounding rounding,
+        GLenum unit, GLint envMode )
+{
+    const std::string fullPath( OGLDif::instance()->findDataFile( fileName ) );
+    if (fullPath.empty())
+        return NULL;
+
+    std::ostringstream keyStream;
+    keyStream << fullPath << '\t' << format << ' ' << type << ' ' << mipmap;
+    if (mipmap)
+        keyStream << ' ' << filter;
+    keyStream << ' ' << rounding << ' ' << unit << ' ' << envMode;
+    const std::string key( keyStream.str() );
+
+    EntryMap::iterator it = _entries.find( key );
+    if (it == _entries.end())
+    {
+        Texture* texture = Texture::create();
+        texture->setFormat( format );
+        texture->setType( type );
+        texture->setMipmap( mipmap );
+        texture->setMipmapFilter( filter );
+        texture->setPower2Rounding( rounding );
+        if (unit != 0)
+            texture->setUnit( unit );
+        texture->setEnvMode( envMode );
+        if (!texture->loadImage( fullPath ))
+        {
+            delete texture;
+            return NULL;
+        }
+
+        Entry entry;
+        entry._texture = texture;
+        entry._refCount = 0;
+        // A full mipmap chain adds a third.
+        entry._bytes = texture->size();
+        if (mipmap)
+            entry._bytes += entry._bytes / 3;
+        entry._unusedPos = _unused.end();
+        it = _entries.insert( EntryMap::value_type( key, entry ) ).first;
+        _keys[ texture ] = key;
+    }
+    else if (it->second._refCount == 0)
+    {
+        _unused.erase( it->second._unusedPos );
+        it->second._unusedPos = _unused.end();
+        _unusedBytes -= it->second._bytes;
+    }
+
+    it->second._refCount++;
+    return it->second._texture;
+}
+
+void
+TextureCache::release( Texture* texture )
+{
+    KeyMap::const_iterator keyIt = _keys.find( texture );
+    assert( keyIt != _keys.end() );
+    if (keyIt == _keys.end())
+        return;
+
+    EntryMap::iterator it = _entries.find( keyIt->second );
+    assert( (it != _entries.end()) && (it->second._refCount > 0) );
+    if (--(it->second._refCount) > 0)
+        return;
+
+    it->second._unusedPos = _unused.insert( _unused.end(), it->first );
+    _unusedBytes += it->second._bytes;
+    trim( _unusedBudget );
+}
+
+
+void
+TextureCache::setUnusedBudget( unsigned int bytes )
+{
+    _unusedBudget = bytes;
+    trim( _unusedBudget );
+}
+
+unsigned int
+TextureCache::getUnusedBudget() const
+{
+    return _unusedBudget;
+}
+
+void
+TextureCache::evict()
+{
+    trim( 0 );
+}
+
+void
+TextureCache::contextLost()
+{
+    EntryMap::iterator it;
+    for (it=_entries.begin(); it!=_entries.end(); it++)
+        it->second._texture->contextLost();
+}
+
+
+int
+TextureCache::getSize() const
+{
+    return (int) _entries.size();
+}
+
+int
+TextureCache::getNumUnused() const
+{
+    return (int) _unused.size();
+}
+
+unsigned int
+TextureCache::getUnusedBytes() const
+{
+    return _unusedBytes;
+}
+
+
+void
+TextureCache::trim( unsigned int budget )
+{
+    while ( !_unused.empty() && (_unusedBytes > budget) )
+    {
+        EntryMap::iterator it = _entries.find( _unused.front() );
+        assert( (it != _entries.end()) && (it->second._refCount == 0) );
+        _unused.pop_front();
+
+        _unusedBytes -= it->second._bytes;
+        _keys.erase( it->second._texture );
+        delete it->second._texture;
+        _entries.erase( it );
+    }
+}
+
+
+}
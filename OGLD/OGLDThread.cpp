@@ -0,0 +1,290 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+// 
+
+
+#include "OGLDThread.h"
+#include <assert.h>
+#include <vector>
+
+#if defined( WIN32 ) && !defined( __CYGWIN__ )
+  #include <process.h>
+#else
+  #include <unistd.h>
+#endif
+
+
+
+namespace ogld
+{
+
+
+#if defined( WIN32 ) && !defined( __CYGWIN__ )
+
+
+Mutex::Mutex()
+{
+    InitializeCriticalSection( &_cs );
+}
+
+Mutex::~Mutex()
+{
+    DeleteCriticalSection( &_cs );
+}
+
+void
+Mutex::lock()
+{
+    EnterCriticalSection( &_cs );
+}
+
+void
+Mutex::unlock()
+{
+    LeaveCriticalSection( &_cs );
+}
+
+
+Event::Event()
+{
+    _event = CreateEvent( NULL, FALSE, FALSE, NULL );
+    assert( _event != NULL );
+}
+
+Event::~Event()
+{
+    CloseHandle( _event );
+}
+
+void
+Event::signal()
+{
+    SetEvent( _event );
+}
+
+void
+Event::wait()
+{
+    WaitForSingleObject( _event, INFINITE );
+}
+
+
+Thread::Thread()
+  : _thread( NULL ),
+    _started( false )
+{
+}
+
+Thread::~Thread()
+{
+    if (_started)
+        CloseHandle( _thread );
+}
+
+bool
+Thread::start()
+{
+    assert( !_started );
+
+    _thread = (HANDLE) _beginthreadex( NULL, 0, entry, this, 0, NULL );
+    _started = (_thread != 0);
+    return _started;
+}
+
+void
+Thread::join()
+{
+    if (_started)
+    {
+        WaitForSingleObject( _thread, INFINITE );
+        CloseHandle( _thread );
+    }
+    _started = false;
+}
+
+unsigned int __stdcall
+Thread::entry( void* arg )
+{
+    ((Thread*) arg)->run();
+    return 0;
+}
+
+int
+getNumProcessors()
+{
+    SYSTEM_INFO info;
+    GetSystemInfo( &info );
+    return( (info.dwNumberOfProcessors < 1) ? 1 : (int) info.dwNumberOfProcessors );
+}
+
+
+#else
+
+
+Mutex::Mutex()
+{
+    pthread_mutex_init( &_mutex, NULL );
+}
+
+Mutex::~Mutex()
+{
+    pthread_mutex_destroy( &_mutex );
+}
+
+void
+Mutex::lock()
+{
+    pthread_mutex_lock( &_mutex );
+}
+
+void
+Mutex::unlock()
+{
+    pthread_mutex_unlock( &_mutex );
+}
+
+
+Event::Event()
+  : _signaled( false )
+{
+    pthread_mutex_init( &_mutex, NULL );
+    pthread_cond_init( &_cond, NULL );
+}
+
+Event::~Event()
+{
+    pthread_cond_destroy( &_cond );
+    pthread_mutex_destroy( &_mutex );
+}
+
+void
+Event::signal()
+{
+    pthread_mutex_lock( &_mutex );
+    _signaled = true;
+    pthread_cond_signal( &_cond );
+    pthread_mutex_unlock( &_mutex );
+}
+
+void
+Event::wait()
+{
+    pthread_mutex_lock( &_mutex );
+    while (!_signaled)
+        pthread_cond_wait( &_cond, &_mutex );
+    _signaled = false;
+    pthread_mutex_unlock( &_mutex );
+}
+
+
+Thread::Thread()
+  : _started( false )
+{
+}
+
+Thread::~Thread()
+{
+}
+
+bool
+Thread::start()
+{
+    assert( !_started );
+
+    _started = (pthread_create( &_thread, NULL, entry, this ) == 0);
+    return _started;
+}
+
+void
+Thread::join()
+{
+    if (_started)
+        pthread_join( _thread, NULL );
+    _started = false;
+}
+
+void*
+Thread::entry( void* arg )
+{
+    ((Thread*) arg)->run();
+    return NULL;
+}
+
+int
+getNumProcessors()
+{
+    const long count = sysconf( _SC_NPROCESSORS_ONLN );
+    return( (count < 1) ? 1 : (int) count );
+}
+
+
+#endif
+
+
+
+// Runs one range of a parallelFor().
+class RangeThread : public Thread
+{
+public:
+    RangeThread( RangeTask& task, int begin, int end )
+      : _task( task ), _begin( begin ), _end( end ) {}
+
+protected:
+    virtual void run() { _task.run( _begin, _end ); }
+
+    RangeTask& _task;
+    int _begin, _end;
+};
+
+void
+parallelFor( RangeTask& task, int count, int grain )
+{
+    if (count <= 0)
+        return;
+    if (grain < 1)
+        grain = 1;
+
+    int numRanges = count / grain;
+    const int numProcessors = getNumProcessors();
+    if (numRanges > numProcessors)
+        numRanges = numProcessors;
+    if (numRanges < 1)
+        numRanges = 1;
+
+    std::vector< RangeThread* > threads;
+    int idx;
+    for (idx=1; idx<numRanges; idx++)
+    {
+        const int begin = (int)( (double) count * idx / numRanges );
+        const int end = (int)( (double) count * (idx+1) / numRanges );
+        RangeThread* thread = new RangeThread( task, begin, end );
+        if (thread->start())
+            threads.push_back( thread );
+        else
+        {
+            // Out of threads. Run the range here instead.
+            delete thread;
+            task.run( begin, end );
+        }
+    }
+
+    task.run( 0, (int)( (double) count / numRanges ) );
+
+    std::vector< RangeThread* >::iterator it;
+    for (it=threads.begin(); it!=threads.end(); it++)
+    {
+        (*it)->join();
+        delete *it;
+    }
+}
+
+
+}
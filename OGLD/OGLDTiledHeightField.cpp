@@ -0,0 +1,1383 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+// 
+
+
+#include "OGLDPlatformGL.h"
+#include "OGLDTiledHeightField.h"
+#include "OGLDHeightField.h"
+#include "OGLDif.h"
+#include "OGLDMath.h"
+#include "OGLDMipmap.h"
+#include <math.h>
+#include <assert.h>
+#include <string.h>
+
+
+
+namespace ogld
+{
+
+
+//
+// Tile file layout. All values are four bytes in network byte order;
+//   floats are stored as their IEEE bit patterns.
+//
+//   Header:
+//     "OGLDTILE", version, tileUnits, tileTexels, numLevels,
+//     xUnits, yUnits, xLen, yLen, and the top tile's minZ, maxZ, and
+//     error.
+//   Tiles, from the top level down to level 0, each level in x-major
+//     order, all the same size:
+//     (tileUnits+1)^2 heights, x-major;
+//     tileTexels^2 RGBA texels, one byte per component;
+//     for each child (x,y), (x+1,y), (x,y+1), (x+1,y+1): minZ, maxZ,
+//       error, and a present flag.
+//
+static const char FILE_MAGIC[ 8 ] = { 'O', 'G', 'L', 'D', 'T', 'I', 'L', 'E' };
+static const unsigned int FILE_VERSION( 1 );
+static const int HEADER_SIZE( 8 + 14*4 );
+static const int CHILD_INFO_SIZE( 4*4 );
+
+// Layout of the interleaved vertex data: three position floats,
+//   three normal floats, and two texture coordinate floats.
+static const int INTERLEAVED_FLOATS( 8 );
+static const unsigned int NORMAL_OFFSET( 3 * sizeof( GLfloat ) );
+static const unsigned int TEXCOORD_OFFSET( 6 * sizeof( GLfloat ) );
+
+// Limits the OpenGL work any one draw() does for newly loaded tiles.
+static const int MAX_UPLOADS_PER_DRAW( 8 );
+
+
+static void
+putUInt( GLubyte*& ptr, unsigned int value )
+{
+    *ptr++ = (GLubyte)( value >> 24 );
+    *ptr++ = (GLubyte)( value >> 16 );
+    *ptr++ = (GLubyte)( value >> 8 );
+    *ptr++ = (GLubyte)( value );
+}
+
+static void
+putFloat( GLubyte*& ptr, float value )
+{
+    unsigned int bits;
+    memcpy( &bits, &value, sizeof( bits ) );
+    putUInt( ptr, bits );
+}
+
+static unsigned int
+getUInt( const GLubyte*& ptr )
+{
+    const unsigned int value = ( (unsigned int) ptr[0] << 24 ) | ( (unsigned int) ptr[1] << 16 ) |
+            ( (unsigned int) ptr[2] << 8 ) | (unsigned int) ptr[3];
+    ptr += 4;
+    return value;
+}
+
+static float
+getFloat( const GLubyte*& ptr )
+{
+    const unsigned int bits = getUInt( ptr );
+    float value;
+    memcpy( &value, &bits, sizeof( value ) );
+    return value;
+}
+
+
+// Number of tiles across 'units' grid units at 'level'.
+static int
+tilesAcross( int units, int tileUnits, int level )
+{
+    const int span = tileUnits << level;
+    return( (units + span - 1) / span );
+}
+
+// Number of levels for which the top level is a single tile.
+static int
+levelsFor( int xUnits, int yUnits, int tileUnits )
+{
+    const int units = (xUnits > yUnits) ? xUnits : yUnits;
+    int numLevels = 1;
+    while ( (tileUnits << (numLevels-1)) < units )
+        numLevels++;
+    return numLevels;
+}
+
+static int
+tileSizeBytes( int tileUnits, int tileTexels )
+{
+    return( (tileUnits+1) * (tileUnits+1) * 4 + tileTexels * tileTexels * 4 + 4 * CHILD_INFO_SIZE );
+}
+
+
+// Bilinear sample of an RGBA image at pixel coordinates (px,py),
+//   measured from pixel centers, clamped to the edges.
+static void
+sampleImage( const GLubyte* image, int w, int h, float px, float py, float* rgba )
+{
+    if (px < 0.f) px = 0.f;
+    if (py < 0.f) py = 0.f;
+    if (px > (float)(w-1)) px = (float)(w-1);
+    if (py > (float)(h-1)) py = (float)(h-1);
+
+    const int x0 = (int) px, y0 = (int) py;
+    const int x1 = (x0 < w-1) ? x0+1 : x0, y1 = (y0 < h-1) ? y0+1 : y0;
+    const float fx = px - x0, fy = py - y0;
+
+    const GLubyte* p00 = image + (y0*w + x0) * 4;
+    const GLubyte* p10 = image + (y0*w + x1) * 4;
+    const GLubyte* p01 = image + (y1*w + x0) * 4;
+    const GLubyte* p11 = image + (y1*w + x1) * 4;
+    int c;
+    for (c=0; c<4; c++)
+        rgba[ c ] = (1.f-fy) * ( (1.f-fx) * p00[c] + fx * p10[c] ) +
+                fy * ( (1.f-fx) * p01[c] + fx * p11[c] );
+}
+
+
+bool
+TiledHeightField::writeFile( const std::string& fileName,
+        float xLen, float yLen, int xUnits, int yUnits, const float* zArray,
+        int imageW, int imageH, const GLubyte* image,
+        int tileUnits, int tileTexels )
+{
+    if ( (xUnits < 1) || (yUnits < 1) )
+        return false;
+
+    // Round up to powers of two, as HeightField does.
+    int tu;
+    for (tu=2; (tu < tileUnits) && (tu < 128); tu<<=1)
+        ;
+    tileUnits = tu;
+    if (image == NULL)
+        tileTexels = 0;
+    else
+    {
+        int tt;
+        for (tt=2; tt < tileTexels; tt<<=1)
+            ;
+        tileTexels = tt;
+    }
+
+    const int numLevels = levelsFor( xUnits, yUnits, tileUnits );
+
+    // Bounds and errors of every tile, measured against the full
+    //   resolution grid. A tile's error is the largest z distance from
+    //   a full resolution grid point to the tile's triangles, and is at
+    //   least the error of any of its children.
+    std::vector< std::vector< TileInfo > > info( numLevels );
+    int level;
+    for (level=0; level<numLevels; level++)
+    {
+        const int tilesX = tilesAcross( xUnits, tileUnits, level );
+        const int tilesY = tilesAcross( yUnits, tileUnits, level );
+        const int step = 1 << level;
+        const int span = tileUnits << level;
+        info[ level ].resize( tilesX * tilesY );
+
+        int tx, ty;
+        for (tx=0; tx<tilesX; tx++)
+        {
+            for (ty=0; ty<tilesY; ty++)
+            {
+                const int x0 = tx * span, y0 = ty * span;
+                const int x1 = (x0 + span < xUnits) ? x0 + span : xUnits;
+                const int y1 = (y0 + span < yUnits) ? y0 + span : yUnits;
+
+                TileInfo& ti = info[ level ][ tx*tilesY + ty ];
+                ti._minZ = ti._maxZ = zArray[ x0*(yUnits+1) + y0 ];
+                ti._error = 0.f;
+                ti._present = true;
+
+                int x, y;
+                for (x=x0; x<=x1; x++)
+                {
+                    // Corners of the tile's cell containing x, clamped
+                    //   to the grid.
+                    const int cellX = (x < x1) ? x0 + ((x - x0) / step) * step : x1 - step;
+                    const int xa = (cellX > x0) ? cellX : x0;
+                    const int xb = (cellX + step < xUnits) ? cellX + step : xUnits;
+                    const float u = (xb > xa) ? (float)( x - xa ) / (float)( xb - xa ) : 0.f;
+
+                    for (y=y0; y<=y1; y++)
+                    {
+                        const float z = zArray[ x*(yUnits+1) + y ];
+                        if (z < ti._minZ)
+                            ti._minZ = z;
+                        else if (z > ti._maxZ)
+                            ti._maxZ = z;
+
+                        if (level == 0)
+                            continue;
+
+                        const int cellY = (y < y1) ? y0 + ((y - y0) / step) * step : y1 - step;
+                        const int ya = (cellY > y0) ? cellY : y0;
+                        const int yb = (cellY + step < yUnits) ? cellY + step : yUnits;
+                        const float v = (yb > ya) ? (float)( y - ya ) / (float)( yb - ya ) : 0.f;
+
+                        const float z00 = zArray[ xa*(yUnits+1) + ya ];
+                        const float z10 = zArray[ xb*(yUnits+1) + ya ];
+                        const float z01 = zArray[ xa*(yUnits+1) + yb ];
+                        const float z11 = zArray[ xb*(yUnits+1) + yb ];
+                        const float approx = (u + v <= 1.f) ?
+                                z00 + u * (z10 - z00) + v * (z01 - z00) :
+                                z11 + (1.f - u) * (z01 - z11) + (1.f - v) * (z10 - z11);
+
+                        const float error = (float) fabs( z - approx );
+                        if (error > ti._error)
+                            ti._error = error;
+                    }
+                }
+
+                if (level > 0)
+                {
+                    const int childTilesX = tilesAcross( xUnits, tileUnits, level-1 );
+                    const int childTilesY = tilesAcross( yUnits, tileUnits, level-1 );
+                    int c;
+                    for (c=0; c<4; c++)
+                    {
+                        const int cx = tx*2 + (c & 1), cy = ty*2 + (c >> 1);
+                        if ( (cx < childTilesX) && (cy < childTilesY) )
+                        {
+                            const float childError = info[ level-1 ][ cx*childTilesY + cy ]._error;
+                            if (childError > ti._error)
+                                ti._error = childError;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+
+    FILE* f = fopen( fileName.c_str(), "wb" );
+    if (f == NULL)
+        return false;
+
+    GLubyte header[ HEADER_SIZE ];
+    GLubyte* ptr = header;
+    memcpy( ptr, FILE_MAGIC, sizeof( FILE_MAGIC ) );
+    ptr += sizeof( FILE_MAGIC );
+    putUInt( ptr, FILE_VERSION );
+    putUInt( ptr, tileUnits );
+    putUInt( ptr, tileTexels );
+    putUInt( ptr, numLevels );
+    putUInt( ptr, xUnits );
+    putUInt( ptr, yUnits );
+    putFloat( ptr, xLen );
+    putFloat( ptr, yLen );
+    const TileInfo& top = info[ numLevels-1 ][ 0 ];
+    putFloat( ptr, top._minZ );
+    putFloat( ptr, top._maxZ );
+    putFloat( ptr, top._error );
+    putUInt( ptr, 0 );
+    putUInt( ptr, 0 );
+    putUInt( ptr, 0 );
+    assert( ptr == header + HEADER_SIZE );
+    bool ok = (fwrite( header, HEADER_SIZE, 1, f ) == 1);
+
+    const int tileSize = tileSizeBytes( tileUnits, tileTexels );
+    GLubyte* tile = new GLubyte[ tileSize ];
+    for (level=numLevels-1; ok && (level>=0); level--)
+    {
+        const int tilesX = tilesAcross( xUnits, tileUnits, level );
+        const int tilesY = tilesAcross( yUnits, tileUnits, level );
+        const int step = 1 << level;
+        const int span = tileUnits << level;
+
+        // Texel spacing in image pixels, for box filtering coarse
+        //   levels.
+        const float texelSpan = (tileTexels > 1) ? (float) span / (float)( tileTexels-1 ) : 0.f;
+        const float footX = texelSpan * imageW / (float) xUnits;
+        const float footY = texelSpan * imageH / (float) yUnits;
+        int samples = (int) ceil( (footX > footY) ? footX : footY );
+        if (samples < 1)
+            samples = 1;
+        else if (samples > 16)
+            samples = 16;
+
+        int tx, ty;
+        for (tx=0; ok && (tx<tilesX); tx++)
+        {
+            for (ty=0; ty<tilesY; ty++)
+            {
+                ptr = tile;
+                const int x0 = tx * span, y0 = ty * span;
+
+                int i, j;
+                for (i=0; i<=tileUnits; i++)
+                {
+                    int x = x0 + i*step;
+                    if (x > xUnits)
+                        x = xUnits;
+                    for (j=0; j<=tileUnits; j++)
+                    {
+                        int y = y0 + j*step;
+                        if (y > yUnits)
+                            y = yUnits;
+                        putFloat( ptr, zArray[ x*(yUnits+1) + y ] );
+                    }
+                }
+
+                // Texel centers fall on the tile's edges and spread
+                //   evenly between them, so that adjacent tiles agree
+                //   along their shared edge.
+                for (j=0; j<tileTexels; j++)
+                {
+                    float gy = y0 + j * texelSpan;
+                    if (gy > (float) yUnits)
+                        gy = (float) yUnits;
+                    for (i=0; i<tileTexels; i++)
+                    {
+                        float gx = x0 + i * texelSpan;
+                        if (gx > (float) xUnits)
+                            gx = (float) xUnits;
+
+                        const float px = gx * imageW / (float) xUnits - .5f;
+                        const float py = gy * imageH / (float) yUnits - .5f;
+                        float sum[ 4 ] = { 0.f, 0.f, 0.f, 0.f };
+                        int sx, sy;
+                        for (sx=0; sx<samples; sx++)
+                        {
+                            for (sy=0; sy<samples; sy++)
+                            {
+                                float rgba[ 4 ];
+                                sampleImage( image, imageW, imageH,
+                                        px + footX * ( (sx + .5f) / samples - .5f ),
+                                        py + footY * ( (sy + .5f) / samples - .5f ), rgba );
+                                int c;
+                                for (c=0; c<4; c++)
+                                    sum[ c ] += rgba[ c ];
+                            }
+                        }
+                        int c;
+                        for (c=0; c<4; c++)
+                            *ptr++ = (GLubyte)( sum[ c ] / (samples*samples) + .5f );
+                    }
+                }
+
+                int c;
+                for (c=0; c<4; c++)
+                {
+                    const int cx = tx*2 + (c & 1), cy = ty*2 + (c >> 1);
+                    const bool present = (level > 0) &&
+                            (cx < tilesAcross( xUnits, tileUnits, level-1 )) &&
+                            (cy < tilesAcross( yUnits, tileUnits, level-1 ));
+                    if (present)
+                    {
+                        const TileInfo& ci = info[ level-1 ][ cx*tilesAcross( yUnits, tileUnits, level-1 ) + cy ];
+                        putFloat( ptr, ci._minZ );
+                        putFloat( ptr, ci._maxZ );
+                        putFloat( ptr, ci._error );
+                        putUInt( ptr, 1 );
+                    }
+                    else
+                    {
+                        putFloat( ptr, 0.f );
+                        putFloat( ptr, 0.f );
+                        putFloat( ptr, 0.f );
+                        putUInt( ptr, 0 );
+                    }
+                }
+                assert( ptr == tile + tileSize );
+
+                if (fwrite( tile, tileSize, 1, f ) != 1)
+                {
+                    ok = false;
+                    break;
+                }
+            }
+        }
+    }
+    delete[] tile;
+
+    if (fclose( f ) != 0)
+        ok = false;
+    return ok;
+}
+
+
+
+// Static factory creation method
+TiledHeightField*
+TiledHeightField::create( const std::string& fileName, int maxCPUTiles, int maxGPUTiles )
+{
+    TiledHeightField* thf( NULL );
+
+    switch (OGLDif::instance()->getVersion())
+    {
+
+    case VerExtended:
+    case Ver20:
+    case Ver15:
+#ifdef GL_VERSION_1_5
+        thf = new TiledHeightField15( maxCPUTiles, maxGPUTiles );
+        break;
+#endif
+
+    case Ver14:
+    case Ver13:
+    case Ver12:
+    case Ver11:
+#ifdef GL_VERSION_1_1
+        thf = new TiledHeightField( maxCPUTiles, maxGPUTiles );
+        break;
+#endif
+
+    case Ver10:
+    case VerUnknown:
+    default:
+        assert( false );
+        return NULL;
+        break;
+    }
+
+    if (!thf->open( fileName ))
+    {
+        delete thf;
+        return NULL;
+    }
+    return thf;
+}
+
+
+TiledHeightField::TiledHeightField( int maxCPUTiles, int maxGPUTiles )
+  : _tileUnits( 0 ),
+    _tileTexels( 0 ),
+    _numLevels( 0 ),
+    _xUnits( 0 ),
+    _yUnits( 0 ),
+    _xLen( 0.f ),
+    _yLen( 0.f ),
+    _tileSize( 0 ),
+    _file( NULL ),
+    _loader( NULL ),
+    _threaded( false ),
+    _top( NULL ),
+    _maxCPUTiles( maxCPUTiles ),
+    _maxGPUTiles( maxGPUTiles ),
+    _frame( 0 ),
+    _pixelsPerUnit( 0. ),
+    _scale( 1. ),
+    _perspective( false ),
+    _uploads( 0 ),
+    _tilesDrawn( 0 ),
+    _trianglesDrawn( 0 ),
+    _valid( false )
+{
+    assert( OGLDif::instance()->getVersion() >= Ver11 );
+
+    // At least the four children of a tile must fit, so that it can
+    //   always refine.
+    if (_maxCPUTiles < 8)
+        _maxCPUTiles = 8;
+    if (_maxGPUTiles < 8)
+        _maxGPUTiles = 8;
+}
+
+TiledHeightField::~TiledHeightField()
+{
+    cancelBuild();
+    stopLoader();
+
+    TileMap::iterator it;
+    for (it=_tiles.begin(); it!=_tiles.end(); it++)
+    {
+        Tile* tile = it->second;
+        if (tile->_uploaded)
+            releaseTile( tile );
+        releaseCPU( tile );
+        delete tile;
+    }
+    _tiles.clear();
+    _cpuLRU.clear();
+    _gpuLRU.clear();
+    _top = NULL;
+
+    IndexMap::iterator iit;
+    for (iit=_indexMap.begin(); iit!=_indexMap.end(); iit++)
+        delete iit->second;
+    _indexMap.clear();
+
+    if (_file)
+        fclose( _file );
+    _file = NULL;
+}
+
+void
+TiledHeightField::stopLoader()
+{
+    if (_loader)
+        delete _loader;
+    _loader = NULL;
+}
+
+
+bool
+TiledHeightField::open( const std::string& fileName )
+{
+    _file = fopen( fileName.c_str(), "rb" );
+    if (_file == NULL)
+        return false;
+
+    GLubyte header[ HEADER_SIZE ];
+    if (fread( header, HEADER_SIZE, 1, _file ) != 1)
+        return false;
+    if (memcmp( header, FILE_MAGIC, sizeof( FILE_MAGIC ) ) != 0)
+        return false;
+
+    const GLubyte* ptr = header + sizeof( FILE_MAGIC );
+    if (getUInt( ptr ) != FILE_VERSION)
+        return false;
+    _tileUnits = getUInt( ptr );
+    _tileTexels = getUInt( ptr );
+    _numLevels = getUInt( ptr );
+    _xUnits = getUInt( ptr );
+    _yUnits = getUInt( ptr );
+    _xLen = getFloat( ptr );
+    _yLen = getFloat( ptr );
+    _topInfo._minZ = getFloat( ptr );
+    _topInfo._maxZ = getFloat( ptr );
+    _topInfo._error = getFloat( ptr );
+    _topInfo._present = true;
+
+    if ( (_tileUnits < 2) || (_tileUnits > 128) || (_xUnits < 1) || (_yUnits < 1) ||
+            (_numLevels != levelsFor( _xUnits, _yUnits, _tileUnits )) )
+        return false;
+
+    _tileSize = tileSizeBytes( _tileUnits, _tileTexels );
+    _levelStart.resize( _numLevels );
+    long start = HEADER_SIZE;
+    int level;
+    for (level=_numLevels-1; level>=0; level--)
+    {
+        _levelStart[ level ] = start;
+        start += (long) getTilesX( level ) * getTilesY( level ) * _tileSize;
+    }
+
+    const float halfX = (float) fabs( _xLen ) * .5f;
+    const float halfY = (float) fabs( _yLen ) * .5f;
+    _bound.setBox( -halfX, -halfY, _topInfo._minZ, halfX, halfY, _topInfo._maxZ );
+    _bound.setSphereFromBox();
+
+    return true;
+}
+
+bool
+TiledHeightField::init()
+{
+    // The top tile is always resident, so there's always something
+    //   to draw.
+    _top = getTile( _numLevels-1, 0, 0, _topInfo );
+    if (!readTile( _top ))
+        return false;
+    _top->_state = Loaded;
+    touchCPU( _top );
+
+    _loader = new TileLoader( this );
+    _threaded = _loader->start();
+
+    return( _valid = true );
+}
+
+
+void
+TiledHeightField::draw()
+{
+    if (!_valid)
+    {
+        if (!init())
+            return;
+    }
+
+    _frame++;
+
+    // Tiles the loader finished since the last draw() become CPU tiles.
+    std::vector< Tile* > loaded;
+    _loader->takeLoaded( loaded );
+    size_t idx;
+    for (idx=0; idx<loaded.size(); idx++)
+        touchCPU( loaded[ idx ] );
+
+    GLdouble proj[ 16 ];
+    GLint viewport[ 4 ];
+    getLODView( _modelView, proj, viewport );
+    _frustum.set( proj, _modelView );
+
+    // See Shape::drawLOD().
+    _scale = 0.;
+    int col;
+    for (col=0; col<3; col++)
+    {
+        const double* c = _modelView + col*4;
+        const double len = sqrt( c[0]*c[0] + c[1]*c[1] + c[2]*c[2] );
+        if (len > _scale)
+            _scale = len;
+    }
+    _pixelsPerUnit = fabs( proj[5] ) * viewport[3] * .5 * _scale;
+    _perspective = (proj[11] != 0.);
+
+    _drawList.clear();
+    _requests.clear();
+    _drawnLevel.clear();
+    _uploads = 0;
+    select( _top );
+
+    _tilesDrawn = _trianglesDrawn = 0;
+
+    glPushAttrib( GL_TEXTURE_BIT );
+    glPushClientAttrib( GL_CLIENT_VERTEX_ARRAY_BIT );
+
+    glEnableClientState( GL_VERTEX_ARRAY );
+    glEnableClientState( GL_NORMAL_ARRAY );
+    glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+
+    for (idx=0; idx<_drawList.size(); idx++)
+    {
+        const Tile* tile = _drawList[ idx ];
+
+        const IndexArray& indices = getIndices( tile );
+        setPointers( tile );
+        if (tile->_texId != 0)
+            glBindTexture( GL_TEXTURE_2D, tile->_texId );
+        glDrawElements( GL_TRIANGLES, indices.getCount(), indices.getType(), indices.getData() );
+
+        _tilesDrawn++;
+        _trianglesDrawn += indices.getCount() / 3;
+    }
+
+    glPopClientAttrib();
+    glPopAttrib();
+
+    if (_threaded)
+        _loader->setRequests( _requests );
+    else
+    {
+        // No thread support; load now.
+        for (idx=0; idx<_requests.size(); idx++)
+        {
+            readTile( _requests[ idx ] );
+            _requests[ idx ]->_state = Loaded;
+            touchCPU( _requests[ idx ] );
+        }
+    }
+
+    evict();
+
+
+    OGLDIF_CHECK_ERROR;
+}
+
+
+int
+TiledHeightField::getNumLevels() const
+{
+    return _numLevels;
+}
+
+int
+TiledHeightField::getTilesDrawn() const
+{
+    return _tilesDrawn;
+}
+
+int
+TiledHeightField::getTrianglesDrawn() const
+{
+    return _trianglesDrawn;
+}
+
+int
+TiledHeightField::getCPUTiles() const
+{
+    return (int) _cpuLRU.size();
+}
+
+int
+TiledHeightField::getGPUTiles() const
+{
+    return (int) _gpuLRU.size();
+}
+
+int
+TiledHeightField::getPendingTiles() const
+{
+    return( _loader ? _loader->getPending() : 0 );
+}
+
+void
+TiledHeightField::waitForLoads()
+{
+    if (_loader)
+        _loader->waitForIdle();
+}
+
+
+TiledHeightField::Tile*
+TiledHeightField::getTile( int level, int x, int y, const TileInfo& info )
+{
+    const TileKey key( level, std::pair< int, int >( x, y ) );
+    TileMap::iterator it = _tiles.find( key );
+    if (it != _tiles.end())
+        return it->second;
+
+    Tile* tile = new Tile;
+    tile->_level = level;
+    tile->_x = x;
+    tile->_y = y;
+    tile->_info = info;
+    tile->_state = Absent;
+    tile->_vertices = NULL;
+    tile->_texels = NULL;
+    tile->_childrenKnown = false;
+    tile->_uploaded = false;
+    tile->_texId = 0;
+    tile->_vbo = 0;
+    tile->_drawVertices = NULL;
+    tile->_lastUsed = _frame;
+    tile->_inCPU = tile->_inGPU = false;
+
+    const float xStep = _xLen / (float)_xUnits;
+    const float yStep = _yLen / (float)_yUnits;
+    const int span = _tileUnits << level;
+    const int x0 = x * span, y0 = y * span;
+    const int x1 = (x0 + span < _xUnits) ? x0 + span : _xUnits;
+    const int y1 = (y0 + span < _yUnits) ? y0 + span : _yUnits;
+    const float xa = -_xLen * .5f + x0 * xStep, xb = -_xLen * .5f + x1 * xStep;
+    const float ya = -_yLen * .5f + y0 * yStep, yb = -_yLen * .5f + y1 * yStep;
+    tile->_bound.setBox( (xa < xb) ? xa : xb, (ya < yb) ? ya : yb, info._minZ,
+            (xa < xb) ? xb : xa, (ya < yb) ? yb : ya, info._maxZ );
+    tile->_bound.setSphereFromBox();
+
+    _tiles[ key ] = tile;
+    return tile;
+}
+
+
+bool
+TiledHeightField::readTile( Tile* tile )
+{
+    GLubyte* buffer = new GLubyte[ _tileSize ];
+    bool ok = (fseek( _file, getTileOffset( tile->_level, tile->_x, tile->_y ), SEEK_SET ) == 0) &&
+            (fread( buffer, _tileSize, 1, _file ) == 1);
+    if (!ok)
+    {
+        delete[] buffer;
+        return false;
+    }
+
+    const int numVerts = (_tileUnits+1) * (_tileUnits+1);
+    const int step = 1 << tile->_level;
+    const int span = _tileUnits << tile->_level;
+    const int x0 = tile->_x * span, y0 = tile->_y * span;
+    const float xStep = _xLen / (float)_xUnits;
+    const float yStep = _yLen / (float)_yUnits;
+
+    const GLubyte* ptr = buffer;
+    float* heights = new float[ numVerts ];
+    int idx;
+    for (idx=0; idx<numVerts; idx++)
+        heights[ idx ] = getFloat( ptr );
+
+    tile->_vertices = new GLfloat[ numVerts * INTERLEAVED_FLOATS ];
+    GLfloat* vertPtr = tile->_vertices;
+    int i, j;
+    for (i=0; i<=_tileUnits; i++)
+    {
+        const int x = (x0 + i*step < _xUnits) ? x0 + i*step : _xUnits;
+        for (j=0; j<=_tileUnits; j++)
+        {
+            const int y = (y0 + j*step < _yUnits) ? y0 + j*step : _yUnits;
+
+            *vertPtr++ = -_xLen * .5f + x * xStep;
+            *vertPtr++ = -_yLen * .5f + y * yStep;
+            *vertPtr++ = heights[ i*(_tileUnits+1) + j ];
+
+            // Normal from the slopes within the tile; see
+            //   HeightField::buildGeometry().
+            const int ia = (i > 0) ? i-1 : i, ib = (i < _tileUnits) ? i+1 : i;
+            const int ja = (j > 0) ? j-1 : j, jb = (j < _tileUnits) ? j+1 : j;
+            const int xa = (x0 + ia*step < _xUnits) ? x0 + ia*step : _xUnits;
+            const int xb = (x0 + ib*step < _xUnits) ? x0 + ib*step : _xUnits;
+            const int ya = (y0 + ja*step < _yUnits) ? y0 + ja*step : _yUnits;
+            const int yb = (y0 + jb*step < _yUnits) ? y0 + jb*step : _yUnits;
+            const float dzdx = (xb > xa) ?
+                    (heights[ ib*(_tileUnits+1) + j ] - heights[ ia*(_tileUnits+1) + j ]) / (float)( xb - xa ) : 0.f;
+            const float dzdy = (yb > ya) ?
+                    (heights[ i*(_tileUnits+1) + jb ] - heights[ i*(_tileUnits+1) + ja ]) / (float)( yb - ya ) : 0.f;
+            Vec3d normal( -dzdx * yStep, -xStep * dzdy, xStep * yStep );
+            normal.normalize();
+            *vertPtr++ = (float) normal[0];
+            *vertPtr++ = (float) normal[1];
+            *vertPtr++ = (float) normal[2];
+
+            // Texel centers span the tile edge to edge; see writeFile().
+            if (_tileTexels > 0)
+            {
+                *vertPtr++ = ( .5f + i * (_tileTexels-1) / (float)_tileUnits ) / (float)_tileTexels;
+                *vertPtr++ = ( .5f + j * (_tileTexels-1) / (float)_tileUnits ) / (float)_tileTexels;
+            }
+            else
+            {
+                *vertPtr++ = (float)x / (float)_xUnits;
+                *vertPtr++ = (float)y / (float)_yUnits;
+            }
+        }
+    }
+    delete[] heights;
+
+    if (_tileTexels > 0)
+    {
+        const int texelBytes = _tileTexels * _tileTexels * 4;
+        tile->_texels = new GLubyte[ texelBytes ];
+        memcpy( tile->_texels, ptr, texelBytes );
+        ptr += texelBytes;
+    }
+
+    int c;
+    for (c=0; c<4; c++)
+    {
+        TileInfo& ci = tile->_children[ c ];
+        ci._minZ = getFloat( ptr );
+        ci._maxZ = getFloat( ptr );
+        ci._error = getFloat( ptr );
+        ci._present = (getUInt( ptr ) != 0);
+    }
+    tile->_childrenKnown = true;
+    assert( ptr == buffer + _tileSize );
+
+    delete[] buffer;
+    return true;
+}
+
+
+void
+TiledHeightField::select( Tile* tile )
+{
+    if (!_frustum.intersects( tile->_bound ))
+        return;
+
+    tile->_lastUsed = _frame;
+
+    bool refine = (tile->_level > 0) && tile->_childrenKnown;
+    if (refine && _lodEnable)
+    {
+        // Refine if the tile's error projects to more than the budget.
+        //   See HeightField::selectLevels().
+        double ppu = _pixelsPerUnit;
+        bool near = false;
+        if (_perspective)
+        {
+            const float* c = tile->_bound.getCenter();
+            const double eyeZ = -( _modelView[2]*c[0] + _modelView[6]*c[1] +
+                    _modelView[10]*c[2] + _modelView[14] );
+            const double nearest = eyeZ - tile->_bound.getRadius() * _scale;
+            if (nearest <= 0.)
+                near = true;
+            else
+                ppu /= nearest;
+        }
+        if ( !near && (tile->_info._error * ppu <= _lodPixelError) )
+            refine = false;
+    }
+
+    if (refine)
+    {
+        // Draw the visible children if all of them are ready;
+        //   otherwise, request them and draw this tile meanwhile.
+        Tile* children[ 4 ];
+        bool ready = true;
+        int c;
+        for (c=0; c<4; c++)
+        {
+            children[ c ] = NULL;
+            if (!tile->_children[ c ]._present)
+                continue;
+
+            Tile* child = getTile( tile->_level-1, tile->_x*2 + (c & 1), tile->_y*2 + (c >> 1),
+                    tile->_children[ c ] );
+            child->_lastUsed = _frame;
+            if (!_frustum.intersects( child->_bound ))
+                continue;
+
+            children[ c ] = child;
+            if (!makeDrawable( child ))
+                ready = false;
+        }
+
+        if (ready)
+        {
+            for (c=0; c<4; c++)
+            {
+                if (children[ c ])
+                    select( children[ c ] );
+            }
+            return;
+        }
+    }
+
+    if (!makeDrawable( tile ))
+        // Only possible for the top tile, if it failed to upload.
+        return;
+
+    _drawList.push_back( tile );
+    _drawnLevel[ TileKey( tile->_level, std::pair< int, int >( tile->_x, tile->_y ) ) ] = tile->_level;
+}
+
+bool
+TiledHeightField::makeDrawable( Tile* tile )
+{
+    if (tile->_uploaded)
+    {
+        touchGPU( tile );
+        return true;
+    }
+
+    TileState state;
+    {
+        ScopedLock lock( _loader->_mutex );
+        state = tile->_state;
+    }
+
+    if (state != Loaded)
+    {
+        _requests.push_back( tile );
+        return false;
+    }
+
+    if ( (tile->_vertices == NULL) || (_uploads >= MAX_UPLOADS_PER_DRAW) )
+        return false;
+
+    uploadTile( tile );
+    _uploads++;
+    touchCPU( tile );
+    touchGPU( tile );
+    return true;
+}
+
+
+const IndexArray&
+TiledHeightField::getIndices( const Tile* tile )
+{
+    // Stitch each side to the drawn tile across it, if that tile is
+    //   coarser. Finer neighbors stitch to this one.
+    const int nx[ 4 ] = { tile->_x, tile->_x+1, tile->_x, tile->_x-1 };
+    const int ny[ 4 ] = { tile->_y-1, tile->_y, tile->_y+1, tile->_y };
+    int maxSideLevel;
+    for (maxSideLevel=0; (2 << maxSideLevel) <= _tileUnits; maxSideLevel++)
+        ;
+    maxSideLevel--;
+
+    int sideLevel[ 4 ];
+    int key = 0;
+    int side;
+    for (side=0; side<4; side++)
+    {
+        sideLevel[ side ] = 0;
+        if ( (nx[ side ] >= 0) && (ny[ side ] >= 0) )
+        {
+            int level;
+            for (level=tile->_level; level<_numLevels; level++)
+            {
+                const int shift = level - tile->_level;
+                const TileKey key( level, std::pair< int, int >( nx[ side ] >> shift, ny[ side ] >> shift ) );
+                if (_drawnLevel.find( key ) != _drawnLevel.end())
+                {
+                    sideLevel[ side ] = shift;
+                    break;
+                }
+            }
+        }
+
+        // Neighbors more levels coarser than a tile has grid lines
+        //   are stitched as closely as the tile allows.
+        if (sideLevel[ side ] > maxSideLevel)
+            sideLevel[ side ] = maxSideLevel;
+        key |= sideLevel[ side ] << (side * 4);
+    }
+
+    IndexMap::const_iterator it = _indexMap.find( key );
+    if (it != _indexMap.end())
+        return *( it->second );
+
+    IndexArray* indices = new IndexArray;
+    buildChunkIndices( *indices, _tileUnits, 0, sideLevel );
+    _indexMap[ key ] = indices;
+    return *indices;
+}
+
+
+void
+TiledHeightField::touchCPU( Tile* tile )
+{
+    if (tile->_inCPU)
+        _cpuLRU.splice( _cpuLRU.begin(), _cpuLRU, tile->_cpuEntry );
+    else
+    {
+        _cpuLRU.push_front( tile );
+        tile->_inCPU = true;
+    }
+    tile->_cpuEntry = _cpuLRU.begin();
+}
+
+void
+TiledHeightField::touchGPU( Tile* tile )
+{
+    if (tile->_inGPU)
+        _gpuLRU.splice( _gpuLRU.begin(), _gpuLRU, tile->_gpuEntry );
+    else
+    {
+        _gpuLRU.push_front( tile );
+        tile->_inGPU = true;
+    }
+    tile->_gpuEntry = _gpuLRU.begin();
+}
+
+void
+TiledHeightField::evict()
+{
+    // GPU tiles, least recently used first, sparing any drawn this
+    //   frame.
+    std::list< Tile* >::iterator it = _gpuLRU.end();
+    while ( ((int) _gpuLRU.size() > _maxGPUTiles) && (it != _gpuLRU.begin()) )
+    {
+        it--;
+        Tile* tile = *it;
+        if ( (tile == _top) || (tile->_lastUsed == _frame) )
+            continue;
+
+        releaseTile( tile );
+        tile->_inGPU = false;
+        it = _gpuLRU.erase( it );
+    }
+
+    // CPU tiles. Drawn tiles no longer need theirs.
+    while ((int) _cpuLRU.size() > _maxCPUTiles)
+    {
+        Tile* tile = _cpuLRU.back();
+        if (tile == _top)
+        {
+            touchCPU( tile );
+            continue;
+        }
+        releaseCPU( tile );
+    }
+
+    // Forget tiles with nothing loaded that weren't wanted this frame.
+    ScopedLock lock( _loader->_mutex );
+    TileMap::iterator tit = _tiles.begin();
+    while (tit != _tiles.end())
+    {
+        Tile* tile = tit->second;
+        if ( (tile != _top) && !tile->_uploaded && (tile->_state == Absent) &&
+                (tile->_lastUsed != _frame) )
+        {
+            delete tile;
+            _tiles.erase( tit++ );
+        }
+        else
+            tit++;
+    }
+}
+
+void
+TiledHeightField::releaseCPU( Tile* tile )
+{
+    if (tile->_vertices)
+        delete[] tile->_vertices;
+    if (tile->_texels)
+        delete[] tile->_texels;
+    tile->_vertices = NULL;
+    tile->_texels = NULL;
+
+    if (tile->_inCPU)
+    {
+        _cpuLRU.erase( tile->_cpuEntry );
+        tile->_inCPU = false;
+
+        // Once the loader has stopped, no lock is needed.
+        if (_loader)
+        {
+            ScopedLock lock( _loader->_mutex );
+            tile->_state = Absent;
+        }
+        else
+            tile->_state = Absent;
+    }
+}
+
+
+void
+TiledHeightField::uploadTile( Tile* tile )
+{
+    // Vertices stay in client memory.
+    const int numFloats = (_tileUnits+1) * (_tileUnits+1) * INTERLEAVED_FLOATS;
+    tile->_drawVertices = new GLfloat[ numFloats ];
+    memcpy( tile->_drawVertices, tile->_vertices, numFloats * sizeof( GLfloat ) );
+
+    createTexture( tile, GL_CLAMP );
+
+    tile->_uploaded = true;
+}
+
+void
+TiledHeightField::releaseTile( Tile* tile )
+{
+    if (tile->_drawVertices)
+        delete[] tile->_drawVertices;
+    tile->_drawVertices = NULL;
+
+    if (tile->_texId != 0)
+        glDeleteTextures( 1, &tile->_texId );
+    tile->_texId = 0;
+
+    tile->_uploaded = false;
+}
+
+void
+TiledHeightField::setPointers( const Tile* tile )
+{
+    const GLsizei stride = INTERLEAVED_FLOATS * sizeof( GLfloat );
+    const GLfloat* base = tile->_drawVertices;
+
+    glVertexPointer( 3, GL_FLOAT, stride, base );
+    glNormalPointer( GL_FLOAT, stride, base + 3 );
+    glTexCoordPointer( 2, GL_FLOAT, stride, base + 6 );
+}
+
+void
+TiledHeightField::createTexture( Tile* tile, GLint wrap )
+{
+    if ( (_tileTexels == 0) || (tile->_texels == NULL) )
+        return;
+
+    glGenTextures( 1, &tile->_texId );
+    glBindTexture( GL_TEXTURE_2D, tile->_texId );
+
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR );
+    glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
+
+    buildMipmaps( GL_TEXTURE_2D, GL_RGBA, _tileTexels, _tileTexels,
+            GL_RGBA, GL_UNSIGNED_BYTE, tile->_texels );
+}
+
+
+long
+TiledHeightField::getTileOffset( int level, int x, int y ) const
+{
+    return( _levelStart[ level ] + (long)( x * getTilesY( level ) + y ) * _tileSize );
+}
+
+int
+TiledHeightField::getTilesX( int level ) const
+{
+    return tilesAcross( _xUnits, _tileUnits, level );
+}
+
+int
+TiledHeightField::getTilesY( int level ) const
+{
+    return tilesAcross( _yUnits, _tileUnits, level );
+}
+
+
+
+
+#ifdef GL_VERSION_1_5
+
+
+TiledHeightField15::TiledHeightField15( int maxCPUTiles, int maxGPUTiles )
+  : TiledHeightField( maxCPUTiles, maxGPUTiles )
+{
+    assert( OGLDif::instance()->getVersion() >= Ver15 );
+}
+
+TiledHeightField15::~TiledHeightField15()
+{
+    cancelBuild();
+    stopLoader();
+
+    TileMap::iterator it;
+    for (it=_tiles.begin(); it!=_tiles.end(); it++)
+    {
+        if (it->second->_uploaded)
+            releaseTile( it->second );
+    }
+}
+
+
+void
+TiledHeightField15::uploadTile( Tile* tile )
+{
+    glGenBuffers( 1, &tile->_vbo );
+    glBindBuffer( GL_ARRAY_BUFFER, tile->_vbo );
+    glBufferData( GL_ARRAY_BUFFER, (_tileUnits+1) * (_tileUnits+1) * INTERLEAVED_FLOATS * sizeof( GLfloat ),
+            tile->_vertices, GL_STATIC_DRAW );
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+    createTexture( tile, GL_CLAMP_TO_EDGE );
+
+    tile->_uploaded = true;
+}
+
+void
+TiledHeightField15::releaseTile( Tile* tile )
+{
+    if (tile->_vbo != 0)
+        glDeleteBuffers( 1, &tile->_vbo );
+    tile->_vbo = 0;
+
+    if (tile->_texId != 0)
+        glDeleteTextures( 1, &tile->_texId );
+    tile->_texId = 0;
+
+    tile->_uploaded = false;
+}
+
+void
+TiledHeightField15::setPointers( const Tile* tile )
+{
+    const GLsizei stride = INTERLEAVED_FLOATS * sizeof( GLfloat );
+
+    // glPopClientAttrib() in draw() restores the buffer binding.
+    glBindBuffer( GL_ARRAY_BUFFER, tile->_vbo );
+    glVertexPointer( 3, GL_FLOAT, stride, bufferObjectPtr( 0 ) );
+    glNormalPointer( GL_FLOAT, stride, bufferObjectPtr( NORMAL_OFFSET ) );
+    glTexCoordPointer( 2, GL_FLOAT, stride, bufferObjectPtr( TEXCOORD_OFFSET ) );
+}
+
+
+#endif
+
+
+
+
+TileLoader::TileLoader( TiledHeightField* owner )
+  : _owner( owner ),
+    _next( 0 ),
+    _busy( false ),
+    _quit( false )
+{
+}
+
+TileLoader::~TileLoader()
+{
+    {
+        ScopedLock lock( _mutex );
+        _quit = true;
+
+        size_t idx;
+        for (idx=_next; idx<_queue.size(); idx++)
+            _queue[ idx ]->_state = TiledHeightField::Absent;
+        _queue.clear();
+        _next = 0;
+    }
+    _work.signal();
+    join();
+}
+
+bool
+TileLoader::start()
+{
+    return Thread::start();
+}
+
+
+void
+TileLoader::setRequests( const std::vector< TiledHeightField::Tile* >& requests )
+{
+    {
+        ScopedLock lock( _mutex );
+
+        size_t idx;
+        for (idx=_next; idx<_queue.size(); idx++)
+            _queue[ idx ]->_state = TiledHeightField::Absent;
+        _queue.clear();
+        _next = 0;
+
+        for (idx=0; idx<requests.size(); idx++)
+        {
+            TiledHeightField::Tile* tile = requests[ idx ];
+            if (tile->_state == TiledHeightField::Absent)
+            {
+                tile->_state = TiledHeightField::Queued;
+                _queue.push_back( tile );
+            }
+        }
+    }
+
+    _work.signal();
+}
+
+void
+TileLoader::takeLoaded( std::vector< TiledHeightField::Tile* >& loaded )
+{
+    ScopedLock lock( _mutex );
+    loaded.swap( _loaded );
+    _loaded.clear();
+}
+
+int
+TileLoader::getPending()
+{
+    ScopedLock lock( _mutex );
+    return( (int)( _queue.size() - _next ) + (_busy ? 1 : 0) );
+}
+
+void
+TileLoader::waitForIdle()
+{
+    while (getPending() > 0)
+        _idle.wait();
+}
+
+
+void
+TileLoader::run()
+{
+    for (;;)
+    {
+        TiledHeightField::Tile* tile( NULL );
+        {
+            ScopedLock lock( _mutex );
+            if (_quit)
+                return;
+            if (_next < _queue.size())
+            {
+                tile = _queue[ _next++ ];
+                tile->_state = TiledHeightField::Loading;
+                _busy = true;
+            }
+        }
+
+        if (tile == NULL)
+        {
+            _idle.signal();
+            _work.wait();
+            continue;
+        }
+
+        _owner->readTile( tile );
+
+        {
+            ScopedLock lock( _mutex );
+            tile->_state = TiledHeightField::Loaded;
+            _loaded.push_back( tile );
+            _busy = false;
+        }
+    }
+}
+
+
+}
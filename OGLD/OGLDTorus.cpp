@@ -14,8 +14,13 @@
 #include "OGLDTorus.h"
 #include "OGLDif.h"
 #include "OGLDMath.h"
+#include "OGLDVertexCache.h"
+#include "OGLDMeshCache.h"
+#include "OGLDInstanceBuffer.h"
+#include "OGLDShapeTuner.h"
 #include <math.h>
 #include <assert.h>
+#include <stdio.h>
 
 
 
@@ -25,35 +30,37 @@ namespace ogld
 
 // Static factory creation methods
 Torus*
-Torus::create( float majRadius, float minRadius, int majApprox, int minApprox )
+Torus::create( float majRadius, float minRadius, int majApprox, int minApprox, VertexFormat format )
 {
-    switch (OGLDif::instance()->getVersion())
+    Torus* torus( NULL );
+
+    switch (ShapeTuner::instance()->getShapeVersion())
     {
 
     case VerExtended:
     case Ver20:
     case Ver15:
 #ifdef GL_VERSION_1_5
-        return new Torus15( majRadius, minRadius, majApprox, minApprox );
+        torus = new Torus15( majRadius, minRadius, majApprox, minApprox );
         break;
 #endif
 
     case Ver14:
     case Ver13:
 #ifdef GL_VERSION_1_3
-        return new Torus13( majRadius, minRadius, majApprox, minApprox );
+        torus = new Torus13( majRadius, minRadius, majApprox, minApprox );
         break;
 #endif
 
     case Ver12:
 #ifdef GL_VERSION_1_2
-        return new Torus12( majRadius, minRadius, majApprox, minApprox );
+        torus = new Torus12( majRadius, minRadius, majApprox, minApprox );
         break;
 #endif
 
     case Ver11:
 #ifdef GL_VERSION_1_1
-        return new Torus( majRadius, minRadius, majApprox, minApprox );
+        torus = new Torus( majRadius, minRadius, majApprox, minApprox );
         break;
 #endif
 
@@ -64,6 +71,9 @@ Torus::create( float majRadius, float minRadius, int majApprox, int minApprox )
         return NULL;
         break;
     }
+
+    torus->_vertexFormat = format;
+    return torus;
 }
 
 Torus::Torus( float majRadius, float minRadius, int majApprox, int minApprox )
@@ -74,7 +84,6 @@ Torus::Torus( float majRadius, float minRadius, int majApprox, int minApprox )
     _vertices( NULL ),
     _normals( NULL ),
     _texCoords( NULL ),
-    _indices( NULL ),
     _idxStart( 0 ),
     _idxEnd( 0 ),
     _valid( false ),
@@ -88,55 +97,215 @@ Torus::Torus( float majRadius, float minRadius, int majApprox, int minApprox )
         _majApprox = 3;
     if (_minApprox < 3)
         _minApprox = 3;
+
+    // The ring lies in the xz plane.
+    const float r = (float) fabs( _minRadius );
+    const float outer = (float) fabs( _majRadius ) + r;
+    _bound.setBox( -outer, -r, -outer, outer, r, outer );
+    _bound.setSphere( 0.f, 0.f, 0.f, outer );
 }
 
 Torus::~Torus()
 {
-    if ( _valid )
-    {
-        if (_dListAllocated)
-        {
-            glDeleteLists( _dList, 1 );
-            _dListAllocated = false;
-        }
+    cancelBuild();
 
-        if (_vertices)
-            delete[] _vertices;
-        if (_normals)
-            delete[] _normals;
-        if (_texCoords)
-            delete[] _texCoords;
-        if (_indices)
-            delete[] _indices;
-        _vertices = _normals = _texCoords = NULL;
-        _indices = NULL;
-        _valid = false;
+    if (_dListAllocated)
+    {
+        glDeleteLists( _dList, 1 );
+        _dListAllocated = false;
     }
+
+    freeHostArray( _vertices );
+    freeHostArray( _normals );
+    freeHostArray( _texCoords );
+    _indices.clear();
+    _valid = false;
 }
 
 void
 Torus::draw()
 {
+    if (drawLOD())
+        return;
+
     if (!_valid)
     {
         if (!init())
             return;
     }
 
+    if (_master)
+    {
+        _master->draw();
+        return;
+    }
+
     glCallList( _dList );
 
     OGLDIF_CHECK_ERROR;
 }
 
+bool
+Torus::getShareKey( std::string& key ) const
+{
+    char buf[ 128 ];
+    sprintf( buf, "Torus %.9g %.9g %d %d %d %d", _majRadius, _minRadius, _majApprox, _minApprox,
+            _numTextures, (int) _vertexFormat );
+    key = buf;
+    return true;
+}
+
+Shape*
+Torus::createMaster() const
+{
+    Torus* master = Torus::create( _majRadius, _minRadius, _majApprox, _minApprox, _vertexFormat );
+    master->setShared( false );
+    master->setTextures( _numTextures );
+    return master;
+}
+
+bool
+Torus::saveGeometry( MeshCacheWriter& writer ) const
+{
+    const int counts[ 4 ] = { _numVerts, _numIndices, (int) _idxStart, (int) _idxEnd };
+    writer.addInts( counts, 4 );
+    writer.addFloats( _vertices, _numVerts * 3 );
+    writer.addFloats( _normals, _numVerts * 3 );
+    writer.addFloats( _texCoords, _numVerts * 2 );
+    writer.addIndices( _indices );
+    return true;
+}
+
+bool
+Torus::loadGeometry( MeshCacheEntry& entry )
+{
+    int counts[ 4 ];
+    if ( !entry.getInts( counts, 4 ) || (counts[0] < 0) )
+        return false;
+    const GLfloat* vertices = entry.getFloats( counts[0] * 3 );
+    const GLfloat* normals = vertices ? entry.getFloats( counts[0] * 3 ) : NULL;
+    const GLfloat* texCoords = normals ? entry.getFloats( counts[0] * 2 ) : NULL;
+    if ( (texCoords == NULL) || !entry.getIndices( _indices ) )
+        return false;
+    if (_indices.getCount() != counts[1])
+    {
+        _indices.clear();
+        return false;
+    }
+
+    _numVerts = counts[0];
+    _numIndices = counts[1];
+    _idxStart = counts[2];
+    _idxEnd = counts[3];
+    _vertices = (GLfloat*) vertices;
+    _normals = (GLfloat*) normals;
+    _texCoords = (GLfloat*) texCoords;
+    return true;
+}
+
+bool
+Torus::getTriangles( int& numVerts, const float*& vertices, const float*& normals,
+        const float*& texCoords, int& texCoordSize, const IndexArray*& indices ) const
+{
+    numVerts = _numVerts;
+    vertices = _vertices;
+    normals = _normals;
+    texCoords = _texCoords;
+    texCoordSize = 2;
+    indices = &_indices;
+    return( _vertices != NULL );
+}
+
+// Approximation for LOD 'level': halved once per level, with a
+//   minimum of 3.
+static int
+lodApprox( int approx, int level )
+{
+    const int lod = approx >> level;
+    return( (lod < 3) ? 3 : lod );
+}
+
+float
+Torus::getLODError( int level ) const
+{
+    if (level < 0)
+        return -1.f;
+
+    const int majApprox = lodApprox( _majApprox, level );
+    const int minApprox = lodApprox( _minApprox, level );
+    if ( (level > 0) && (majApprox == lodApprox( _majApprox, level-1 )) &&
+            (minApprox == lodApprox( _minApprox, level-1 )) )
+        // No coarser than the previous level.
+        return -1.f;
+
+    // Sagitta of the outer equator's chords, plus that of the tube's.
+    return( (float)( (_majRadius + _minRadius) * (1. - cos( _PI / majApprox )) +
+            _minRadius * (1. - cos( _PI / minApprox )) ) );
+}
+
+Shape*
+Torus::createLOD( int level ) const
+{
+    if (getLODError( level ) < 0.f)
+        return NULL;
+
+    Torus* lod = Torus::create( _majRadius, _minRadius,
+            lodApprox( _majApprox, level ), lodApprox( _minApprox, level ), _vertexFormat );
+    lod->setShared( _shared );
+    lod->setTextures( _numTextures );
+    return lod;
+}
+
+void
+Torus::contextLost()
+{
+    Shape::contextLost();
+    if (_master)
+        return;
+
+    // The display list or buffer objects went with the context.
+    _dListAllocated = false;
+    _valid = false;
+}
+
+bool
+Torus::freeHostData()
+{
+    freeHostArray( _vertices );
+    freeHostArray( _normals );
+    freeHostArray( _texCoords );
+    _indices.releaseData();
+    return true;
+}
+
 bool
 Torus::init()
 {
-    if (!buildData())
+    if (acquireMaster())
+        return( _valid = true );
+
+    // Tessellate now, unless buildAsync() already started it.
+    if (!finishBuild())
         return false;
 
     if (!storeData())
         return false;
 
+    releaseHostData();
+    return true;
+}
+
+bool
+Torus::buildGeometry()
+{
+    if (!buildData())
+        return false;
+
+    optimizeTriangleList( _indices.getUIntData(), _numIndices, _numVerts,
+            _vertices, _normals, _texCoords, 2 );
+
+    _indices.pack( _numVerts );
+
     return true;
 }
 
@@ -144,12 +313,10 @@ bool
 Torus::buildData()
 {
     _numVerts = (_majApprox + 1) * (_minApprox + 1);
-    _numIndices = _majApprox * 2 * (_minApprox + 1);
-
-    if (_numIndices > 65535)
-        return false;
+    _numIndices = _majApprox * _minApprox * 6;
 
-    double delta = _2PI / _minApprox;
+    const float* minSinCos = sinCosTable( _minApprox );
+    const float* majSinCos = sinCosTable( _majApprox );
 
 
     //
@@ -159,100 +326,91 @@ Torus::buildData()
     _normals = new GLfloat[ _numVerts * 3 ];
     _vertices = new GLfloat[ _numVerts * 3 ];
 
-    GLfloat* texPtr = _texCoords;
-    GLfloat* normPtr = _normals;
-    GLfloat* vertPtr = _vertices;
-
-    double theta = 0.;
     int i;
-    for (i=_minApprox; i>=0; i--)
+    for (i=0; i<=_minApprox; i++)
     {
-        const float cosTheta = (float) cos( theta );
-        const float sinTheta = (float) sin( theta );
-
-        vertPtr[0] = cosTheta * _minRadius + _majRadius;
-        vertPtr[1] = sinTheta * _minRadius;
-        vertPtr[2] = 0.f;
-        vertPtr += 3;
+        const float cosTheta = minSinCos[ i*2 ];
+        const float sinTheta = minSinCos[ i*2+1 ];
 
-        normPtr[0] = cosTheta;
-        normPtr[1] = sinTheta;
-        normPtr[2] = 0.f;
-        normPtr += 3;
+        _vertices[ i*3 ] = cosTheta * _minRadius + _majRadius;
+        _vertices[ i*3+1 ] = sinTheta * _minRadius;
+        _vertices[ i*3+2 ] = 0.f;
 
-        texPtr[0] = 0.f;
-        texPtr[1] = (float)i / (float)_minApprox;
-        texPtr += 2;
+        _normals[ i*3 ] = cosTheta;
+        _normals[ i*3+1 ] = sinTheta;
+        _normals[ i*3+2 ] = 0.f;
 
-        theta += delta;
+        _texCoords[ i*2 ] = 0.f;
+        _texCoords[ i*2+1 ] = (float)( _minApprox - i ) / (float)_minApprox;
     }
 
 
     //
     // Rotate that circle around _maxApprox times.
-    //   Store them in the vertex and normal buffers.
-
-    delta = _2PI / _majApprox;
-    theta = delta;
-
+    //   Store them in the vertex and normal buffers. The loop body
+    //   has no dependencies between vertices, so the compiler can
+    //   vectorize it.
+
+    const int ringVerts = _minApprox + 1;
+    const GLfloat* srcVertPtr = _vertices;
+    const GLfloat* srcNormPtr = _normals;
+    const GLfloat* srcTexPtr = _texCoords;
     for (i=1; i<_majApprox+1; i++)
     {
-        GLfloat* srcNormPtr = _normals;
-        GLfloat* srcTexPtr = _texCoords;
-        GLfloat* srcVertPtr = _vertices;
+        const float cosTheta = majSinCos[ i*2 ];
+        const float sinTheta = majSinCos[ i*2+1 ];
+        const float s = (float)i / (float)_majApprox;
 
-        const float cosTheta = (float) cos( theta );
-        const float sinTheta = (float) sin( theta );
+        GLfloat* vertPtr = _vertices + i * ringVerts * 3;
+        GLfloat* normPtr = _normals + i * ringVerts * 3;
+        GLfloat* texPtr = _texCoords + i * ringVerts * 2;
 
         int j;
-        for (j=_minApprox; j>=0; j--)
+        for (j=0; j<ringVerts; j++)
         {
-            vertPtr[0] = cosTheta * srcVertPtr[0];
-            vertPtr[1] = srcVertPtr[1];
-            vertPtr[2] = -sinTheta * srcVertPtr[0];
-            vertPtr += 3;
-            srcVertPtr += 3;
-
-            normPtr[0] = cosTheta * srcNormPtr[0];
-            normPtr[1] = srcNormPtr[1];
-            normPtr[2] = -sinTheta * srcNormPtr[0];
-            normPtr += 3;
-            srcNormPtr += 3;
-
-            texPtr[0] = (float)i / (float)_majApprox;
-            texPtr[1] = srcTexPtr[1];
-            texPtr += 2;
-            srcTexPtr += 2;
-        }
+            vertPtr[ j*3 ] = cosTheta * srcVertPtr[ j*3 ];
+            vertPtr[ j*3+1 ] = srcVertPtr[ j*3+1 ];
+            vertPtr[ j*3+2 ] = -sinTheta * srcVertPtr[ j*3 ];
 
-        theta += delta;
+            normPtr[ j*3 ] = cosTheta * srcNormPtr[ j*3 ];
+            normPtr[ j*3+1 ] = srcNormPtr[ j*3+1 ];
+            normPtr[ j*3+2 ] = -sinTheta * srcNormPtr[ j*3 ];
+
+            texPtr[ j*2 ] = s;
+            texPtr[ j*2+1 ] = srcTexPtr[ j*2+1 ];
+        }
     }
 
 
-    // Finally, create indices into the arrays, making _majApprox
-    //   quad strips, each with (_minApprox+1)*2 indices
+    // Finally, create indices into the arrays, making one triangle
+    //   list with two triangles for each of the
+    //   _majApprox * _minApprox quads.
 
-    _indices = new GLushort[ _numIndices ];
-    GLushort* indexPtr = _indices;
+    GLuint* indexPtr = _indices.allocate( _numIndices );
 
     _idxStart = 0;
     _idxEnd = _numVerts-1;
 
     for (i=0; i<_majApprox; i++)
     {
-        int index;
         int j;
-        for (j=0; j<_minApprox+1; j++)
+        for (j=0; j<_minApprox; j++)
         {
-            index = (i*(_minApprox+1) + j) % _numVerts;
-            assert( index < _numVerts );
-            assert( index >= 0 );
-            *indexPtr++ = index;
-
-            index = (i*(_minApprox+1) + j + _minApprox+1) % _numVerts;
-            assert( index < _numVerts );
-            assert( index >= 0 );
-            *indexPtr++ = index;
+            const GLuint v0 = i*(_minApprox+1) + j;
+            const GLuint v1 = v0 + _minApprox+1;
+            const GLuint v2 = v0 + 1;
+            const GLuint v3 = v1 + 1;
+            assert( (int)v3 < _numVerts );
+
+            // Split along the v0-v3 diagonal, as GL_QUAD_STRIP
+            //   rasterization commonly does, to keep the same shading.
+            *indexPtr++ = v0;
+            *indexPtr++ = v1;
+            *indexPtr++ = v3;
+
+            *indexPtr++ = v0;
+            *indexPtr++ = v3;
+            *indexPtr++ = v2;
         }
     }
 
@@ -281,7 +439,7 @@ Torus::storeData()
     glTexCoordPointer( 2, GL_FLOAT, 0, _texCoords );
 
 
-    glDrawElements( GL_QUAD_STRIP, _numIndices, GL_UNSIGNED_SHORT, _indices );
+    glDrawElements( GL_TRIANGLES, _numIndices, _indices.getType(), _indices.getData() );
 
     glPopClientAttrib();
 
@@ -308,6 +466,7 @@ Torus12::Torus12( float majRadius, float minRadius, int majApprox, int minApprox
 
 Torus12::~Torus12()
 {
+    cancelBuild();
 }
 
 
@@ -332,7 +491,7 @@ Torus12::storeData()
     glTexCoordPointer( 2, GL_FLOAT, 0, _texCoords );
 
 
-    glDrawRangeElements( GL_QUAD_STRIP, _idxStart, _idxEnd, _numIndices, GL_UNSIGNED_SHORT, _indices );
+    glDrawRangeElements( GL_TRIANGLES, _idxStart, _idxEnd, _numIndices, _indices.getType(), _indices.getData() );
 
     glPopClientAttrib();
 
@@ -362,6 +521,7 @@ Torus13::Torus13( float majRadius, float minRadius, int majApprox, int minApprox
 
 Torus13::~Torus13()
 {
+    cancelBuild();
 }
 
 
@@ -391,7 +551,7 @@ Torus13::storeData()
     }
 
 
-    glDrawRangeElements( GL_QUAD_STRIP, _idxStart, _idxEnd, _numIndices, GL_UNSIGNED_SHORT, _indices );
+    glDrawRangeElements( GL_TRIANGLES, _idxStart, _idxEnd, _numIndices, _indices.getType(), _indices.getData() );
 
     glPopClientAttrib();
 
@@ -413,56 +573,146 @@ Torus13::storeData()
 #ifdef GL_VERSION_1_5
 
 
-// Static indices into the _vbo vertex buffer array
-int Torus15::_vertIdx( 0 );
-int Torus15::_normIdx( 1 );
-int Torus15::_texIdx( 2 );
-int Torus15::_idxIdx( 3 );
+// Layout of the interleaved vertex buffer object: three position
+//   floats, three normal floats, and two texture coordinate floats.
+static const int INTERLEAVED_FLOATS( 8 );
+static const unsigned int NORMAL_OFFSET( 3 * sizeof( GLfloat ) );
+static const unsigned int TEXCOORD_OFFSET( 6 * sizeof( GLfloat ) );
 
 
 Torus15::Torus15( float majRadius, float minRadius, int majApprox, int minApprox )
-  : Torus( majRadius, minRadius, majApprox, minApprox )
+  : Torus( majRadius, minRadius, majApprox, minApprox ),
+    _vertBlock( NULL ),
+    _idxBlock( NULL )
 {
     assert( OGLDif::instance()->getVersion() >= Ver15 );
 }
 
 Torus15::~Torus15()
 {
-    if ( _valid )
-        glDeleteBuffers( 3, _vbo );
+    cancelBuild();
+
+    if ( _valid && (_master == NULL) )
+    {
+        BufferArena::instance()->release( _vertBlock );
+        BufferArena::instance()->release( _idxBlock );
+    }
+}
+
+void
+Torus15::contextLost()
+{
+    // Return the blocks to their lost page. BufferArena::release()
+    //   makes no OpenGL calls.
+    if ( _valid && (_master == NULL) )
+    {
+        BufferArena::instance()->release( _vertBlock );
+        BufferArena::instance()->release( _idxBlock );
+        _vertBlock = _idxBlock = NULL;
+    }
+
+    Torus::contextLost();
 }
 
 
 void
 Torus15::draw()
 {
+    if (drawLOD())
+        return;
+
     if (!_valid)
     {
         if (!init())
             return;
     }
 
+    if (_master)
+    {
+        _master->draw();
+        return;
+    }
+
     glPushClientAttrib( GL_CLIENT_VERTEX_ARRAY_BIT );
 
-    glEnableClientState( GL_VERTEX_ARRAY );
-    glBindBuffer( GL_ARRAY_BUFFER, _vbo[_vertIdx] );
-    glVertexPointer( 3, GL_FLOAT, 0, bufferObjectPtr( 0 ) );
+    if (_vertexFormat == CompactVertexFormat)
+        _compact.pushTransform( _numTextures );
+    setPointers();
 
-    glEnableClientState( GL_NORMAL_ARRAY );
-    glBindBuffer( GL_ARRAY_BUFFER, _vbo[_normIdx] );
-    glNormalPointer( GL_FLOAT, 0, bufferObjectPtr( 0 ) );
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, _idxBlock->getBuffer() );
+    glDrawRangeElements( GL_TRIANGLES, _idxStart, _idxEnd, _numIndices, _indices.getType(), bufferObjectPtr( _idxBlock->getOffset() ) );
 
-    int tIdx;
-    for (tIdx=0; tIdx<_numTextures; tIdx++)
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
+
+    glPopClientAttrib();
+
+    if (_vertexFormat == CompactVertexFormat)
+        _compact.popTransform( _numTextures );
+
+
+    OGLDIF_CHECK_ERROR;
+}
+
+void
+Torus15::setPointers() const
+{
+    glBindBuffer( GL_ARRAY_BUFFER, _vertBlock->getBuffer() );
+    const GLuint base = (GLuint) _vertBlock->getOffset();
+
+    if (_vertexFormat == CompactVertexFormat)
+        _compact.setPointers( (const GLubyte*) bufferObjectPtr( base ), _numTextures );
+    else
     {
-        glClientActiveTexture( GL_TEXTURE0 + tIdx );
-        glEnableClientState( GL_TEXTURE_COORD_ARRAY );
-        glBindBuffer( GL_ARRAY_BUFFER, _vbo[_texIdx] );
-        glTexCoordPointer( 2, GL_FLOAT, 0, bufferObjectPtr( 0 ) );
+        const GLsizei stride = INTERLEAVED_FLOATS * sizeof( GLfloat );
+
+        glEnableClientState( GL_VERTEX_ARRAY );
+        glVertexPointer( 3, GL_FLOAT, stride, bufferObjectPtr( base ) );
+
+        glEnableClientState( GL_NORMAL_ARRAY );
+        glNormalPointer( GL_FLOAT, stride, bufferObjectPtr( base + NORMAL_OFFSET ) );
+
+        int tIdx;
+        for (tIdx=0; tIdx<_numTextures; tIdx++)
+        {
+            glClientActiveTexture( GL_TEXTURE0 + tIdx );
+            glEnableClientState( GL_TEXTURE_COORD_ARRAY );
+            glTexCoordPointer( 2, GL_FLOAT, stride, bufferObjectPtr( base + TEXCOORD_OFFSET ) );
+        }
     }
+}
 
-    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, _vbo[_idxIdx] );
-    glDrawRangeElements( GL_QUAD_STRIP, _idxStart, _idxEnd, _numIndices, GL_UNSIGNED_SHORT, 0 );
+bool
+Torus15::drawInstancedElements( int count, InstanceBuffer& instances )
+{
+#ifdef GL_VERSION_3_3
+    if (!_valid)
+    {
+        // Like draw(), draw nothing until a buildAsync() finishes.
+        if (!init())
+            return true;
+    }
+
+    if (_master)
+    {
+        _master->drawInstanced( count, instances );
+        return true;
+    }
+
+    glPushClientAttrib( GL_CLIENT_VERTEX_ARRAY_BIT );
+
+    setPointers();
+    if (!instances.bind())
+    {
+        glBindBuffer( GL_ARRAY_BUFFER, 0 );
+        glPopClientAttrib();
+        return false;
+    }
+
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, _idxBlock->getBuffer() );
+    glDrawElementsInstanced( GL_TRIANGLES, _numIndices, _indices.getType(), bufferObjectPtr( _idxBlock->getOffset() ), count );
+
+    instances.unbind();
 
     glBindBuffer( GL_ARRAY_BUFFER, 0 );
     glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
@@ -471,24 +721,51 @@ Torus15::draw()
 
 
     OGLDIF_CHECK_ERROR;
+
+    return true;
+#else
+    return false;
+#endif
 }
 
 bool
 Torus15::storeData()
 {
-    glGenBuffers( 4, _vbo );
-
-    glBindBuffer( GL_ARRAY_BUFFER, _vbo[_texIdx] );
-    glBufferData( GL_ARRAY_BUFFER, _numVerts*2*sizeof(GLfloat), _texCoords, GL_STATIC_DRAW );
+    if (_vertexFormat == CompactVertexFormat)
+    {
+        _compact.build( _numVerts, _vertices, _normals, _texCoords, 2 );
+        _vertBlock = BufferArena::instance()->allocate( GL_ARRAY_BUFFER, _compact.getSizeBytes(), _compact.getData() );
+        _compact.releaseData();
+        _compact.getErrors( _positionError, _normalError, _texCoordError );
+    }
+    else
+    {
+        // Interleave the vertex data so that each vertex is fetched
+        //   from one buffer object with a single bind.
+        GLfloat* interleaved = new GLfloat[ _numVerts * INTERLEAVED_FLOATS ];
+        GLfloat* destPtr = interleaved;
+        const GLfloat* vertPtr = _vertices;
+        const GLfloat* normPtr = _normals;
+        const GLfloat* texPtr = _texCoords;
+        int idx;
+        for (idx=0; idx<_numVerts; idx++)
+        {
+            *destPtr++ = *vertPtr++;
+            *destPtr++ = *vertPtr++;
+            *destPtr++ = *vertPtr++;
+            *destPtr++ = *normPtr++;
+            *destPtr++ = *normPtr++;
+            *destPtr++ = *normPtr++;
+            *destPtr++ = *texPtr++;
+            *destPtr++ = *texPtr++;
+        }
 
-    glBindBuffer( GL_ARRAY_BUFFER, _vbo[_normIdx] );
-    glBufferData( GL_ARRAY_BUFFER, _numVerts*3*sizeof(GLfloat), _normals, GL_STATIC_DRAW );
+        _vertBlock = BufferArena::instance()->allocate( GL_ARRAY_BUFFER, _numVerts*INTERLEAVED_FLOATS*sizeof(GLfloat), interleaved );
 
-    glBindBuffer( GL_ARRAY_BUFFER, _vbo[_vertIdx] );
-    glBufferData( GL_ARRAY_BUFFER, _numVerts*3*sizeof(GLfloat), _vertices, GL_STATIC_DRAW );
+        delete[] interleaved;
+    }
 
-    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, _vbo[_idxIdx] );
-    glBufferData( GL_ELEMENT_ARRAY_BUFFER, _numIndices*sizeof(GLushort), _indices, GL_STATIC_DRAW );
+    _idxBlock = BufferArena::instance()->allocate( GL_ELEMENT_ARRAY_BUFFER, _indices.getSizeBytes(), _indices.getData() );
 
     glBindBuffer( GL_ARRAY_BUFFER, 0 );
     glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, 0 );
@@ -0,0 +1,346 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+// 
+
+
+#include "OGLDPlatformGL.h"
+#include "OGLDVertexCache.h"
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+#include <assert.h>
+
+
+
+namespace ogld
+{
+
+
+// Scoring parameters, as suggested by Forsyth.
+static const int MAX_CACHE( 32 );
+static const float CACHE_DECAY_POWER( 1.5f );
+static const float LAST_TRI_SCORE( .75f );
+static const float VALENCE_BOOST_SCALE( 2.f );
+static const float VALENCE_BOOST_POWER( .5f );
+
+static const GLuint NOT_REMAPPED( 0xffffffff );
+
+
+static float
+vertexScore( int cachePos, int activeTris )
+{
+    if (activeTris == 0)
+        // No triangles left that use this vertex.
+        return -1.f;
+
+    float score = 0.f;
+    if (cachePos >= 0)
+    {
+        if (cachePos < 3)
+            // The vertices of the triangle just added get a fixed
+            //   score, so the next triangle isn't chosen merely
+            //   because it shares an edge with the last one.
+            score = LAST_TRI_SCORE;
+        else
+        {
+            const float scaler = 1.f / (MAX_CACHE - 3);
+            score = (float) pow( 1.f - (cachePos - 3) * scaler, CACHE_DECAY_POWER );
+        }
+    }
+
+    // Boost vertices with few triangles left, so that they're finished
+    //   off rather than left behind as isolated triangles.
+    score += VALENCE_BOOST_SCALE * (float) pow( (float) activeTris, -VALENCE_BOOST_POWER );
+
+    return score;
+}
+
+
+void
+optimizeVertexCache( GLuint* indices, int numIndices, int numVerts )
+{
+    if ( (numIndices < 3) || (numVerts <= 0) )
+        return;
+    const int numTris = numIndices / 3;
+
+    int idx;
+
+
+    //
+    // Build the list of triangles that use each vertex.
+    //   The triangles of vertex v are triList[ triStart[v] ] through
+    //   triList[ triStart[v] + activeTris[v] - 1 ]. Triangles are
+    //   moved past the end of this range as they're added.
+    int* activeTris = new int[ numVerts ];
+    int* triStart = new int[ numVerts ];
+    int* cachePos = new int[ numVerts ];
+    float* vertScore = new float[ numVerts ];
+    int* triList = new int[ numIndices ];
+
+    memset( activeTris, 0, numVerts * sizeof( int ) );
+    for (idx=0; idx<numIndices; idx++)
+    {
+        assert( (int)indices[idx] < numVerts );
+        activeTris[ indices[idx] ]++;
+    }
+
+    int v;
+    int start = 0;
+    for (v=0; v<numVerts; v++)
+    {
+        triStart[v] = start;
+        // Use cachePos as a fill counter for now.
+        cachePos[v] = start;
+        start += activeTris[v];
+    }
+    for (idx=0; idx<numIndices; idx++)
+        triList[ cachePos[ indices[idx] ]++ ] = idx / 3;
+
+
+    //
+    // Initial scores. Nothing is in the cache yet.
+    for (v=0; v<numVerts; v++)
+    {
+        cachePos[v] = -1;
+        vertScore[v] = vertexScore( -1, activeTris[v] );
+    }
+
+    float* triScore = new float[ numTris ];
+    bool* triAdded = new bool[ numTris ];
+    int bestTri = 0;
+    int t;
+    for (t=0; t<numTris; t++)
+    {
+        triScore[t] = vertScore[ indices[t*3] ] +
+            vertScore[ indices[t*3+1] ] +
+            vertScore[ indices[t*3+2] ];
+        triAdded[t] = false;
+        if (triScore[t] > triScore[bestTri])
+            bestTri = t;
+    }
+
+
+    //
+    // Add triangles one at a time, always choosing the highest
+    //   scoring triangle that uses a vertex in the cache.
+    GLuint* newIndices = new GLuint[ numTris * 3 ];
+    GLuint* outPtr = newIndices;
+    int cache[ MAX_CACHE + 3 ];
+    int cacheCount = 0;
+    int nextUnadded = 0;
+
+    int n;
+    for (n=0; n<numTris; n++)
+    {
+        if (bestTri < 0)
+        {
+            // Nothing in the cache has any triangles left. Start
+            //   again from the next triangle not yet added.
+            while (triAdded[ nextUnadded ])
+                nextUnadded++;
+            bestTri = nextUnadded;
+        }
+
+        const GLuint* tri = &( indices[ bestTri*3 ] );
+        triAdded[ bestTri ] = true;
+        *outPtr++ = tri[0];
+        *outPtr++ = tri[1];
+        *outPtr++ = tri[2];
+
+        int newCache[ MAX_CACHE + 3 ];
+        int newCount = 0;
+        int c;
+        for (c=0; c<3; c++)
+        {
+            v = tri[c];
+
+            // Move the triangle out of the vertex's active range.
+            int* list = &( triList[ triStart[v] ] );
+            const int last = activeTris[v] - 1;
+            int k;
+            for (k=0; list[k] != bestTri; k++)
+                assert( k < last );
+            list[k] = list[last];
+            list[last] = bestTri;
+            activeTris[v]--;
+
+            // The triangle's vertices go to the front of the cache.
+            if ( ((c < 1) || (tri[0] != tri[c])) &&
+                    ((c < 2) || (tri[1] != tri[c])) )
+                newCache[ newCount++ ] = v;
+        }
+        for (c=0; c<cacheCount; c++)
+        {
+            v = cache[c];
+            if ( ((int)tri[0] != v) && ((int)tri[1] != v) && ((int)tri[2] != v) )
+                newCache[ newCount++ ] = v;
+        }
+
+
+        // Rescore the vertices whose cache position changed, including
+        //   those that just fell out, and then their triangles.
+        for (c=0; c<newCount; c++)
+        {
+            v = newCache[c];
+            cachePos[v] = (c < MAX_CACHE) ? c : -1;
+            vertScore[v] = vertexScore( cachePos[v], activeTris[v] );
+        }
+
+        bestTri = -1;
+        float bestScore = -1.f;
+        for (c=0; c<newCount; c++)
+        {
+            v = newCache[c];
+            const int* list = &( triList[ triStart[v] ] );
+            int k;
+            for (k=0; k<activeTris[v]; k++)
+            {
+                t = list[k];
+                triScore[t] = vertScore[ indices[t*3] ] +
+                    vertScore[ indices[t*3+1] ] +
+                    vertScore[ indices[t*3+2] ];
+                if (triScore[t] > bestScore)
+                {
+                    bestScore = triScore[t];
+                    bestTri = t;
+                }
+            }
+        }
+
+        cacheCount = (newCount < MAX_CACHE) ? newCount : MAX_CACHE;
+        memcpy( cache, newCache, cacheCount * sizeof( int ) );
+    }
+
+    memcpy( indices, newIndices, numTris * 3 * sizeof( GLuint ) );
+
+    delete[] newIndices;
+    delete[] triAdded;
+    delete[] triScore;
+    delete[] triList;
+    delete[] vertScore;
+    delete[] cachePos;
+    delete[] triStart;
+    delete[] activeTris;
+}
+
+
+void
+reorderVertices( GLuint* indices, int numIndices, int numVerts, GLuint* remap )
+{
+    int v;
+    for (v=0; v<numVerts; v++)
+        remap[v] = NOT_REMAPPED;
+
+    GLuint next = 0;
+    int idx;
+    for (idx=0; idx<numIndices; idx++)
+    {
+        GLuint& index = indices[idx];
+        assert( (int)index < numVerts );
+        if (remap[ index ] == NOT_REMAPPED)
+            remap[ index ] = next++;
+        index = remap[ index ];
+    }
+
+    for (v=0; v<numVerts; v++)
+    {
+        if (remap[v] == NOT_REMAPPED)
+            remap[v] = next++;
+    }
+}
+
+void
+remapVertexArray( GLfloat* data, int components, int numVerts, const GLuint* remap )
+{
+    if ( (numVerts <= 0) || (components <= 0) || (data == NULL) )
+        return;
+
+    const size_t count = (size_t) numVerts * (size_t) components;
+    GLfloat* temp = new GLfloat[ count ];
+
+    int v;
+    for (v=0; v<numVerts; v++)
+        std::copy( data + v * components, data + (v+1) * components,
+                temp + remap[v] * components );
+    std::copy( temp, temp + count, data );
+
+    delete[] temp;
+}
+
+
+void
+optimizeTriangleList( GLuint* indices, int numIndices, int numVerts,
+        GLfloat* vertices, GLfloat* normals, GLfloat* texCoords, int texComponents )
+{
+    optimizeVertexCache( indices, numIndices, numVerts );
+
+    GLuint* remap = new GLuint[ numVerts ];
+    reorderVertices( indices, numIndices, numVerts, remap );
+    remapVertexArray( vertices, 3, numVerts, remap );
+    remapVertexArray( normals, 3, numVerts, remap );
+    if ( (texCoords != NULL) && (texComponents > 0) )
+        remapVertexArray( texCoords, texComponents, numVerts, remap );
+    delete[] remap;
+}
+
+
+float
+computeACMR( GLenum mode, const GLuint* indices, int numIndices, int cacheSize )
+{
+    int numTris;
+    switch (mode)
+    {
+    case GL_TRIANGLES:
+        numTris = numIndices / 3;
+        break;
+    case GL_TRIANGLE_STRIP:
+    case GL_TRIANGLE_FAN:
+    case GL_QUAD_STRIP:
+        numTris = numIndices - 2;
+        break;
+    default:
+        assert( false );
+        return 0.f;
+    }
+    if (numTris <= 0)
+        return 0.f;
+
+    GLuint* fifo = new GLuint[ cacheSize ];
+    int fifoCount = 0;
+    int fifoNext = 0;
+    int misses = 0;
+
+    int idx;
+    for (idx=0; idx<numIndices; idx++)
+    {
+        int c;
+        for (c=0; c<fifoCount; c++)
+        {
+            if (fifo[c] == indices[idx])
+                break;
+        }
+        if (c < fifoCount)
+            continue;
+
+        misses++;
+        fifo[ fifoNext ] = indices[idx];
+        fifoNext = (fifoNext + 1) % cacheSize;
+        if (fifoCount < cacheSize)
+            fifoCount++;
+    }
+
+    delete[] fifo;
+
+    return( (float)misses / (float)numTris );
+}
+
+
+}
@@ -90,6 +90,24 @@ View::multMatrix() const
     glTranslated( -pos[0], -pos[1], -pos[2] );
 }
 
+void
+View::getMatrix( double* m ) const
+{
+    double dir[3], up[3], cross[3], pos[3];
+
+    getView( dir, up, cross, pos );
+
+    m[0]=cross[0]; m[4]=cross[1]; m[8]=cross[2];
+    m[1]=up[0]; m[5]=up[1]; m[9]=up[2];
+    m[2]=-dir[0]; m[6]=-dir[1]; m[10]=-dir[2];
+    m[3]=0.; m[7]=0.; m[11]=0.; m[15] = 1.;
+
+    // Fold in the translation by -pos.
+    m[12] = -( m[0]*pos[0] + m[4]*pos[1] + m[8]*pos[2] );
+    m[13] = -( m[1]*pos[0] + m[5]*pos[1] + m[9]*pos[2] );
+    m[14] = -( m[2]*pos[0] + m[6]*pos[1] + m[10]*pos[2] );
+}
+
 void
 View::loadInverseAffine() const
 {
@@ -28,6 +28,7 @@
 #include <sstream>
 #include <vector>
 #include <string>
+#include <stdio.h>
 #include <assert.h>
 
 
@@ -56,7 +57,9 @@ OGLDif::instance()
 OGLDif::OGLDif()
   : _valid( false ),
     _dlHandle( NULL ),
-    _version( VerUnknown )
+    _version( VerUnknown ),
+    _instancing( false ),
+    _textureNPOT( false )
 {
     //
     // Prime the data path with likely paths
@@ -76,6 +79,24 @@ OGLDif::getVersion()
     return _version;
 }
 
+bool
+OGLDif::isInstancingSupported()
+{
+    if (!_valid)
+        validate();
+
+    return _instancing;
+}
+
+bool
+OGLDif::isTextureNPOTSupported()
+{
+    if (!_valid)
+        validate();
+
+    return _textureNPOT;
+}
+
 void
 OGLDif::validate()
 {
@@ -131,6 +152,20 @@ OGLDif::validate()
 
     _valid = true;
 
+    // Instancing also needs the version 2.0 shader entry points.
+    _instancing = (versionNum >= 33);
+    if ( !_instancing && (_version >= Ver20) )
+    {
+        const GLubyte* extensions = glGetString( GL_EXTENSIONS );
+        _instancing = isExtensionSupported( "GL_ARB_draw_instanced", extensions ) &&
+                isExtensionSupported( "GL_ARB_instanced_arrays", extensions );
+    }
+
+    _textureNPOT = (_version >= Ver20);
+    if (!_textureNPOT)
+        _textureNPOT = isExtensionSupported( "GL_ARB_texture_non_power_of_two",
+                glGetString( GL_EXTENSIONS ) );
+
 
     //
     // Define function pointers for entry points declared
@@ -405,6 +440,20 @@ OGLDif::validate()
         glVertexAttribPointer = (PFNGLVERTEXATTRIBPOINTERPROC) getProcAddress( "glVertexAttribPointer" );
     }
 #endif
+
+#if defined( GL_VERSION_3_3 ) && defined( __OGLD_NEED_3_3 )
+    if (_instancing)
+    {
+        // Before 3.3, the entry points have ARB suffixes.
+        const std::string suffix( (versionNum >= 33) ? "" : "ARB" );
+        glDrawElementsInstanced = (PFNGLDRAWELEMENTSINSTANCEDPROC) getProcAddress( ("glDrawElementsInstanced" + suffix).c_str() );
+        glVertexAttribDivisor = (PFNGLVERTEXATTRIBDIVISORPROC) getProcAddress( ("glVertexAttribDivisor" + suffix).c_str() );
+        _instancing = (glDrawElementsInstanced != NULL) && (glVertexAttribDivisor != NULL);
+    }
+#elif !defined( GL_VERSION_3_3 )
+    // No declarations for the instanced entry points.
+    _instancing = false;
+#endif
 }
 
 
@@ -481,6 +530,24 @@ OGLDif::clearDataPath()
     _dataPath.empty();
 }
 
+std::string
+OGLDif::findDataFile( const std::string& fileName ) const
+{
+    unsigned int idx;
+    for (idx=0; idx<_dataPath.size(); idx++)
+    {
+        const std::string fullPath( _dataPath[ idx ] + fileName );
+        FILE* file = fopen( fullPath.c_str(), "rb" );
+        if (file)
+        {
+            fclose( file );
+            return fullPath;
+        }
+    }
+
+    return std::string( "" );
+}
+
 
 void
 OGLDif::checkError()
@@ -0,0 +1,58 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+// 
+
+
+#ifndef __OGLD_BOUND_H__
+#define __OGLD_BOUND_H__
+
+
+namespace ogld
+{
+
+
+//
+// Bound
+//
+// An axis-aligned bounding box and a bounding sphere for the same
+//   geometry. Each is tight for some shapes and loose for others
+//   (compare a Sphere with a Plane), so Frustum tests both.
+//
+class Bound
+{
+public:
+    // Constructs an empty Bound.
+    Bound();
+
+    void setBox( float minX, float minY, float minZ, float maxX, float maxY, float maxZ );
+    void setSphere( float x, float y, float z, float radius );
+
+    // Sets the sphere to the one that circumscribes the box.
+    void setSphereFromBox();
+
+    bool isEmpty() const;
+
+    const float* getMin() const { return _min; }
+    const float* getMax() const { return _max; }
+    const float* getCenter() const { return _center; }
+    float getRadius() const { return _radius; }
+
+protected:
+    float _min[ 3 ], _max[ 3 ];
+    float _center[ 3 ];
+    float _radius;
+};
+
+
+}
+
+
+#endif
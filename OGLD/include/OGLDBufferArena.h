@@ -0,0 +1,181 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+// 
+
+#ifndef __OGLD_BUFFER_ARENA_H__
+#define __OGLD_BUFFER_ARENA_H__
+
+
+#if defined( WIN32 ) && !defined( __CYGWIN__ )
+  // Eliminate warning 4786:
+  //   "identifier was truncated to '255' characters in the debug information"
+  #pragma warning (disable : 4786)
+#endif
+
+#include "OGLDPlatformGL.h"
+#include <map>
+#include <set>
+#include <vector>
+
+
+namespace ogld
+{
+
+
+#ifdef GL_VERSION_1_5
+
+class BufferArena;
+class BufferPage;
+
+
+//
+// BufferBlock
+//
+// A range of a buffer object allocated from the BufferArena. Bind
+//   getBuffer() and add getOffset() to every offset into the data.
+//   BufferArena::compact() can move a block, so read both again each
+//   time the block is drawn.
+//
+class BufferBlock
+{
+    friend class BufferArena;
+
+public:
+    GLuint getBuffer() const;
+    GLintptr getOffset() const { return _offset; }
+    GLsizeiptr getSize() const { return _size; }
+
+protected:
+    BufferBlock();
+    ~BufferBlock();
+
+    BufferPage* _page;
+    GLintptr _offset;
+    GLsizeiptr _size;
+};
+
+
+//
+// BufferArena
+//
+// Stores the vertex and index data of the buffer object Shapes
+//   (Sphere, Torus, Cylinder, and Plane) in a few large buffer
+//   objects, called pages, rather than two small buffer objects per
+//   Shape. Each page holds many blocks, and a first-fit free list
+//   per page merges freed ranges with their neighbors.
+//
+// Blocks larger than the page size get a page of their own. Pages
+//   emptied by release() are kept for reuse; compact() moves blocks
+//   from the last pages into free space in the earlier ones and
+//   deletes the pages left empty. Call it after unloading part of a
+//   scene.
+//
+// All functions other than the accessors require a current OpenGL
+//   1.5 context.
+//
+class BufferArena
+{
+public:
+    static BufferArena* instance();
+
+    // Size of newly created pages in bytes. Default is 4 MB.
+    void setPageSize( GLsizeiptr size );
+    GLsizeiptr getPageSize() const;
+
+    // 'target' is GL_ARRAY_BUFFER or GL_ELEMENT_ARRAY_BUFFER. Copies
+    //   'size' bytes of 'data' into a new block. Changes the binding
+    //   of 'target'.
+    BufferBlock* allocate( GLenum target, GLsizeiptr size, const GLvoid* data );
+
+    // Returns 'block' to its page. Makes no OpenGL calls.
+    void release( BufferBlock* block );
+
+    // Defragments the pages, as described above. Changes the binding
+    //   of GL_ARRAY_BUFFER and GL_ELEMENT_ARRAY_BUFFER.
+    void compact();
+
+    // Call after the context that owned the pages is destroyed and
+    //   another context (sharing nothing with it) is made current,
+    //   along with Shape::contextLost() on every Shape, in either
+    //   order. Forgets every page without deleting it. Outstanding
+    //   blocks remain valid to release().
+    void contextLost();
+
+    int getNumPages( GLenum target ) const;
+    int getNumBlocks( GLenum target ) const;
+
+    // Bytes in blocks, and bytes in pages, of 'target'.
+    GLsizeiptr getUsedBytes( GLenum target ) const;
+    GLsizeiptr getPageBytes( GLenum target ) const;
+
+protected:
+    BufferArena();
+
+    static BufferArena* _instance;
+
+    typedef std::vector< BufferPage* > PageList;
+    PageList& getPages( GLenum target );
+    const PageList& getPages( GLenum target ) const;
+
+    // Creates a page of at least 'size' bytes.
+    BufferPage* addPage( GLenum target, GLsizeiptr size );
+
+    // Copies 'block' into 'page' at 'offset', which the caller has
+    //   already reserved.
+    void move( BufferBlock* block, BufferPage* page, GLintptr offset );
+
+    GLsizeiptr _pageSize;
+    PageList _vertexPages;
+    PageList _indexPages;
+};
+
+
+//
+// BufferPage
+//
+// One buffer object of the BufferArena, and the bookkeeping for its
+//   blocks. For use by BufferArena only.
+//
+class BufferPage
+{
+    friend class BufferArena;
+    friend class BufferBlock;
+
+protected:
+    BufferPage( GLenum target, GLsizeiptr size );
+    ~BufferPage();
+
+    // First fit. Returns false if no free range holds 'size' bytes.
+    bool reserve( GLsizeiptr size, GLintptr& offset );
+    void release( GLintptr offset, GLsizeiptr size );
+
+    GLenum _target;
+    GLuint _buffer;
+    GLsizeiptr _size;
+
+    // Free ranges, offset to size, never adjacent to each other.
+    typedef std::map< GLintptr, GLsizeiptr > FreeMap;
+    FreeMap _free;
+
+    std::set< BufferBlock* > _blocks;
+
+    // Set by BufferArena::contextLost(). The buffer object no longer
+    //   exists, and the page is deleted with its last block.
+    bool _lost;
+};
+
+#endif
+
+
+}
+
+
+#endif
@@ -0,0 +1,126 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+// 
+
+
+#ifndef __OGLD_BUILD_THREAD_H__
+#define __OGLD_BUILD_THREAD_H__
+
+
+#include "OGLDThread.h"
+#include <deque>
+#include <vector>
+
+
+namespace ogld
+{
+
+
+class Shape;
+class BuildThread;
+class BuildWorker;
+
+
+//
+// BuildJob
+//
+// Handle for work running on the BuildThread. Shape::buildAsync()
+//   returns one that tessellates the Shape; the Shape owns it, and it
+//   remains valid until the Shape is deleted. Subclasses override
+//   execute() to run other work, such as decoding an image for
+//   Texture::loadImageAsync().
+//
+class BuildJob
+{
+public:
+    // True once the worker has finished with the job.
+    bool isDone() const;
+
+    // Blocks until isDone().
+    void wait();
+
+    // Valid after isDone(): false if the work failed or was canceled.
+    bool getResult() const;
+
+protected:
+    friend class Shape;
+    friend class BuildThread;
+
+    BuildJob( Shape* shape=NULL );
+    virtual ~BuildJob();
+
+    // Runs on a worker thread and must not make OpenGL calls. By
+    //   default, tessellates the Shape.
+    virtual bool execute();
+
+    typedef enum {
+        Pending,
+        Running,
+        Done
+    } State;
+
+    Shape* _shape;
+    State _state;
+    bool _result;
+    Event _done;
+};
+
+
+//
+// BuildThread
+//
+// A pool of worker threads that runs BuildJobs, such as the CPU half
+//   of Shape::init() (tessellation, vertex cache ordering, and index
+//   packing), starting them in the order they're submitted. The jobs
+//   make no OpenGL calls. The threads start with the first job and
+//   run for the life of the program.
+//
+class BuildThread
+{
+public:
+    static BuildThread* instance();
+
+    // Number of worker threads. Call before the first submit(); the
+    //   default is getNumProcessors().
+    void setNumThreads( int numThreads );
+    int getNumThreads() const;
+
+    void submit( BuildJob* job );
+
+    // Removes 'job' from the queue if it hasn't started, or waits for
+    //   it to finish if it has.
+    void cancel( BuildJob* job );
+
+protected:
+    friend class BuildJob;
+    friend class BuildWorker;
+
+    BuildThread();
+    virtual ~BuildThread();
+
+    // Body of each worker thread.
+    void run();
+
+    static BuildThread* _instance;
+
+    std::deque< BuildJob* > _queue;
+    Mutex _mutex;
+    Event _work;
+    int _numThreads;
+    std::vector< Thread* > _workers;
+    bool _running;
+};
+
+
+}
+
+
+#endif
@@ -0,0 +1,109 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+// 
+
+
+#ifndef __OGLD_COMPACT_VERTICES_H__
+#define __OGLD_COMPACT_VERTICES_H__
+
+
+#include "OGLDPlatformGL.h"
+
+
+namespace ogld
+{
+
+
+//
+// CompactVertices
+//
+// Interleaved vertex storage for Shapes created with
+//   CompactVertexFormat. Positions are stored as three GLshorts
+//   relative to the center of the Shape's bounding box, with one
+//   uniform scale so that normals transform correctly. Normals are
+//   stored as three GLbytes, and texture coordinates as GLshorts
+//   with a per-component scale and bias. Attributes are packed with
+//   only the padding that keeps GLshorts two-byte aligned: 14 bytes
+//   per vertex with two texture coordinates, against 32 for floats.
+//   Fixed function lighting takes three-component normals, so they
+//   aren't oct-encoded.
+//
+// pushTransform() concatenates the position scale and bias onto the
+//   model-view matrix, and the texture coordinate scale and bias onto
+//   the texture matrix of each texture unit in use. It also enables
+//   GL_NORMALIZE to unit-length the quantized normals.
+//
+// Sphere passes its normals as its texture coordinates. When
+//   'texCoords' equals 'normals', the normals are stored as GLshorts
+//   (glTexCoordPointer() doesn't accept GL_BYTE), and the texture
+//   coordinate array aliases them. If every position is also its
+//   normal times one scale, as on a Sphere, the position array
+//   aliases them too, leaving 6 bytes per vertex against 24.
+//
+class CompactVertices
+{
+public:
+    CompactVertices();
+    ~CompactVertices();
+
+    bool build( int numVerts, const GLfloat* vertices, const GLfloat* normals,
+            const GLfloat* texCoords, int texComponents );
+
+    // Frees the vertex data, but retains the layout and transform
+    //   that setPointers() and pushTransform() need. Call after
+    //   copying getData() into a buffer object.
+    void releaseData();
+
+    const GLvoid* getData() const { return _data; }
+    int getSizeBytes() const { return _numVerts * _stride; }
+    GLsizei getStride() const { return _stride; }
+
+    // Enables and specifies the vertex, normal, and texture
+    //   coordinate arrays. 'base' is the address of getData() in
+    //   client memory, or bufferObjectPtr( 0 ) for a buffer object.
+    void setPointers( const GLubyte* base, int numTextures ) const;
+
+    void pushTransform( int numTextures ) const;
+    void popTransform( int numTextures ) const;
+
+    // Largest quantization error found by build(): position distance
+    //   in object units, normal angle in degrees, and texture
+    //   coordinate difference.
+    void getErrors( float& position, float& normal, float& texCoord ) const;
+
+protected:
+    GLubyte* _data;
+    int _numVerts;
+    GLsizei _stride;
+
+    GLenum _normalType;
+    unsigned int _normalOffset;
+    unsigned int _texCoordOffset;
+    int _texComponents;
+
+    GLfloat _posBias[ 3 ];
+    GLfloat _posScale;
+    GLfloat _texBias[ 3 ];
+    GLfloat _texScale[ 3 ];
+
+    float _positionError, _normalError, _texCoordError;
+
+private:
+    // Not copyable.
+    CompactVertices( const CompactVertices& );
+    CompactVertices& operator=( const CompactVertices& );
+};
+
+
+}
+
+
+#endif
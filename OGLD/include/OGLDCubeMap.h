@@ -16,6 +16,8 @@
 
 #include "OGLDPlatformGL.h"
 #include "OGLDPixels.h"
+#include "OGLDMipmap.h"
+#include "OGLDResample.h"
 #include <string>
 #include <vector>
 
@@ -56,6 +58,17 @@ public:
 
     GLuint getObject() const;
 
+    // How the mipmaps are filtered; see MipmapChain. Call before
+    //   loading. The default is BoxFilter.
+    void setMipmapFilter( MipmapFilter filter );
+    MipmapFilter getMipmapFilter() const;
+
+    // How faces that aren't a power of two are resampled, if OpenGL
+    //   needs it; see Texture::setPower2Rounding(). Call before
+    //   loading. The default is RoundUpPower2.
+    void setPower2Rounding( Power2Rounding rounding );
+    Power2Rounding getPower2Rounding() const;
+
 protected:
     CubeMap();
 
@@ -63,12 +76,18 @@ protected:
     int size() const;
     virtual void initTextureObject();
 
+    // Resamples 'pixels' to power-of-two dimensions, if OpenGL needs
+    //   them.
+    void resampleToPower2( Pixels* pixels ) const;
+
     GLuint _texId;
     bool _textureObjectAllocated;
     GLenum _unit;
 
     std::vector<ogld::Pixels*> _pixels;
     GLint _mode;
+    MipmapFilter _mipmapFilter;
+    Power2Rounding _power2Rounding;
 
     bool _valid;
 };
@@ -17,6 +17,9 @@
 #include "OGLDPlatformGL.h"
 #include "OGLDif.h"
 #include "OGLDShape.h"
+#include "OGLDIndexArray.h"
+#include "OGLDCompactVertices.h"
+#include "OGLDBufferArena.h"
 
 namespace ogld
 {
@@ -25,21 +28,39 @@ namespace ogld
 class Cylinder : public Shape
 {
 public:
-    static Cylinder* create( float radius=1.f, float length=2.f, int slices=32 );
+    static Cylinder* create( float radius=1.f, float length=2.f, int slices=32, VertexFormat format=FloatVertexFormat );
 
     virtual ~Cylinder();
 
     virtual void draw();
 
+    virtual void contextLost();
+
+
+    // Call before the first draw(). The caps are part of the
+    //   geometry shared with other Cylinders.
     void cap( bool posZ, bool negZ );
 
 protected:
     Cylinder( float radius, float length, int slices );
 
     virtual bool init();
+    virtual bool buildGeometry();
+
+    virtual bool getShareKey( std::string& key ) const;
+    virtual Shape* createMaster() const;
+
+    virtual bool saveGeometry( MeshCacheWriter& writer ) const;
+    virtual bool loadGeometry( MeshCacheEntry& entry );
+    virtual bool getTriangles( int& numVerts, const float*& vertices, const float*& normals,
+            const float*& texCoords, int& texCoordSize, const IndexArray*& indices ) const;
+
+    virtual float getLODError( int level ) const;
+    virtual Shape* createLOD( int level ) const;
 
     virtual bool buildData();
     virtual bool storeData();
+    virtual bool freeHostData();
 
     float _radius;
     float _length;
@@ -49,15 +70,14 @@ protected:
     GLfloat* _vertices;
     GLfloat* _normals;
     GLfloat* _texCoords;
-    GLushort* _indices;
-    GLushort* _cap1Start;
-    GLushort* _cap2Start;
+    IndexArray _indices;
 
-    GLuint _idxStart, _cap1Idx, _cap2Idx, _idxEnd;
+    GLuint _idxStart, _idxEnd;
 
     bool _valid;
     int _numVerts;
     int _numCapVerts;
+    int _numIndices;
 
     GLuint _dList;
     bool _dListAllocated;
@@ -110,14 +130,21 @@ public:
     virtual ~Cylinder15();
 
     virtual void draw();
+    virtual void contextLost();
 
 protected:
     Cylinder15( float radius, float length, int slices );
 
     virtual bool storeData();
 
-    static int _vertIdx, _normIdx, _texIdx, _idxIdx;
-    GLuint _vbo[4];
+    // Binds the vertex buffer object and specifies the vertex arrays.
+    void setPointers() const;
+
+    virtual bool drawInstancedElements( int count, InstanceBuffer& instances );
+
+    BufferBlock* _vertBlock;
+    BufferBlock* _idxBlock;
+    CompactVertices _compact;
 };
 
 #endif
@@ -0,0 +1,80 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+// 
+
+
+#ifndef __OGLD_FRUSTUM_H__
+#define __OGLD_FRUSTUM_H__
+
+
+#include "OGLDBound.h"
+
+
+namespace ogld
+{
+
+
+class View;
+
+
+//
+// Frustum
+//
+// The six clip planes of a view volume, for rejecting Shapes before
+//   making any OpenGL calls to draw them:
+//
+//     frustum.set( view, 50., aspect, 1., 100. );
+//     ...
+//     if (frustum.intersects( shape->getBound(), modelMatrix ))
+//         shape->draw();
+//
+// Planes are stored as separate coefficient arrays, padded to eight
+//   planes, so that compilers can vectorize the tests.
+//
+class Frustum
+{
+public:
+    Frustum();
+
+    // Planes in world coordinates for 'view' and a gluPerspective()
+    //   projection with the same parameters.
+    void set( const View& view, double fovy, double aspect, double zNear, double zFar );
+
+    // Planes from OpenGL-order projection and model-view matrices,
+    //   in the coordinate system 'modelView' transforms from.
+    void set( const double* proj, const double* modelView );
+
+    // Planes from the current OpenGL projection and model-view
+    //   matrices.
+    void setFromGL();
+
+    // False if 'bound' lies entirely outside the frustum. The first
+    //   form tests 'bound' in the frustum's coordinate system. The
+    //   second first transforms it by 'modelMatrix', an OpenGL-order
+    //   matrix from the bound's coordinates to the frustum's.
+    bool intersects( const Bound& bound ) const;
+    bool intersects( const Bound& bound, const double* modelMatrix ) const;
+
+protected:
+    enum { NUM_PLANES = 8 };
+
+    bool intersects( const float* sphereCenter, float radius,
+            const float* boxCenter, const float* boxHalfExtent ) const;
+
+    float _a[ NUM_PLANES ], _b[ NUM_PLANES ], _c[ NUM_PLANES ], _d[ NUM_PLANES ];
+    float _absA[ NUM_PLANES ], _absB[ NUM_PLANES ], _absC[ NUM_PLANES ];
+};
+
+
+}
+
+
+#endif
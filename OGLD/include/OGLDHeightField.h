@@ -0,0 +1,180 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+// 
+
+
+#ifndef __OGLD_HEIGHT_FIELD_H__
+#define __OGLD_HEIGHT_FIELD_H__
+
+
+#include "OGLDPlatformGL.h"
+#include "OGLDif.h"
+#include "OGLDShape.h"
+#include "OGLDBound.h"
+#include "OGLDIndexArray.h"
+#include <map>
+
+namespace ogld
+{
+
+
+//
+// HeightField
+//
+// A Plane with an array of z values, drawn with chunked level of
+//   detail (geomipmapping). The grid is split into square chunks of
+//   'chunkUnits' quads (a power of two). Each draw() culls chunks
+//   against the view frustum and, if setLOD() is enabled, draws each
+//   visible chunk at the coarsest level (every 2^level'th grid line)
+//   whose error projects to within the pixel budget. Edges between
+//   chunks at different levels are stitched to the coarser level, so
+//   there are no cracks. With LOD disabled, every chunk draws at full
+//   detail.
+//
+// Geometry matches Plane: the grid spans xLen by yLen centered on
+//   the origin, and zArray holds (xUnits+1)*(yUnits+1) values, with
+//   the z value of grid point (x,y) at zArray[ x*(yUnits+1) + y ].
+//   Unlike Plane, normals follow the surface slope.
+//
+class HeightField : public Shape
+{
+public:
+    static HeightField* create( float xLen, float yLen, int xUnits, int yUnits, const float* zArray, int chunkUnits=32 );
+
+    // Creates a HeightField from 16-bit samples in network byte order,
+    //   as stored in data files: see convertHeightSamples().
+    static HeightField* create( float xLen, float yLen, int xUnits, int yUnits, const GLushort* samples, int chunkUnits=32 );
+
+    virtual ~HeightField();
+
+    virtual void draw();
+
+    int getNumChunks() const;
+
+    // Statistics from the most recent draw().
+    int getChunksDrawn() const;
+    int getTrianglesDrawn() const;
+
+protected:
+    // Leaves the z values uninitialized if zArray is NULL.
+    HeightField( float xLen, float yLen, int xUnits, int yUnits, const float* zArray, int chunkUnits );
+    static HeightField* newInstance( float xLen, float yLen, int xUnits, int yUnits, const float* zArray, int chunkUnits );
+
+    // Bounds the chunks and the whole field, once the z values are set.
+    void initBounds();
+
+    virtual bool init();
+    virtual bool buildGeometry();
+
+    virtual bool getCacheKey( std::string& key ) const;
+    virtual bool saveGeometry( MeshCacheWriter& writer ) const;
+    virtual bool loadGeometry( MeshCacheEntry& entry );
+
+    virtual bool storeData();
+
+    // Picks a level for every chunk, and marks chunks outside the
+    //   view frustum.
+    void selectLevels();
+
+    // Indices for 'chunk' at its selected level, stitched to the
+    //   levels of its neighbors. Built the first time they're needed.
+    const IndexArray& getIndices( int chunk );
+
+    // Called by draw() around, and for each of, the visible chunks.
+    virtual void beginChunks();
+    virtual void setPointers( int chunk );
+    virtual void endChunks();
+
+    // Grid point of local vertex (i,j) in chunk (cx,cy), clamped to
+    //   the grid for chunks that overhang its far edges.
+    int gridX( int cx, int i ) const;
+    int gridY( int cy, int j ) const;
+    float getZ( int x, int y ) const;
+
+    // Chunks are at most 128 quads on a side, so that chunk-local
+    //   indices fit in GL_UNSIGNED_SHORT; that allows eight levels.
+    enum { MAX_CHUNK_UNITS = 128, MAX_LEVELS = 8 };
+
+    struct Chunk
+    {
+        Bound _bound;
+        float _error[ MAX_LEVELS ];
+        int _level;
+        bool _visible;
+    };
+
+    float _xLen, _yLen;
+    int _xUnits, _yUnits;
+    float* _zArray;
+
+    int _chunkUnits, _numLevels;
+    int _xChunks, _yChunks;
+    Chunk* _chunks;
+
+    // Per chunk, (_chunkUnits+1)^2 interleaved vertices: position,
+    //   normal, and texture coordinates.
+    GLfloat* _vertices;
+    int _vertsPerChunk;
+
+    typedef std::map< int, IndexArray* > IndexMap;
+    IndexMap _indexMap;
+
+    bool _valid;
+    int _chunksDrawn, _trianglesDrawn;
+
+private:
+    // Not copyable.
+    HeightField( const HeightField& );
+    HeightField& operator=( const HeightField& );
+};
+
+
+#ifdef GL_VERSION_1_5
+
+class HeightField15 : public HeightField
+{
+    friend class HeightField;
+
+public:
+    virtual ~HeightField15();
+
+protected:
+    HeightField15( float xLen, float yLen, int xUnits, int yUnits, const float* zArray, int chunkUnits );
+
+    virtual bool storeData();
+
+    virtual void beginChunks();
+    virtual void setPointers( int chunk );
+    virtual void endChunks();
+
+    GLuint _vbo;
+};
+
+#endif
+
+
+// Builds the indices of a chunk of (chunkUnits+1)^2 vertices,
+//   numbered x-major, drawn at 'level' with side 'side' (0 through 3:
+//   -y, +x, +y, -x) sampled every 2^sideLevel[side]'th grid line,
+//   where sideLevel[side] >= level and chunkUnits >= 2^sideLevel[side].
+//   Used by HeightField and TiledHeightField.
+void buildChunkIndices( IndexArray& indices, int chunkUnits, int level, const int* sideLevel );
+
+// Converts (xUnits+1)*(yUnits+1) 16-bit height samples in network
+//   byte order, stored with x varying fastest (sample (x,y) at
+//   samples[ y*(xUnits+1) + x ]), to the zArray layout that
+//   HeightField::create() takes, in one pass.
+void convertHeightSamples( float* zArray, const GLushort* samples, int xUnits, int yUnits );
+
+}
+
+
+#endif
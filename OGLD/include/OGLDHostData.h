@@ -0,0 +1,50 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+// 
+
+
+#ifndef __OGLD_HOST_DATA_H__
+#define __OGLD_HOST_DATA_H__
+
+
+namespace ogld
+{
+
+
+//
+// What Shapes and Textures do with their client memory copies of
+//   vertex, index, and pixel data once the data is stored in OpenGL.
+//
+// KeepHostData (the default) holds on to the copies for the life of
+//   the object.
+//
+// ReleaseHostData frees them as soon as they're stored in a display
+//   list, buffer object, or texture object. If the OpenGL context is
+//   lost, call contextLost() on the object; it derives the data again
+//   (by tessellating, reading the MeshCache, or reloading the image
+//   file) the next time it's drawn or applied.
+//
+typedef enum {
+    KeepHostData,
+    ReleaseHostData
+} HostDataPolicy;
+
+
+// Policy that newly constructed Shapes and Textures start with.
+//   Each object can override it with its own setHostDataPolicy().
+void setDefaultHostDataPolicy( HostDataPolicy policy );
+HostDataPolicy getDefaultHostDataPolicy();
+
+
+}
+
+
+#endif
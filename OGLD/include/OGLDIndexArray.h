@@ -0,0 +1,96 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+// 
+
+#ifndef __OGLD_INDEX_ARRAY_H__
+#define __OGLD_INDEX_ARRAY_H__
+
+
+#include "OGLDPlatformGL.h"
+
+
+namespace ogld
+{
+
+
+//
+// IndexArray
+//
+// Storage for the vertex indices of a Shape. Shapes create their
+//   indices as 32-bit values, then call pack() to store them in the
+//   smallest type able to address every vertex: GL_UNSIGNED_BYTE for
+//   up to 256 vertices, GL_UNSIGNED_SHORT for up to 65536 vertices,
+//   and GL_UNSIGNED_INT otherwise. Pass getType() as the type
+//   parameter to glDrawElements() and friends.
+//
+class IndexArray
+{
+public:
+    IndexArray();
+    ~IndexArray();
+
+    // Discards any current contents and returns storage for 'count'
+    //   GL_UNSIGNED_INT indices for the caller to fill.
+    GLuint* allocate( int count );
+
+    // Stores the indices in the smallest type that can address
+    //   'numVerts' vertices.
+    void pack( int numVerts );
+
+    // Replaces the contents with a copy of 'count' indices of 'type',
+    //   for example indices already packed.
+    void assign( const GLvoid* data, int count, GLenum type );
+
+    void clear();
+    void swap( IndexArray& rhs );
+
+    // Frees the index data, but keeps getType() and getCount(), which
+    //   draw calls still need once the indices are in a buffer object
+    //   or display list.
+    void releaseData();
+
+    GLenum getType() const { return _type; }
+    int getCount() const { return _count; }
+    int getTypeSize() const;
+    int getSizeBytes() const;
+
+    // Index data in its current type, suitable for glBufferData().
+    const GLvoid* getData() const { return _data; }
+
+    // Access to the 32-bit indices. Valid only while getType() is
+    //   GL_UNSIGNED_INT, for example between allocate() and pack().
+    GLuint* getUIntData();
+    const GLuint* getUIntData() const;
+
+    // Returns index 'idx' regardless of the current type.
+    GLuint get( int idx ) const;
+
+    // Location of index 'idx' in client memory, and in a buffer
+    //   object that holds a copy of getData().
+    const GLvoid* address( int idx ) const;
+    GLvoid* offset( int idx ) const;
+
+protected:
+    GLubyte* _data;
+    GLenum _type;
+    int _count;
+
+private:
+    // Not copyable.
+    IndexArray( const IndexArray& );
+    IndexArray& operator=( const IndexArray& );
+};
+
+
+}
+
+
+#endif
@@ -0,0 +1,110 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+//
+
+#ifndef __OGLD_INSTANCE_BUFFER_H__
+#define __OGLD_INSTANCE_BUFFER_H__
+
+
+#include "OGLDPlatformGL.h"
+#include "OGLDif.h"
+#include <vector>
+#include <map>
+
+namespace ogld
+{
+
+
+//
+// InstanceBuffer
+//
+// Per-instance data for Shape::drawInstanced(): a modeling matrix,
+//   sixteen floats in the order glMultMatrixf() takes them, and an
+//   RGBA color used in place of glColor(). When the OpenGL
+//   implementation supports instancing, the data is copied to a
+//   buffer object the next time it's drawn after a change, and
+//   drawn with a vertex shader that applies the matrix and color
+//   and evaluates fixed-function lighting. Like the fixed-function
+//   pipeline, the shader is specialized to the lighting state: each
+//   combination of enabled lights and light types gets its own
+//   program, built the first time it's drawn.
+//
+// The shader lights the front material only, with
+//   GL_COLOR_MATERIAL in its default GL_AMBIENT_AND_DIFFUSE mode, and
+//   always renormalizes normals. It passes texture coordinates for
+//   units 0 and 1 through their texture matrices; texture coordinate
+//   generation and separate specular color aren't emulated.
+//
+class InstanceBuffer
+{
+public:
+    InstanceBuffer();
+    ~InstanceBuffer();
+
+    enum { MATRIX_FLOATS = 16, COLOR_FLOATS = 4,
+        INSTANCE_FLOATS = MATRIX_FLOATS + COLOR_FLOATS };
+
+    // New instances get an identity matrix and opaque white.
+    void resize( int count );
+    int getCount() const;
+
+    void set( int idx, const GLfloat* matrix, const GLfloat* color );
+    void setMatrix( int idx, const GLfloat* matrix );
+    void setColor( int idx, const GLfloat* color );
+
+    const GLfloat* getMatrix( int idx ) const;
+    const GLfloat* getColor( int idx ) const;
+
+    // Called by Shapes that draw all instances with one call. bind()
+    //   uploads changed data, installs the shader for the current
+    //   lighting state, and sets up the instanced vertex attributes. It returns false if instancing is
+    //   unavailable or the shader failed to build; the Shape then
+    //   draws the instances one at a time.
+    bool bind();
+    void unbind();
+
+protected:
+    struct Program
+    {
+        GLuint _program;
+        GLint _matrixLoc, _colorLoc;
+    };
+
+    // Encodes the lighting state that the shader depends on.
+    static unsigned int getStateKey();
+
+    // Returns the program for 'key', building it the first time it's
+    //   requested. Its _program is 0 if it failed to build.
+    static const Program& getProgram( unsigned int key );
+
+    static std::map< unsigned int, Program > _programs;
+
+    // Program bound by bind(), and the one it replaced.
+    const Program* _bound;
+    GLint _prevProgram;
+
+    std::vector< GLfloat > _data;
+
+    GLuint _vbo;
+    bool _vboAllocated;
+    bool _dirty;
+
+private:
+    // Not copyable.
+    InstanceBuffer( const InstanceBuffer& );
+    InstanceBuffer& operator=( const InstanceBuffer& );
+};
+
+
+}
+
+
+#endif
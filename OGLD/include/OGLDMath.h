@@ -43,6 +43,12 @@ unsigned short ceilPower2( unsigned short x );
 
 void matrixTranspose( double m[16] );
 
+// Returns n+1 interleaved (cosine, sine) pairs for the angles
+//   2*PI*i/n, i=0..n. The last pair is exactly (1, 0), so a ring
+//   closes without a seam. Tables are computed once per n and shared;
+//   the pointer remains valid for the life of the program.
+const float* sinCosTable( int n );
+
 
 
 //
@@ -0,0 +1,176 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+// 
+
+
+#ifndef __OGLD_MESH_CACHE_H__
+#define __OGLD_MESH_CACHE_H__
+
+
+#include "OGLDPlatformGL.h"
+#include "OGLDThread.h"
+#include <string>
+#include <vector>
+
+
+namespace ogld
+{
+
+
+class IndexArray;
+
+
+//
+// MeshCacheWriter
+//
+// Collects the arrays a Shape's buildGeometry() produced, for
+//   MeshCache::store(). Copies int values, but by default stores only
+//   pointers to float and index arrays, which must then remain valid
+//   until store() returns.
+//
+class MeshCacheWriter
+{
+public:
+    MeshCacheWriter();
+
+    void addInts( const int* values, int count );
+    void addFloats( const GLfloat* data, int count, bool copy=false );
+    void addIndices( const IndexArray& indices );
+
+protected:
+    friend class MeshCache;
+
+    struct Stream
+    {
+        GLenum _type;
+        int _count;
+        const GLvoid* _data;
+        std::vector< GLubyte > _copy;
+    };
+    std::vector< Stream > _streams;
+};
+
+
+//
+// MeshCacheEntry
+//
+// A cache file mapped into memory by MeshCache::load(). Read the
+//   streams back in the order they were added to the
+//   MeshCacheWriter. Each get function checks the type and count of
+//   the next stream, and fails if they don't match; that means the
+//   entry is stale.
+//
+class MeshCacheEntry
+{
+public:
+    ~MeshCacheEntry();
+
+    bool getInts( int* values, int count );
+
+    // Returns the address of the stream within the mapped file, or
+    //   NULL. Valid until the MeshCacheEntry is deleted.
+    const GLfloat* getFloats( int count );
+
+    // Copies the next stream into 'indices' in its packed type.
+    bool getIndices( IndexArray& indices );
+
+protected:
+    friend class MeshCache;
+
+    MeshCacheEntry( const GLubyte* data, size_t size );
+
+    // Locates the next stream, checking its type and, if 'count' is
+    //   not negative, its count.
+    const GLubyte* next( GLenum type, int count, int& actualCount );
+
+    const GLubyte* _data;
+    size_t _size;
+    int _numStreams, _stream;
+    const GLubyte* _table;
+
+private:
+    // Not copyable.
+    MeshCacheEntry( const MeshCacheEntry& );
+    MeshCacheEntry& operator=( const MeshCacheEntry& );
+};
+
+
+//
+// MeshCache
+//
+// Disk cache of tessellated Shape geometry, so that a process start
+//   maps a file instead of running buildGeometry() again. Disabled
+//   until setDirectory() names a directory for the cache files; call
+//   it before creating any Shapes.
+//
+// Each entry is one file, named for a hash of its key. Keys identify
+//   the Shape type and every parameter that affects the geometry;
+//   Shapes built from height arrays include a hash of the array. The
+//   file also records the key, the cache format version, and the
+//   host byte order, and load() discards an entry, so the Shape
+//   rebuilds and stores it again, if any of them differ or the file
+//   is truncated. Bump FORMAT_VERSION in OGLDMeshCache.cpp whenever a
+//   Shape's tessellation changes.
+//
+class MeshCache
+{
+public:
+    static MeshCache* instance();
+
+    // An empty string disables the cache. A trailing separator is
+    //   added if missing.
+    void setDirectory( const std::string& directory );
+    const std::string& getDirectory() const;
+    bool getEnabled() const;
+
+    // Returns the entry for 'key', or NULL if there is none or it is
+    //   stale. Delete the entry when done with it.
+    MeshCacheEntry* load( const std::string& key );
+
+    // Writes an entry for 'key', replacing any existing one.
+    bool store( const std::string& key, const MeshCacheWriter& writer );
+
+    // Discards the stale entry for 'key'. load() calls this for
+    //   entries with a bad header; Shapes call it for entries whose
+    //   streams don't match.
+    void discard( const std::string& key );
+
+    // Counts of load() calls that found an entry and that found none,
+    //   of stale entries discarded, and of entries stored.
+    void getStatistics( int& hits, int& misses, int& stale, int& stores );
+
+    // Hash of 'size' bytes, as 16 hex digits, for keys that depend on
+    //   array contents.
+    static std::string hash( const void* data, size_t size );
+
+protected:
+    MeshCache();
+
+    static MeshCache* _instance;
+
+    std::string getFileName( const std::string& key ) const;
+
+    std::string _directory;
+
+    // Shapes build on the BuildThread too.
+    Mutex _mutex;
+    int _hits, _misses, _stale, _stores;
+
+    // Numbers store()'s temporary files, so that writers in this
+    //   process don't share one.
+    unsigned int _tempCount;
+};
+
+
+}
+
+
+#endif
@@ -0,0 +1,107 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+//
+
+
+#ifndef __OGLD_MIPMAP_H__
+#define __OGLD_MIPMAP_H__
+
+
+#include "OGLDPlatformGL.h"
+#include <vector>
+
+
+namespace ogld
+{
+
+
+// How each mipmap level is filtered from the one above it.
+//   BoxFilter averages 2x2 texels, like gluBuild2DMipmaps().
+//   TentFilter weights 4x4 texels 1-3-3-1 in each direction, which
+//   blurs slightly more but aliases less on high-frequency images.
+typedef enum {
+    BoxFilter, TentFilter
+} MipmapFilter;
+
+
+// Components per pixel of 'format', or 0 if MipmapChain and
+//   resampleImage() don't handle it.
+int imageComponents( GLenum format );
+
+
+//
+// MipmapChain
+//
+// Builds the mipmap levels below an 8-bit image of one to four
+//   components (GL_RGBA, GL_RGB, GL_LUMINANCE, and so on) on the CPU,
+//   splitting each level's rows across threads (see parallelFor()).
+//   Each level halves the dimensions of the one above, rounding down,
+//   so the image needn't be a power of two. build() makes no OpenGL
+//   calls.
+//
+class MipmapChain
+{
+public:
+    MipmapChain();
+    ~MipmapChain();
+
+    // True if build() handles images of 'format' and 'type'.
+    static bool isSupported( GLenum format, GLenum type );
+
+    // Builds levels 1 and below of the tightly packed 'width' x
+    //   'height' image 'pixels'. Returns false, with no levels, if
+    //   isSupported() is false.
+    bool build( const GLvoid* pixels, GLsizei width, GLsizei height,
+            GLenum format, GLenum type, MipmapFilter filter=BoxFilter );
+
+    // Number of levels built, not counting level 0.
+    int getNumLevels() const;
+
+    // Level 1 is the first built level.
+    void getLevelSize( int level, GLsizei& width, GLsizei& height ) const;
+    const GLubyte* getLevel( int level ) const;
+
+    // All built levels, level 1 first, tightly packed.
+    const GLubyte* getData() const;
+    unsigned int getDataSize() const;
+
+    // Stores the built levels in 'target' with glTexImage2D(). 'data'
+    //   overrides getData(), for example with an offset into a bound
+    //   pixel unpack buffer holding a copy of it.
+    void texImage( GLenum target, GLint internalFormat, const GLvoid* data=NULL ) const;
+
+protected:
+    GLenum _format;
+    GLenum _type;
+    std::vector< GLubyte > _data;
+
+    struct Level
+    {
+        GLsizei _width;
+        GLsizei _height;
+        unsigned int _offset;
+    };
+    std::vector< Level > _levels;
+};
+
+
+// Drop-in replacement for gluBuild2DMipmaps() that uses MipmapChain
+//   when it supports 'format' and 'type', storing every level with
+//   glTexImage2D(). Unlike gluBuild2DMipmaps(), it doesn't resample
+//   images that aren't a power of two.
+void buildMipmaps( GLenum target, GLint internalFormat, GLsizei width, GLsizei height,
+        GLenum format, GLenum type, const GLvoid* pixels, MipmapFilter filter=BoxFilter );
+
+
+}
+
+
+#endif
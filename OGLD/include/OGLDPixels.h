@@ -22,6 +22,7 @@ namespace ogld
 {
 
 class CubeMap;
+class TextureLoadJob;
 
 
 class Pixels
@@ -37,6 +38,8 @@ class Pixels
 #ifdef GL_VERSION_2_0
     friend class CubeMap20;
 #endif
+    // Allow Texture::loadImageAsync() to decode on a worker thread.
+    friend class TextureLoadJob;
 
 public:
     typedef enum {
@@ -70,6 +73,16 @@ protected:
     virtual bool init();
     int size() const;
 
+    // The second half of loadImage(): decodes the file at 'fullPath',
+    //   as returned by OGLDif::findDataFile(), into _pixels. Touches
+    //   neither OGLDif nor OpenGL, so it's safe on a worker thread.
+    //   Returns false if 'fullPath' is empty. Doesn't unload() first.
+    bool readImage( const std::string& fullPath );
+
+    // Resamples the image to 'width' x 'height' with scaleImage(),
+    //   which makes no OpenGL calls if isResampleSupported() is true.
+    void resample( GLsizei width, GLsizei height );
+
     unsigned char* _pixels;
     GLsizei _width;
     GLsizei _height;
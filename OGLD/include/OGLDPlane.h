@@ -17,6 +17,9 @@
 #include "OGLDPlatformGL.h"
 #include "OGLDif.h"
 #include "OGLDShape.h"
+#include "OGLDIndexArray.h"
+#include "OGLDCompactVertices.h"
+#include "OGLDBufferArena.h"
 
 namespace ogld
 {
@@ -25,23 +28,37 @@ namespace ogld
 class Plane : public Shape
 {
 public:
-    static Plane* create( float xLen=1.f, float yLen=1.f, int xUnits=1, int yUnits=1, float z=0.f );
-    static Plane* create( float xLen, float yLen, int xUnits, int yUnits, float* zArray );
+    static Plane* create( float xLen=1.f, float yLen=1.f, int xUnits=1, int yUnits=1, float z=0.f, VertexFormat format=FloatVertexFormat );
+    static Plane* create( float xLen, float yLen, int xUnits, int yUnits, float* zArray, VertexFormat format=FloatVertexFormat );
 
     virtual ~Plane();
 
     virtual void draw();
 
+    virtual void contextLost();
+
 protected:
     Plane( float xLen, float yLen, int xUnits, int yUnits, float z );
     Plane( float xLen, float yLen, int xUnits, int yUnits, float* zArray );
 
     virtual bool init();
+    virtual bool buildGeometry();
+
+    virtual bool getShareKey( std::string& key ) const;
+    virtual Shape* createMaster() const;
+
+    virtual bool getCacheKey( std::string& key ) const;
+    virtual bool saveGeometry( MeshCacheWriter& writer ) const;
+    virtual bool loadGeometry( MeshCacheEntry& entry );
+    virtual bool getTriangles( int& numVerts, const float*& vertices, const float*& normals,
+            const float*& texCoords, int& texCoordSize, const IndexArray*& indices ) const;
 
     virtual bool buildData();
     virtual bool storeData();
+    virtual bool freeHostData();
 
-    virtual GLushort* indexAddress( int count );
+    // Sets _bound from the plane extents and the z range.
+    void setBound( float minZ, float maxZ );
 
     float _xLen, _yLen;
     int _xUnits, _yUnits;
@@ -51,9 +68,7 @@ protected:
     GLfloat* _vertices;
     GLfloat* _normals;
     GLfloat* _texCoords;
-    GLushort* _indices;
-    GLushort** _idxAddrs;
-    GLsizei* _idxCounts;
+    IndexArray _indices;
 
     bool _valid;
     int _numVerts, _numIndices;
@@ -82,25 +97,6 @@ protected:
 #endif
 
 
-#ifdef GL_VERSION_1_4
-
-class Plane14 : public Plane
-{
-    friend class Plane;
-
-public:
-    virtual ~Plane14();
-
-protected:
-    Plane14( float xLen, float yLen, int xUnits, int yUnits, float z );
-    Plane14( float xLen, float yLen, int xUnits, int yUnits, float* zArray );
-
-    virtual bool storeData();
-};
-
-#endif
-
-
 #ifdef GL_VERSION_1_5
 
 class Plane15 : public Plane
@@ -111,6 +107,7 @@ public:
     virtual ~Plane15();
 
     virtual void draw();
+    virtual void contextLost();
 
 protected:
     Plane15( float xLen, float yLen, int xUnits, int yUnits, float z );
@@ -118,10 +115,9 @@ protected:
 
     virtual bool storeData();
 
-    virtual GLushort* indexAddress( int count );
-
-    static int _vertIdx, _normIdx, _texIdx, _idxIdx;
-    GLuint _vbo[4];
+    BufferBlock* _vertBlock;
+    BufferBlock* _idxBlock;
+    CompactVertices _compact;
 };
 
 #endif
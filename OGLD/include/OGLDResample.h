@@ -0,0 +1,64 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+//
+
+
+#ifndef __OGLD_RESAMPLE_H__
+#define __OGLD_RESAMPLE_H__
+
+
+#include "OGLDPlatformGL.h"
+
+
+namespace ogld
+{
+
+
+// Which way roundToPower2() rounds a dimension that isn't a power of
+//   two. RoundUpPower2 keeps all the image's detail, but can take up to
+//   four times the memory. RoundDownPower2 takes less than the
+//   original image.
+typedef enum {
+    RoundUpPower2, RoundDownPower2
+} Power2Rounding;
+
+
+// Rounds 'width' and 'height' to powers of two. Dimensions that
+//   already are powers of two are unchanged.
+void roundToPower2( GLsizei& width, GLsizei& height, Power2Rounding rounding );
+
+
+// True if resampleImage() handles images of 'format' and 'type': the
+//   same 8-bit images as MipmapChain.
+bool isResampleSupported( GLenum format, GLenum type );
+
+// Resamples the tightly packed 'srcWidth' x 'srcHeight' image 'src'
+//   into 'dst', splitting the rows across threads (see parallelFor()).
+//   The filter is separable: shrinking averages the source texels each
+//   destination texel covers, and enlarging interpolates linearly.
+//   Makes no OpenGL calls. Returns false, leaving 'dst' untouched, if
+//   isResampleSupported() is false.
+bool resampleImage( const GLvoid* src, GLsizei srcWidth, GLsizei srcHeight,
+        GLenum format, GLenum type, GLvoid* dst, GLsizei dstWidth, GLsizei dstHeight );
+
+
+// Drop-in replacement for gluScaleImage() that uses resampleImage()
+//   when it handles 'format' and the types. Stores tightly packed
+//   rows whatever the pixel store state.
+void scaleImage( GLenum format, GLsizei widthIn, GLsizei heightIn, GLenum typeIn,
+        const GLvoid* dataIn, GLsizei widthOut, GLsizei heightOut,
+        GLenum typeOut, GLvoid* dataOut );
+
+
+}
+
+
+#endif
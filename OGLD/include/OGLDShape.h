@@ -14,10 +14,35 @@
 #define __OGLD_SHAPE_H__
 
 
+#include "OGLDPlatformGL.h"
+#include "OGLDBound.h"
+#include "OGLDHostData.h"
+#include <string>
+
 namespace ogld
 {
 
 
+class BuildJob;
+class MeshCacheWriter;
+class MeshCacheEntry;
+class IndexArray;
+class InstanceBuffer;
+
+
+//
+// Vertex storage for a Shape, chosen at create() time.
+//   CompactVertexFormat quantizes positions to 16 bits, normals to
+//   8 bits, and texture coordinates to 16 bits. It is used with
+//   buffer objects (OpenGL 1.5 and later); earlier versions store
+//   vertices in display lists and always use FloatVertexFormat.
+//
+typedef enum {
+    FloatVertexFormat,
+    CompactVertexFormat
+} VertexFormat;
+
+
 class Shape
 {
 public:
@@ -26,11 +51,215 @@ public:
 
     virtual void draw() = 0;
 
+    // Draws the first 'count' instances in 'instances', each
+    //   transformed by its matrix and colored by its color. Sphere,
+    //   Torus, and Cylinder in FloatVertexFormat draw them all with
+    //   one glDrawElementsInstanced() when OGLDif reports instancing
+    //   support. Otherwise, and when LOD is enabled, each instance is
+    //   drawn in turn with glMultMatrixf(), glColor4fv(), and draw().
+    void drawInstanced( int count, InstanceBuffer& instances );
+
     void setTextures( int numTextures );
     int getTextures() const;
 
+    // By default, Shapes created with identical parameters share a
+    //   single copy of their geometry through the ShapeCache. Call
+    //   setShared( false ) before the first draw() to give a Shape
+    //   its own private copy.
+    void setShared( bool shared );
+    bool getShared() const;
+
+    VertexFormat getVertexFormat() const;
+
+    // Largest error that CompactVertexFormat quantization introduced
+    //   relative to FloatVertexFormat: position in object units,
+    //   normal direction in degrees, and texture coordinates. All
+    //   zero for FloatVertexFormat, or before the first draw().
+    void getVertexFormatError( float& position, float& normal, float& texCoord ) const;
+
+    // Level of detail. When enabled, draw() picks the coarsest level
+    //   whose deviation from the true surface projects to at most
+    //   'pixelError' pixels, given the current model-view and
+    //   projection matrices and viewport. Coarser levels are created
+    //   the first time they're drawn. Shapes without LOD support
+    //   (Plane) always draw at full detail.
+    void setLOD( bool enable, float pixelError=1.f );
+    bool getLOD() const;
+    float getLODPixelError() const;
+
+    // Level chosen by the most recent draw(). 0 is full detail.
+    int getLODLevel() const;
+
+    // The OpenGL-order projection matrix and viewport that every
+    //   Shape selects levels with. By default each LOD draw() reads
+    //   them back from OpenGL, which stalls the pipeline; call this
+    //   once per frame, or whenever they change, to avoid that. NULL
+    //   reverts to reading them back.
+    static void setLODView( const double* proj, const GLint* viewport );
+
+    // Model-view matrix for the next draw()'s level selection, in
+    //   OpenGL order, if the caller already has it. Otherwise draw()
+    //   reads it back from OpenGL.
+    void setLODModelView( const double* modelView );
+
+    // Bounding box and sphere of the Shape in its own coordinates,
+    //   available from construction on, before any tessellation.
+    //   Pass to Frustum::intersects() to cull the Shape.
+    const Bound& getBound() const;
+
+    // Radius of a sphere centered on the origin that encloses the
+    //   Shape.
+    float getBoundingRadius() const;
+
+    // Tessellates the Shape on a BuildThread worker instead of in
+    //   the first draw(). draw() draws nothing until the worker
+    //   finishes; the next draw() then stores the data in OpenGL.
+    //   Call from the OpenGL thread, before the first draw(). Shared
+    //   Shapes return the job of their master.
+    BuildJob* buildAsync();
+
+    // What happens to the client memory copies of the vertex and
+    //   index data once they're stored in OpenGL; see HostDataPolicy.
+    //   Call before the first draw(). Sphere, Torus, Cylinder, and
+    //   Plane free their copies under ReleaseHostData; other Shapes
+    //   always keep them. Shared Shapes get the policy of the Shape
+    //   that created their master.
+    void setHostDataPolicy( HostDataPolicy policy );
+    HostDataPolicy getHostDataPolicy() const;
+
+    // Call after the context that stored this Shape's data is
+    //   destroyed and another context (sharing nothing with it) is
+    //   made current. Forgets the display list or buffer objects
+    //   without deleting them; the next draw() stores the data
+    //   again, tessellating it again first if it was released.
+    //   Sphere, Torus, Cylinder, and Plane support this. Also call
+    //   BufferArena::contextLost(), which owns their buffer objects.
+    virtual void contextLost();
+
 protected:
+    friend class ShapeCache;
+    friend class BuildJob;
+    friend class StaticBatch;
+
+    // Called by init(). If sharing is enabled and the derived class
+    //   supports it, looks up (or creates) the shared master for this
+    //   Shape and returns true. draw() then forwards to _master.
+    bool acquireMaster();
+
+    // Derived classes that support sharing override these. The key
+    //   must identify every parameter that affects the geometry or
+    //   the way it is drawn. createMaster() returns a new, unshared
+    //   Shape with the same parameters as this one.
+    virtual bool getShareKey( std::string& key ) const;
+    virtual Shape* createMaster() const;
+
+    // The half of init() that makes no OpenGL calls: buildData(),
+    //   vertex cache ordering, and index packing. Runs on the
+    //   BuildThread after buildAsync().
+    virtual bool buildGeometry();
+
+    // Called by init(). Runs buildGeometry() now, unless buildAsync()
+    //   started it; then returns false until the worker finishes.
+    bool finishBuild();
+
+    // buildGeometry(), through the MeshCache when it's enabled.
+    //   finishBuild() and BuildJob::execute() call this.
+    bool buildCachedGeometry();
+
+    // Derived classes that support the MeshCache override these.
+    //   getCacheKey() defaults to getShareKey(). saveGeometry() adds
+    //   the arrays that buildGeometry() made to 'writer'.
+    //   loadGeometry() reads them back in place of buildGeometry();
+    //   if they don't match, it returns false with nothing allocated.
+    //   Float arrays may point straight into the entry, which the
+    //   Shape then keeps mapped in _cacheEntry; free them with
+    //   freeHostArray().
+    virtual bool getCacheKey( std::string& key ) const;
+    virtual bool saveGeometry( MeshCacheWriter& writer ) const;
+    virtual bool loadGeometry( MeshCacheEntry& entry );
+
+    // Frees an array from buildGeometry() or loadGeometry(), and sets
+    //   'data' to NULL. Arrays within _cacheEntry aren't freed; the
+    //   mapping goes once freeHostData() or the destructor is done.
+    void freeHostArray( GLfloat*& data );
+
+    // Derived classes that StaticBatch can merge override this. Valid
+    //   after buildGeometry(): returns the vertex arrays and triangle
+    //   indices it made. 'texCoordSize' is the number of texture
+    //   coordinates per vertex.
+    virtual bool getTriangles( int& numVerts, const float*& vertices, const float*& normals,
+            const float*& texCoords, int& texCoordSize, const IndexArray*& indices ) const;
+
+    // Derived classes that store their geometry in buffer objects
+    //   override this to draw 'count' instances with a single call.
+    //   Returns false if the instances must be drawn one at a time.
+    virtual bool drawInstancedElements( int count, InstanceBuffer& instances );
+
+    // Waits for, or dequeues, a buildAsync() job. Every concrete
+    //   class calls this first in its destructor, so that the worker
+    //   never sees a partly destroyed Shape.
+    void cancelBuild();
+
+    // Called by init() after storeData(). Under ReleaseHostData,
+    //   calls freeHostData() and records whether it freed anything.
+    void releaseHostData();
+
+    // Derived classes that can derive their data again override this
+    //   to free the arrays that storeData() no longer needs, and
+    //   return true.
+    virtual bool freeHostData();
+
+    // Called at the top of draw(). If LOD is enabled and a coarser
+    //   level suffices, draws that level and returns true.
+    bool drawLOD();
+
+    // Derived classes that support LOD override these. Level 0 is
+    //   this Shape. getLODError() returns the largest distance, in
+    //   object units, between a level's surface and the true surface,
+    //   or a negative value if there is no such level. createLOD()
+    //   returns a new Shape for levels 1 through MAX_LODS-1.
+    virtual float getLODError( int level ) const;
+    virtual Shape* createLOD( int level ) const;
+
+    // The matrices and viewport to select levels with: those passed
+    //   to setLODView() and setLODModelView(), or else the current
+    //   OpenGL state. Uses up the setLODModelView() matrix.
+    void getLODView( double* modelView, double* proj, GLint* viewport );
+
+    enum { MAX_LODS = 4 };
+
     int _numTextures;
+
+    // Derived class constructors set the bound.
+    Bound _bound;
+
+    VertexFormat _vertexFormat;
+    float _positionError, _normalError, _texCoordError;
+
+    bool _shared;
+    Shape* _master;
+    std::string _shareKey;
+
+    BuildJob* _buildJob;
+
+    // The MeshCache entry loadGeometry() read, or NULL.
+    MeshCacheEntry* _cacheEntry;
+
+    HostDataPolicy _hostDataPolicy;
+    bool _hostDataReleased;
+
+    bool _lodEnable;
+    float _lodPixelError;
+    int _lodLevel;
+    Shape* _lods[ MAX_LODS ];
+
+    bool _lodModelViewSet;
+    double _lodModelView[ 16 ];
+
+    static bool _lodProjSet;
+    static double _lodProj[ 16 ];
+    static bool _lodViewportSet;
+    static GLint _lodViewport[ 4 ];
 };
 
 
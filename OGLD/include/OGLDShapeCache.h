@@ -0,0 +1,79 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+// 
+
+
+#ifndef __OGLD_SHAPE_CACHE_H__
+#define __OGLD_SHAPE_CACHE_H__
+
+
+#if defined( WIN32 ) && !defined( __CYGWIN__ )
+  // Eliminate warning 4786:
+  //   "identifier was truncated to '255' characters in the debug information"
+  #pragma warning (disable : 4786)
+#endif
+
+#include <map>
+#include <string>
+
+
+namespace ogld
+{
+
+
+class Shape;
+
+
+//
+// ShapeCache
+//
+// Shares tessellated geometry between Shapes created with identical
+//   parameters. Each distinct geometry is a private "master" Shape,
+//   owned by the cache and reference counted by the Shapes that draw
+//   it. The master, and its display list or buffer objects, is
+//   deleted when the last Shape referencing it is deleted.
+//
+class ShapeCache
+{
+public:
+    static ShapeCache* instance();
+
+    // Returns the master Shape for 'key' and adds a reference to it.
+    //   On first use of 'key', the master is created with
+    //   proto->createMaster().
+    Shape* acquire( const std::string& key, const Shape* proto );
+
+    // Removes a reference to the master for 'key', deleting it when
+    //   no references remain. Requires a current OpenGL context.
+    void release( const std::string& key );
+
+    // Number of distinct geometries currently shared.
+    int getSize() const;
+
+protected:
+    ShapeCache();
+
+    static ShapeCache* _instance;
+
+    struct Entry
+    {
+        Shape* _master;
+        int _refCount;
+    };
+    typedef std::map< std::string, Entry > EntryMap;
+    EntryMap _entries;
+};
+
+
+}
+
+
+#endif
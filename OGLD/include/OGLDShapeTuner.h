@@ -0,0 +1,118 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+//
+
+#ifndef __OGLD_SHAPE_TUNER_H__
+#define __OGLD_SHAPE_TUNER_H__
+
+
+#if defined( WIN32 ) && !defined( __CYGWIN__ )
+  // Eliminate warning 4786:
+  //   "identifier was truncated to '255' characters in the debug information"
+  #pragma warning (disable : 4786)
+#endif
+
+#include "OGLDif.h"
+#include <map>
+#include <string>
+
+
+namespace ogld
+{
+
+
+//
+// ShapeTuner
+//
+// Chooses the storage path that the Shape factories create. By
+//   default they switch on OGLDif::getVersion(), so OpenGL 1.5 and
+//   later always get buffer objects, even on drivers where display
+//   lists are faster (or where buffer objects render incorrectly;
+//   see Issue000 in issues.txt).
+//
+// calibrate() times a representative Shape with each path on the
+//   current context and records the fastest for the current
+//   renderer, identified by its GL_RENDERER and GL_VERSION strings.
+//   Sphere, Torus, Cylinder, Plane, HeightField, and StaticBatch
+//   create() then switch on getShapeVersion() instead. Results
+//   persist in the file named by setFileName(), one line per
+//   renderer, so only the first run on a given renderer pays for the
+//   timing.
+//
+// The candidates are the display list path (Ver13, which supports
+//   the same multitexturing as the buffer object path) and the
+//   buffer object path (Ver15). Contexts older than OpenGL 1.5 have
+//   only one path, and calibrate() doesn't time anything.
+//
+class ShapeTuner
+{
+public:
+    static ShapeTuner* instance();
+
+    // File that stores results for every renderer. Call before
+    //   getShapeVersion() or calibrate(). Empty (the default) keeps
+    //   results in memory only.
+    void setFileName( const std::string& fileName );
+    const std::string& getFileName() const;
+
+    // Times each path, unless a result for the current renderer is
+    //   already recorded and 'force' is false, and returns the
+    //   chosen version. Requires a current OpenGL context; call it
+    //   before creating any Shapes. Draws into a 1x1 viewport of the
+    //   current draw buffer and restores all state it changes, but
+    //   leaves that pixel undefined, so clear before rendering.
+    OpenGLVersion calibrate( bool force=false );
+
+    // Records 'version' for the current renderer without timing, for
+    //   example to work around a driver bug.
+    void setShapeVersion( OpenGLVersion version );
+
+    // Version that the Shape factories switch on: the recorded
+    //   result for the current renderer, if any and not newer than
+    //   OGLDif::getVersion(), or else OGLDif::getVersion().
+    OpenGLVersion getShapeVersion();
+
+    // Milliseconds per draw that the last calibrate() measured for
+    //   'version', or a negative value if it didn't time it.
+    double getTime( OpenGLVersion version ) const;
+
+protected:
+    ShapeTuner();
+
+    static ShapeTuner* _instance;
+
+    // Key for the current renderer. Empty if there's no context.
+    static std::string getRendererKey();
+
+    // Times 'version' by creating and drawing Shapes with
+    //   getShapeVersion() forced to it.
+    double timePath( OpenGLVersion version );
+
+    void load();
+    bool save() const;
+
+    std::string _fileName;
+    bool _loaded;
+
+    typedef std::map< std::string, OpenGLVersion > ResultMap;
+    ResultMap _results;
+
+    // While calibrate() times a path, getShapeVersion() returns it.
+    OpenGLVersion _override;
+
+    double _times[ VerExtended+1 ];
+};
+
+
+}
+
+
+#endif
@@ -17,6 +17,9 @@
 #include "OGLDPlatformGL.h"
 #include "OGLDif.h"
 #include "OGLDShape.h"
+#include "OGLDIndexArray.h"
+#include "OGLDCompactVertices.h"
+#include "OGLDBufferArena.h"
 
 namespace ogld
 {
@@ -25,29 +28,38 @@ namespace ogld
 class Sphere : public Shape
 {
 public:
-    static Sphere* create( float radius=1.f, int subdivisions=2 );
+    static Sphere* create( float radius=1.f, int subdivisions=2, VertexFormat format=FloatVertexFormat );
 
     virtual ~Sphere();
 
     virtual void draw();
 
+    virtual void contextLost();
+
+
 protected:
     Sphere( float radius, int subdivisions );
 
     bool init();
+    virtual bool buildGeometry();
+
+    virtual bool getShareKey( std::string& key ) const;
+    virtual Shape* createMaster() const;
+
+    virtual bool saveGeometry( MeshCacheWriter& writer ) const;
+    virtual bool loadGeometry( MeshCacheEntry& entry );
+    virtual bool getTriangles( int& numVerts, const float*& vertices, const float*& normals,
+            const float*& texCoords, int& texCoordSize, const IndexArray*& indices ) const;
+
+    virtual float getLODError( int level ) const;
+    virtual Shape* createLOD( int level ) const;
 
     virtual bool buildData();
     virtual bool storeData();
+    virtual bool freeHostData();
 
 	//
-	// Inline utility functions used by buildData().
-	inline unsigned int makeKey( const unsigned short a, const unsigned short b ) const
-	{
-		if ( a < b )
-			return (( a << 16) | b);
-		else
-			return (( b << 16) | a);
-	};
+	// Inline utility function used by buildData().
 	inline void average3fv( float* r, const float* a, const float* b ) const
 	{
 		r[0] = (a[0] + b[0]) * .5f;
@@ -55,6 +67,17 @@ protected:
 		r[2] = (a[2] + b[2]) * .5f;
 	};
 
+	//
+	// Edge table used by buildData() to share midpoint vertices
+	//   between the two faces adjacent to each edge. _a is always
+	//   the smaller of the two vertex indices.
+	struct EdgeEntry
+	{
+		GLuint _a, _b;
+		GLuint _vert;
+	};
+	GLuint midpoint( EdgeEntry* edgeTable, int tableBits, GLuint a, GLuint b );
+
 
     float _radius;
     int _subdivisions;
@@ -62,7 +85,7 @@ protected:
     GLfloat* _vertices;
     GLfloat* _normals;
     GLfloat* _texCoords;
-    GLushort* _indices;
+    IndexArray _indices;
 
     GLuint _idxStart, _idxEnd;
 
@@ -120,14 +143,21 @@ public:
     virtual ~Sphere15();
 
     virtual void draw();
+    virtual void contextLost();
 
 protected:
     Sphere15( float radius, int subdivisions );
 
     virtual bool storeData();
 
-    static int _vertIdx, _normIdx, _texIdx, _idxIdx;
-    GLuint _vbo[4];
+    // Binds the vertex buffer object and specifies the vertex arrays.
+    void setPointers() const;
+
+    virtual bool drawInstancedElements( int count, InstanceBuffer& instances );
+
+    BufferBlock* _vertBlock;
+    BufferBlock* _idxBlock;
+    CompactVertices _compact;
 };
 
 #endif
@@ -0,0 +1,154 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+// 
+
+#ifndef __OGLD_STATIC_BATCH_H__
+#define __OGLD_STATIC_BATCH_H__
+
+
+#include "OGLDPlatformGL.h"
+#include "OGLDif.h"
+#include "OGLDShape.h"
+#include "OGLDIndexArray.h"
+#include <vector>
+
+namespace ogld
+{
+
+
+//
+// StaticBatch
+//
+// Merges Shapes that never move relative to each other into a single
+//   Shape. add() takes each Shape with its modeling transformation
+//   and material; the first draw() tessellates them, transforms their
+//   positions and normals on the CPU, and stores everything in one
+//   vertex array and one index array. Entries with equal materials
+//   are drawn together, so draw() issues one glDrawElements() per
+//   distinct material, with no matrix stack changes.
+//
+// The material color becomes a per-vertex color; enable
+//   GL_COLOR_MATERIAL to light with it. draw() sets the GL_FRONT
+//   specular color and shininess of each material, and restores both
+//   when it returns.
+//
+class StaticBatch : public Shape
+{
+public:
+    static StaticBatch* create();
+
+    virtual ~StaticBatch();
+
+    virtual void draw();
+
+    struct Material
+    {
+        Material( const GLfloat* color, const GLfloat* specular, GLfloat shininess );
+
+        bool operator<( const Material& rhs ) const;
+        bool operator==( const Material& rhs ) const;
+
+        GLfloat _color[ 4 ];
+        GLfloat _specular[ 4 ];
+        GLfloat _shininess;
+    };
+
+    // Adds 'shape' transformed by 'matrix', sixteen floats in the
+    //   order glMultMatrixf() takes them. Call before the first
+    //   draw(). Copies the Shape's parameters, so the caller may
+    //   delete it afterwards. Returns false for Shapes that can't be
+    //   batched: only Shapes that can share their geometry (see
+    //   Shape::setShared()) can.
+    bool add( const Shape* shape, const GLfloat* matrix, const Material& material );
+
+    // Number of glDrawElements() calls per draw(): one per distinct
+    //   material. Zero before the first draw().
+    int getNumDraws() const;
+
+protected:
+    StaticBatch();
+
+    virtual bool init();
+    virtual bool buildGeometry();
+
+    virtual bool storeData();
+
+    // Enables the client arrays and sets their pointers, relative to
+    //   'base': _vertices, or the start of a buffer object.
+    void setPointers( const GLubyte* base ) const;
+
+    // Issues the draw calls, one for each Group.
+    void drawGroups() const;
+
+    struct Entry
+    {
+        Shape* _shape;
+        GLfloat _matrix[ 16 ];
+        Material _material;
+    };
+    std::vector< Entry > _entries;
+
+    // Run of indices that share a material.
+    struct Group
+    {
+        Material _material;
+        int _firstIndex, _numIndices;
+        GLuint _idxStart, _idxEnd;
+    };
+    std::vector< Group > _groups;
+
+    // Box around the transformed bounds of every entry.
+    float _min[ 3 ], _max[ 3 ];
+
+    // Per vertex: position, normal, RGBA color, and _texCoordSize
+    //   texture coordinates.
+    GLfloat* _vertices;
+    int _numVerts, _vertexFloats, _texCoordSize;
+    IndexArray _indices;
+
+    bool _valid;
+
+    GLuint _dList;
+    bool _dListAllocated;
+
+private:
+    // Not copyable.
+    StaticBatch( const StaticBatch& );
+    StaticBatch& operator=( const StaticBatch& );
+};
+
+
+#ifdef GL_VERSION_1_5
+
+class StaticBatch15 : public StaticBatch
+{
+    friend class StaticBatch;
+
+public:
+    virtual ~StaticBatch15();
+
+    virtual void draw();
+
+protected:
+    StaticBatch15();
+
+    virtual bool storeData();
+
+    static int _vertIdx, _idxIdx;
+    GLuint _vbo[2];
+};
+
+#endif
+
+}
+
+
+#endif
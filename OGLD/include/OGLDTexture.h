@@ -16,6 +16,9 @@
 
 #include "OGLDPlatformGL.h"
 #include "OGLDPixels.h"
+#include "OGLDHostData.h"
+#include "OGLDMipmap.h"
+#include "OGLDResample.h"
 #include <string>
 
 
@@ -23,14 +26,35 @@ namespace ogld
 {
 
 
+class BuildJob;
+class TextureLoadJob;
+
+
 class Texture : public Pixels
 {
+    // Allow TextureCache to access Pixels::size()
+    friend class TextureCache;
+
 public:
     static Texture* create();
 
     virtual ~Texture();
 
     virtual bool loadImage( const std::string& fileName );
+
+    // Like loadImage(), but decodes the image on a BuildThread worker
+    //   and returns at once. Until the worker finishes, apply() binds
+    //   a 1x1 white placeholder; the next apply() then stores the
+    //   image, through a pixel unpack buffer when
+    //   GL_ARB_pixel_buffer_object is available. If the image can't
+    //   be loaded, the Texture ends up as though loadImage() had
+    //   failed. The returned job remains valid until the next load or
+    //   unload().
+    BuildJob* loadImageAsync( const std::string& fileName );
+
+    // True from loadImageAsync() until apply() stores the image.
+    bool isLoading() const;
+
     virtual bool loadDirect( GLsizei width, GLsizei height, GLubyte* pixels );
     virtual bool reserve( GLsizei width, GLsizei height );
 
@@ -46,17 +70,85 @@ public:
 
     GLuint getObject() const;
 
+    // Whether textures with an image get mipmaps, and how they're
+    //   filtered; see MipmapChain. Call before loading. The defaults
+    //   are true and BoxFilter.
+    void setMipmap( bool mipmap );
+    bool getMipmap() const;
+    void setMipmapFilter( MipmapFilter filter );
+    MipmapFilter getMipmapFilter() const;
+
+    // Images that aren't a power of two are stored as they are if
+    //   OGLDif::isTextureNPOTSupported(), and otherwise resampled to
+    //   power-of-two dimensions rounded this way. Call before loading.
+    //   The default is RoundUpPower2.
+    void setPower2Rounding( Power2Rounding rounding );
+    Power2Rounding getPower2Rounding() const;
+
+    // What happens to the pixels of an image file once they're stored
+    //   in the texture object; see HostDataPolicy. Call before
+    //   loadImage(). Under ReleaseHostData, getPixels() returns NULL
+    //   after loadImage(). Textures loaded with loadDirect() always
+    //   keep their pixels.
+    void setHostDataPolicy( HostDataPolicy policy );
+    HostDataPolicy getHostDataPolicy() const;
+
+    // Call after the context that owned the texture object is
+    //   destroyed and another context (sharing nothing with it) is
+    //   made current. Forgets the texture object (and the
+    //   placeholder) without deleting it; the next apply() creates it
+    //   again, first reloading the image file if its pixels were
+    //   released.
+    void contextLost();
+
 protected:
     Texture();
 
     virtual bool init();
     virtual void initTextureObject();
 
+    // Called by apply() while isLoading(). Stores the image and
+    //   returns true once the loadImageAsync() worker is done.
+    bool finishLoad();
+
+    // Binds the placeholder texture that apply() uses while
+    //   isLoading().
+    void applyPlaceholder();
+
+    // glTexImage2D() of _pixels to level 0 and, if 'mipmaps' is true,
+    //   of the MipmapChain built from them to the levels below.
+    //   finishLoad() has it go through a pixel unpack buffer.
+    void texImage2D( bool mipmaps );
+
+    // Resamples _pixels to power-of-two dimensions, if OpenGL needs
+    //   them; see setPower2Rounding().
+    void resampleToPower2();
+
+    // Frees _pixels under ReleaseHostData after loading a file.
+    void releaseHostPixels();
+
     GLuint _texId;
     bool _textureObjectAllocated;
     GLenum _unit;
 
     GLint _mode;
+    bool _mipmap;
+    MipmapFilter _mipmapFilter;
+    Power2Rounding _power2Rounding;
+
+    HostDataPolicy _hostDataPolicy;
+
+    // Image file that loadImage() loaded, for reloading after
+    //   contextLost(). Empty for any other contents.
+    std::string _fileName;
+
+    TextureLoadJob* _loadJob;
+    bool _loading;
+    bool _uploadFromBuffer;
+
+    // Shared by all Textures.
+    static GLuint _placeholder;
+    static bool _placeholderAllocated;
 };
 
 
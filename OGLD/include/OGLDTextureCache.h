@@ -0,0 +1,133 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+//
+
+
+#ifndef __OGLD_TEXTURE_CACHE_H__
+#define __OGLD_TEXTURE_CACHE_H__
+
+
+#if defined( WIN32 ) && !defined( __CYGWIN__ )
+  // Eliminate warning 4786:
+  //   "identifier was truncated to '255' characters in the debug information"
+  #pragma warning (disable : 4786)
+#endif
+
+#include "OGLDPlatformGL.h"
+#include "OGLDMipmap.h"
+#include "OGLDResample.h"
+#include <list>
+#include <map>
+#include <string>
+
+
+namespace ogld
+{
+
+
+class Texture;
+
+
+//
+// TextureCache
+//
+// Shares Textures loaded from the same image file with the same
+//   parameters, so that each file is decoded and stored in OpenGL
+//   once no matter how many objects use it. Files are identified by
+//   the path OGLDif::findDataFile() resolves them to. Each Texture is
+//   owned by the cache and reference counted by its users.
+//
+// Everything that configures a Texture is part of what identifies
+//   it, so users that want a different unit or environment mode get
+//   a Texture of their own. Don't call setters on, or load anything
+//   else into, a cached Texture; every holder would see the change.
+//
+// By default, a Texture is deleted when its last reference is
+//   released. setUnusedBudget() keeps unreferenced Textures for reuse
+//   instead, deleting the least recently released first when they
+//   exceed the budget.
+//
+class TextureCache
+{
+public:
+    static TextureCache* instance();
+
+    // Returns the Texture for 'fileName' loaded with the given
+    //   parameters (see Pixels::setFormat() and setType(), and
+    //   Texture::setMipmap(), setMipmapFilter(), setPower2Rounding(),
+    //   setUnit(), and setEnvMode()) and adds a reference to it. A
+    //   'unit' of 0 keeps Texture's default. On first use, creates and
+    //   loads it. Returns NULL if the file isn't found on the data
+    //   path or can't be loaded.
+    Texture* acquire( const std::string& fileName, GLenum format=GL_RGBA,
+            GLenum type=GL_UNSIGNED_BYTE, bool mipmap=true,
+            MipmapFilter filter=BoxFilter, Power2Rounding rounding=RoundUpPower2,
+            GLenum unit=0, GLint envMode=GL_MODULATE );
+
+    // Removes a reference to 'texture'. Requires a current OpenGL
+    //   context.
+    void release( Texture* texture );
+
+    // Bytes of OpenGL texture memory that unreferenced Textures may
+    //   hold. The default, 0, keeps none.
+    void setUnusedBudget( unsigned int bytes );
+    unsigned int getUnusedBudget() const;
+
+    // Deletes all unreferenced Textures. Requires a current OpenGL
+    //   context.
+    void evict();
+
+    // Calls Texture::contextLost() on every cached Texture, referenced
+    //   or not.
+    void contextLost();
+
+    // Number of Textures in the cache, and how many of them are
+    //   unreferenced.
+    int getSize() const;
+    int getNumUnused() const;
+    unsigned int getUnusedBytes() const;
+
+protected:
+    TextureCache();
+
+    static TextureCache* _instance;
+
+    // Deletes unreferenced Textures, least recently released first,
+    //   until they fit in 'budget' bytes.
+    void trim( unsigned int budget );
+
+    typedef std::list< std::string > KeyList;
+
+    struct Entry
+    {
+        Texture* _texture;
+        int _refCount;
+        unsigned int _bytes;
+        // Position in _unused while _refCount is 0.
+        KeyList::iterator _unusedPos;
+    };
+    typedef std::map< std::string, Entry > EntryMap;
+    EntryMap _entries;
+
+    typedef std::map< Texture*, std::string > KeyMap;
+    KeyMap _keys;
+
+    // Keys of unreferenced Textures, least recently released first.
+    KeyList _unused;
+    unsigned int _unusedBytes;
+    unsigned int _unusedBudget;
+};
+
+
+}
+
+
+#endif
@@ -0,0 +1,149 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+// 
+
+
+#ifndef __OGLD_THREAD_H__
+#define __OGLD_THREAD_H__
+
+
+#if defined( WIN32 ) && !defined( __CYGWIN__ )
+  #include <windows.h>
+#else
+  #include <pthread.h>
+#endif
+
+
+namespace ogld
+{
+
+
+//
+// Minimal portability layer over Win32 and POSIX threads, for the
+//   few places OGLD does work off the OpenGL thread.
+//
+
+class Mutex
+{
+public:
+    Mutex();
+    ~Mutex();
+
+    void lock();
+    void unlock();
+
+private:
+#if defined( WIN32 ) && !defined( __CYGWIN__ )
+    CRITICAL_SECTION _cs;
+#else
+    pthread_mutex_t _mutex;
+#endif
+
+    // Not copyable.
+    Mutex( const Mutex& );
+    Mutex& operator=( const Mutex& );
+};
+
+// Locks a Mutex for the lifetime of the ScopedLock.
+class ScopedLock
+{
+public:
+    ScopedLock( Mutex& mutex ) : _mutex( mutex ) { _mutex.lock(); }
+    ~ScopedLock() { _mutex.unlock(); }
+
+private:
+    Mutex& _mutex;
+
+    // Not copyable.
+    ScopedLock( const ScopedLock& );
+    ScopedLock& operator=( const ScopedLock& );
+};
+
+// Auto-reset event. wait() blocks until signal() is called, then
+//   resets. Signals sent with no thread waiting are remembered, but
+//   do not accumulate.
+class Event
+{
+public:
+    Event();
+    ~Event();
+
+    void signal();
+    void wait();
+
+private:
+#if defined( WIN32 ) && !defined( __CYGWIN__ )
+    HANDLE _event;
+#else
+    pthread_mutex_t _mutex;
+    pthread_cond_t _cond;
+    bool _signaled;
+#endif
+
+    // Not copyable.
+    Event( const Event& );
+    Event& operator=( const Event& );
+};
+
+// Derive and override run(). start() runs it on a new thread.
+class Thread
+{
+public:
+    Thread();
+    virtual ~Thread();
+
+    bool start();
+    void join();
+
+protected:
+    virtual void run() = 0;
+
+private:
+#if defined( WIN32 ) && !defined( __CYGWIN__ )
+    static unsigned int __stdcall entry( void* arg );
+    HANDLE _thread;
+#else
+    static void* entry( void* arg );
+    pthread_t _thread;
+#endif
+    bool _started;
+
+    // Not copyable.
+    Thread( const Thread& );
+    Thread& operator=( const Thread& );
+};
+
+
+// Work that parallelFor() splits across threads.
+class RangeTask
+{
+public:
+    virtual ~RangeTask() {}
+
+    // Processes items 'begin' up to, but not including, 'end'. Called
+    //   concurrently with disjoint ranges.
+    virtual void run( int begin, int end ) = 0;
+};
+
+// Number of processors available to the process, at least 1.
+int getNumProcessors();
+
+// Splits items 0 through count-1 into contiguous ranges of at least
+//   'grain' items, at most one per processor, and runs 'task' on
+//   each: the first on the calling thread, the rest on new Threads.
+//   Returns when every range is done.
+void parallelFor( RangeTask& task, int count, int grain=1 );
+
+
+}
+
+
+#endif
@@ -0,0 +1,279 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+// 
+
+
+#ifndef __OGLD_TILED_HEIGHT_FIELD_H__
+#define __OGLD_TILED_HEIGHT_FIELD_H__
+
+
+#include "OGLDPlatformGL.h"
+#include "OGLDif.h"
+#include "OGLDShape.h"
+#include "OGLDBound.h"
+#include "OGLDFrustum.h"
+#include "OGLDIndexArray.h"
+#include "OGLDThread.h"
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+
+namespace ogld
+{
+
+
+class TileLoader;
+
+
+//
+// TiledHeightField
+//
+// A height field, optionally with a color image draped over it,
+//   streamed from a tile file that is too large to hold in memory.
+//
+// writeFile() stores the data as a quadtree pyramid: level 0 tiles
+//   hold 'tileUnits' quads of the full resolution grid on a side,
+//   and each coarser level samples every other grid line of the one
+//   below, so that a single tile at the top level covers the whole
+//   grid. Every tile has the same size on disk, and carries the
+//   bounds and errors of its four children, so locating and culling
+//   a tile needs no index in memory.
+//
+// draw() walks the pyramid from the top, culling tiles to the view
+//   frustum and refining those whose error projects to more than the
+//   setLOD() pixel budget (or all of them, with LOD disabled). Tiles
+//   that aren't loaded yet are requested from a TileLoader thread,
+//   and their parent draws in their place until they arrive. Loaded
+//   tiles stay in bounded least-recently-used caches of CPU and GPU
+//   tiles, so memory use depends on the cache sizes, not on the size
+//   of the data set. Edges between tiles of different levels are
+//   stitched as in HeightField.
+//
+// Enable GL_TEXTURE_2D and set the texture environment to draw with
+//   the image; draw() binds each tile's texture object to the active
+//   texture unit.
+//
+class TiledHeightField : public Shape
+{
+public:
+    // Returns NULL if 'fileName' can't be opened or isn't a tile file.
+    static TiledHeightField* create( const std::string& fileName, int maxCPUTiles=256, int maxGPUTiles=128 );
+
+    // Writes a tile file. The arguments match HeightField::create(),
+    //   plus an RGBA image covering the whole grid (or NULL) and the
+    //   texture size of each tile, a power of two.
+    static bool writeFile( const std::string& fileName,
+            float xLen, float yLen, int xUnits, int yUnits, const float* zArray,
+            int imageW, int imageH, const GLubyte* image,
+            int tileUnits=32, int tileTexels=128 );
+
+    virtual ~TiledHeightField();
+
+    virtual void draw();
+
+    int getNumLevels() const;
+
+    // Statistics from the most recent draw().
+    int getTilesDrawn() const;
+    int getTrianglesDrawn() const;
+    int getCPUTiles() const;
+    int getGPUTiles() const;
+    int getPendingTiles() const;
+
+    // Waits until no loads are outstanding. For tests and batch
+    //   rendering; interactive programs just keep drawing.
+    void waitForLoads();
+
+protected:
+    friend class TileLoader;
+
+    TiledHeightField( int maxCPUTiles, int maxGPUTiles );
+
+    bool open( const std::string& fileName );
+
+    virtual bool init();
+
+    // Stops the TileLoader. Every concrete class calls this first in
+    //   its destructor.
+    void stopLoader();
+
+    typedef struct {
+        float _minZ, _maxZ, _error;
+        bool _present;
+    } TileInfo;
+
+    typedef enum {
+        Absent,
+        Queued,
+        Loading,
+        Loaded
+    } TileState;
+
+    struct Tile
+    {
+        int _level, _x, _y;
+        TileInfo _info;
+        Bound _bound;
+
+        // Guarded by the TileLoader mutex while Queued or Loading.
+        TileState _state;
+
+        // CPU tile: interleaved vertices and texels. The child info
+        //   outlives them, for as long as the Tile exists.
+        GLfloat* _vertices;
+        GLubyte* _texels;
+        TileInfo _children[ 4 ];
+        bool _childrenKnown;
+
+        // GPU tile.
+        bool _uploaded;
+        GLuint _texId;
+        GLuint _vbo;
+        GLfloat* _drawVertices;
+
+        unsigned int _lastUsed;
+        std::list< Tile* >::iterator _cpuEntry, _gpuEntry;
+        bool _inCPU, _inGPU;
+    };
+
+    typedef std::pair< int, std::pair< int, int > > TileKey;
+    typedef std::map< TileKey, Tile* > TileMap;
+
+    Tile* getTile( int level, int x, int y, const TileInfo& info );
+
+    // Reads a tile into its CPU data. Called on the TileLoader thread,
+    //   or on the OpenGL thread for the top tile.
+    bool readTile( Tile* tile );
+
+    // Picks the tiles to draw under 'tile', requesting loads for
+    //   tiles it would rather draw.
+    void select( Tile* tile );
+    bool makeDrawable( Tile* tile );
+
+    // Indices for 'tile', stitched to any coarser neighbors.
+    const IndexArray& getIndices( const Tile* tile );
+
+    void touchCPU( Tile* tile );
+    void touchGPU( Tile* tile );
+    void evict();
+    void releaseCPU( Tile* tile );
+
+    // OpenGL storage for a tile.
+    virtual void uploadTile( Tile* tile );
+    virtual void releaseTile( Tile* tile );
+    virtual void setPointers( const Tile* tile );
+    void createTexture( Tile* tile, GLint wrap );
+
+    long getTileOffset( int level, int x, int y ) const;
+    int getTilesX( int level ) const;
+    int getTilesY( int level ) const;
+
+    // File header.
+    int _tileUnits, _tileTexels, _numLevels;
+    int _xUnits, _yUnits;
+    float _xLen, _yLen;
+    TileInfo _topInfo;
+    std::vector< long > _levelStart;
+    int _tileSize;
+
+    FILE* _file;
+    TileLoader* _loader;
+    bool _threaded;
+
+    TileMap _tiles;
+    Tile* _top;
+    std::list< Tile* > _cpuLRU, _gpuLRU;
+    int _maxCPUTiles, _maxGPUTiles;
+
+    typedef std::map< int, IndexArray* > IndexMap;
+    IndexMap _indexMap;
+
+    // Per-draw() state.
+    unsigned int _frame;
+    std::vector< Tile* > _drawList, _requests;
+    std::map< TileKey, int > _drawnLevel;
+    Frustum _frustum;
+    double _modelView[ 16 ], _pixelsPerUnit, _scale;
+    bool _perspective;
+    int _uploads;
+    int _tilesDrawn, _trianglesDrawn;
+
+    bool _valid;
+
+private:
+    // Not copyable.
+    TiledHeightField( const TiledHeightField& );
+    TiledHeightField& operator=( const TiledHeightField& );
+};
+
+
+#ifdef GL_VERSION_1_5
+
+class TiledHeightField15 : public TiledHeightField
+{
+    friend class TiledHeightField;
+
+public:
+    virtual ~TiledHeightField15();
+
+protected:
+    TiledHeightField15( int maxCPUTiles, int maxGPUTiles );
+
+    virtual void uploadTile( Tile* tile );
+    virtual void releaseTile( Tile* tile );
+    virtual void setPointers( const Tile* tile );
+};
+
+#endif
+
+
+//
+// TileLoader
+//
+// The thread that reads tiles for a TiledHeightField. Each draw()
+//   replaces its queue with the tiles that frame wanted, coarsest
+//   first; tiles no longer wanted go back to Absent.
+//
+class TileLoader : protected Thread
+{
+public:
+    TileLoader( TiledHeightField* owner );
+    virtual ~TileLoader();
+
+    bool start();
+
+    void setRequests( const std::vector< TiledHeightField::Tile* >& requests );
+
+    // Moves tiles that finished loading into 'loaded'.
+    void takeLoaded( std::vector< TiledHeightField::Tile* >& loaded );
+
+    int getPending();
+    void waitForIdle();
+
+    Mutex _mutex;
+
+protected:
+    virtual void run();
+
+    TiledHeightField* _owner;
+    std::vector< TiledHeightField::Tile* > _queue, _loaded;
+    size_t _next;
+    bool _busy, _quit;
+    Event _work, _idle;
+};
+
+
+}
+
+
+#endif
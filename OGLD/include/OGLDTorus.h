@@ -17,6 +17,9 @@
 #include "OGLDPlatformGL.h"
 #include "OGLDif.h"
 #include "OGLDShape.h"
+#include "OGLDIndexArray.h"
+#include "OGLDCompactVertices.h"
+#include "OGLDBufferArena.h"
 
 namespace ogld
 {
@@ -25,19 +28,35 @@ namespace ogld
 class Torus : public Shape
 {
 public:
-    static Torus* create( float majRadius=1.f, float minRadius=.25f, int majApprox=32, int minApprox=32 );
+    static Torus* create( float majRadius=1.f, float minRadius=.25f, int majApprox=32, int minApprox=32, VertexFormat format=FloatVertexFormat );
 
     virtual ~Torus();
 
     virtual void draw();
 
+    virtual void contextLost();
+
+
 protected:
     Torus( float majRadius, float minRadius, int majApprox, int minApprox );
 
     virtual bool init();
+    virtual bool buildGeometry();
+
+    virtual bool getShareKey( std::string& key ) const;
+    virtual Shape* createMaster() const;
+
+    virtual bool saveGeometry( MeshCacheWriter& writer ) const;
+    virtual bool loadGeometry( MeshCacheEntry& entry );
+    virtual bool getTriangles( int& numVerts, const float*& vertices, const float*& normals,
+            const float*& texCoords, int& texCoordSize, const IndexArray*& indices ) const;
+
+    virtual float getLODError( int level ) const;
+    virtual Shape* createLOD( int level ) const;
 
     virtual bool buildData();
     virtual bool storeData();
+    virtual bool freeHostData();
 
     float _majRadius, _minRadius;
     int _majApprox, _minApprox;
@@ -45,7 +64,7 @@ protected:
     GLfloat* _vertices;
     GLfloat* _normals;
     GLfloat* _texCoords;
-    GLushort* _indices;
+    IndexArray _indices;
 
     GLuint _idxStart, _idxEnd;
 
@@ -103,14 +122,21 @@ public:
     virtual ~Torus15();
 
     virtual void draw();
+    virtual void contextLost();
 
 protected:
     Torus15( float majRadius, float minRadius, int majApprox, int minApprox );
 
     virtual bool storeData();
 
-    static int _vertIdx, _normIdx, _texIdx, _idxIdx;
-    GLuint _vbo[4];
+    // Binds the vertex buffer object and specifies the vertex arrays.
+    void setPointers() const;
+
+    virtual bool drawInstancedElements( int count, InstanceBuffer& instances );
+
+    BufferBlock* _vertBlock;
+    BufferBlock* _idxBlock;
+    CompactVertices _compact;
 };
 
 #endif
@@ -0,0 +1,64 @@
+//
+// http://www.opengldistilled.com
+//
+// This code was written by Paul Martz (pmartz@opengldistilled.com)
+//
+// This code comes with absolutely no warranty.
+//
+// You may freely use, distribute, modify, and publish this source
+// code, provided that this comment block remains intact in all
+// copies and derived works.
+// 
+
+
+#ifndef __OGLD_VERTEX_CACHE_H__
+#define __OGLD_VERTEX_CACHE_H__
+
+
+#include "OGLDPlatformGL.h"
+
+
+namespace ogld
+{
+
+
+//
+// Post-transform vertex cache utilities
+//
+// Shapes call these between buildData() and IndexArray::pack() to
+//   order their triangles so that the GPU transforms each vertex as
+//   few times as possible, and to renumber their vertices so that
+//   vertex fetches proceed through memory in order.
+//
+
+// Reorders the triangles of an indexed triangle list using Tom
+//   Forsyth's "Linear-Speed Vertex Cache Optimisation" heuristic.
+void optimizeVertexCache( GLuint* indices, int numIndices, int numVerts );
+
+// Renumbers vertices in the order 'indices' first references them,
+//   rewriting 'indices' in place. On return, remap[ oldIndex ] holds
+//   the new index of each vertex. Unreferenced vertices are moved to
+//   the end.
+void reorderVertices( GLuint* indices, int numIndices, int numVerts, GLuint* remap );
+
+// Permutes a vertex attribute array with 'components' values per
+//   vertex to match a remap table from reorderVertices().
+void remapVertexArray( GLfloat* data, int components, int numVerts, const GLuint* remap );
+
+// Runs optimizeVertexCache() and reorderVertices() on a Shape's
+//   triangle list, and permutes its vertex, normal, and texture
+//   coordinate arrays to match.
+void optimizeTriangleList( GLuint* indices, int numIndices, int numVerts,
+        GLfloat* vertices, GLfloat* normals, GLfloat* texCoords, int texComponents );
+
+// Average cache miss ratio: vertices transformed per triangle, for a
+//   FIFO post-transform cache with 'cacheSize' entries. 'mode' is
+//   GL_TRIANGLES, GL_TRIANGLE_STRIP, GL_TRIANGLE_FAN, or
+//   GL_QUAD_STRIP.
+float computeACMR( GLenum mode, const GLuint* indices, int numIndices, int cacheSize=16 );
+
+
+}
+
+
+#endif
@@ -35,6 +35,9 @@ public:
     virtual void loadInverseAffine() const;
     virtual void multInverseAffine() const;
 
+    // Returns the matrix multMatrix() applies, in OpenGL order.
+    virtual void getMatrix( double* m ) const;
+
     virtual void setDirUp( const Vec3d& dir, const Vec3d& up );
     virtual void getDirUp( Vec3d& dir, Vec3d& up );
 
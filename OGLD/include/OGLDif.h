@@ -39,6 +39,9 @@
 #ifndef GL_VERSION_2_0
 #define __OGLD_NEED_2_0
 #endif
+#ifndef GL_VERSION_3_3
+#define __OGLD_NEED_3_3
+#endif
 
 #ifndef __APPLE__
 #include <GL/glext.h>
@@ -65,6 +68,14 @@ public:
 
     OpenGLVersion getVersion();
 
+    // True if instanced drawing is available: OpenGL 3.3, or 2.0 or
+    //   later with ARB_draw_instanced and ARB_instanced_arrays.
+    bool isInstancingSupported();
+
+    // True if textures needn't have power-of-two dimensions: OpenGL
+    //   2.0, or ARB_texture_non_power_of_two.
+    bool isTextureNPOTSupported();
+
     void* getProcAddress( const char* function );
     bool isExtensionSupported( const std::string& name, const GLubyte* extensions );
 
@@ -73,6 +84,10 @@ public:
     void addToDataPath( std::string path );
     void clearDataPath();
 
+    // Returns the first data path entry plus 'fileName' that names a
+    //   readable file, or an empty string if there is none.
+    std::string findDataFile( const std::string& fileName ) const;
+
     void checkError();
 
 protected:
@@ -87,6 +102,8 @@ protected:
     void* _dlHandle;
 
     OpenGLVersion _version;
+    bool _instancing;
+    bool _textureNPOT;
 
     std::vector<std::string> _dataPath;
 };
@@ -391,5 +408,14 @@ OGLDIF_DECLARATION PFNGLVERTEXATTRIBPOINTERPROC glVertexAttribPointer;
 #endif
 
 
+#if defined( GL_VERSION_3_3 ) && defined( __OGLD_NEED_3_3 )
+//
+// Instanced drawing entry points, from version 3.3 or
+//   ARB_draw_instanced and ARB_instanced_arrays
+OGLDIF_DECLARATION PFNGLDRAWELEMENTSINSTANCEDPROC glDrawElementsInstanced;
+OGLDIF_DECLARATION PFNGLVERTEXATTRIBDIVISORPROC glVertexAttribDivisor;
+#endif
+
+
 // #ifndef __OGLD_IF_H__
 #endif
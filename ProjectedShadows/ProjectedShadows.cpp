@@ -20,7 +20,9 @@
 #include "OGLDAltAzView.h"
 #include "OGLDTexture.h"
 #include "OGLDMath.h"
+#include "OGLDShapeTuner.h"
 #include <iostream>
+#include <string>
 #include <stdlib.h>
 #include <assert.h>
 
@@ -555,6 +557,15 @@ main( int argc, char** argv )
     glutInitWindowSize( 500, 500 );
     glutCreateWindow( "Projected Shadows" );
 
+    // "-tune <file>" times the Shape storage paths on this renderer,
+    //   once, and keeps the fastest in <file> for later runs.
+    if ( (argc > 2) && (std::string( argv[1] ) == "-tune") )
+    {
+        ogld::ShapeTuner* tuner = ogld::ShapeTuner::instance();
+        tuner->setFileName( argv[2] );
+        tuner->calibrate();
+    }
+
     init();
 
     glutMainLoop();
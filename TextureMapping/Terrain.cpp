@@ -14,14 +14,16 @@
 #include "OGLDTexture.h"
 #include "OGLDif.h"
 #include "Terrain.h"
-#include <assert.h>
-#include <stdio.h>
-
-// Header files for ntohl and ntohs vary by platform
-#if defined( __CYGWIN__ ) || defined( GLX )
-  #include <netinet/in.h>
-#elif defined( __APPLE__ )
-  #include <arpa/inet.h>
+
+// File mapping differs by platform
+#if defined( WIN32 ) && !defined( __CYGWIN__ )
+  #include <windows.h>
+#else
+  #include <sys/types.h>
+  #include <sys/stat.h>
+  #include <sys/mman.h>
+  #include <fcntl.h>
+  #include <unistd.h>
 #endif
 
 using namespace ogld;
@@ -29,17 +31,26 @@ using namespace ogld;
 
 Terrain::Terrain()
   : _hf( NULL ),
+    _tiled( NULL ),
     _texture( NULL )
 {
 }
 
 Terrain::~Terrain()
+{
+    clear();
+}
+
+void Terrain::clear()
 {
     if (_hf)
         delete _hf;
+    if (_tiled)
+        delete _tiled;
     if (_texture)
         delete _texture;
     _hf = NULL;
+    _tiled = NULL;
     _texture = NULL;
 }
 
@@ -49,9 +60,17 @@ void Terrain::draw() const
     glPushAttrib( GL_TEXTURE_BIT );
 
     glEnable( GL_TEXTURE_2D );
-    _texture->apply();
-
-    _hf->draw();
+    if (_tiled)
+    {
+        // Each tile binds its own texture.
+        glTexEnvi( GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE );
+        _tiled->draw();
+    }
+    else
+    {
+        _texture->apply();
+        _hf->draw();
+    }
 
     glPopAttrib();
 
@@ -59,7 +78,98 @@ void Terrain::draw() const
     OGLDIF_CHECK_ERROR;
 }
 
+void Terrain::setLOD( bool enable )
+{
+    if (_hf)
+        _hf->setLOD( enable, 1.f );
+    if (_tiled)
+        _tiled->setLOD( enable, 1.f );
+}
+
+bool Terrain::getLOD() const
+{
+    return( (_hf && _hf->getLOD()) || (_tiled && _tiled->getLOD()) );
+}
+
 bool Terrain::init( const std::string& dataFile )
+{
+    clear();
+
+    size_t size;
+    int elevW, elevH, imageW, imageH;
+    const GLushort* elev;
+    const unsigned char* image;
+    const unsigned char* data = mapData( dataFile, size, elevW, elevH, elev, imageW, imageH, image );
+    if (data == NULL)
+        return false;
+
+    // Create the HeightField. It splits the elevation data into
+    //   chunks, culls them to the view, and draws each at a level of
+    //   detail that keeps its error within a pixel. It converts the
+    //   samples straight from the mapped file.
+    _hf = ogld::HeightField::create( 11852.f * .7f, 11852.f, elevW-1, elevH-1, elev );
+    _hf->setLOD( true, 1.f );
+
+    // Create the Texture, load the data. Specify GL_REPLACE texture
+    //   environment mode, since the image contains all lighting and
+    //   shadow effects.
+    _texture = ogld::Texture::create();
+    _texture->loadDirect( (GLsizei)imageW, (GLsizei)imageH, (GLubyte*)image );
+    _texture->setEnvMode( GL_REPLACE );
+
+    unmapData( data, size );
+
+    return true;
+}
+
+bool Terrain::initTiled( const std::string& tileFile )
+{
+    clear();
+
+    // Search the data paths, as for init().
+    int idx;
+    for( idx = 0; (_tiled == NULL) && (idx < ogld::OGLDif::instance()->getDataPathSize()); idx++)
+        _tiled = ogld::TiledHeightField::create( ogld::OGLDif::instance()->getDataPath( idx ) + tileFile );
+    if (_tiled == NULL)
+        return false;
+
+    _tiled->setLOD( true, 1.f );
+    return true;
+}
+
+bool Terrain::convert( const std::string& dataFile, const std::string& tileFile )
+{
+    size_t size;
+    int elevW, elevH, imageW, imageH;
+    const GLushort* elev;
+    const unsigned char* image;
+    const unsigned char* data = mapData( dataFile, size, elevW, elevH, elev, imageW, imageH, image );
+    if (data == NULL)
+        return false;
+
+    float* zArray = new float[ elevW*elevH ];
+    ogld::convertHeightSamples( zArray, elev, elevW-1, elevH-1 );
+
+    const bool result = ogld::TiledHeightField::writeFile( tileFile,
+            11852.f * .7f, 11852.f, elevW-1, elevH-1, zArray,
+            imageW, imageH, (GLubyte*)image );
+    delete[] zArray;
+
+    unmapData( data, size );
+
+    return result;
+}
+
+// Reads a fullword in network byte order.
+static int getInt( const unsigned char* ptr )
+{
+    return( (int)( ((unsigned int)ptr[0] << 24) | ((unsigned int)ptr[1] << 16) |
+            ((unsigned int)ptr[2] << 8) | (unsigned int)ptr[3] ) );
+}
+
+const unsigned char* Terrain::mapData( const std::string& dataFile, size_t& size,
+        int& elevW, int& elevH, const GLushort*& elev,
+        int& imageW, int& imageH, const unsigned char*& image )
 {
     //
     // Data credits
@@ -68,117 +178,102 @@ bool Terrain::init( const std::string& dataFile )
     //     Elevation and imagery data used courtesy of SimAuthor, Inc.
     //
 
-    if (_hf)
-        delete _hf;
-    if (_texture)
-        delete _texture;
-    _hf = NULL;
-    _texture = NULL;
-
-
-    // Intentionally not using streams. I prefer to use the same IO
-    //   routines as was used to initially create the data file. This
-    //   is personal preference, and an input stream could be made to
-    //   work.
-    FILE* f = NULL;
+    // Map the whole file, rather than reading it, so that the samples
+    //   convert straight into the HeightField and the image copies
+    //   straight into the Texture.
+    const unsigned char* data = NULL;
+    size = 0;
 
     // The OGLDif class maintains a list of possible data paths.
     //   Iterate over this list until dataFile is found.
     int idx;
-    for( idx = 0; idx < ogld::OGLDif::instance()->getDataPathSize(); idx++)
+    for( idx = 0; (data == NULL) && (idx < ogld::OGLDif::instance()->getDataPathSize()); idx++)
     {
         std::string fullPath = ogld::OGLDif::instance()->getDataPath( idx ) + dataFile;
-        f= fopen( fullPath.c_str(), "rb" );
-        if (f)
-            // Found (and opened) the file.
-            break;
+#if defined( WIN32 ) && !defined( __CYGWIN__ )
+        HANDLE file = CreateFile( fullPath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+        if (file == INVALID_HANDLE_VALUE)
+            continue;
+        size = GetFileSize( file, NULL );
+        // The view keeps the mapping open once its handles close.
+        HANDLE mapping = CreateFileMapping( file, NULL, PAGE_READONLY, 0, 0, NULL );
+        if (mapping != NULL)
+        {
+            data = (const unsigned char*) MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+            CloseHandle( mapping );
+        }
+        CloseHandle( file );
+#else
+        int fd = open( fullPath.c_str(), O_RDONLY );
+        if (fd < 0)
+            continue;
+        struct stat st;
+        if ( (fstat( fd, &st ) == 0) && (st.st_size > 0) )
+        {
+            size = (size_t) st.st_size;
+            void* addr = mmap( NULL, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+            if (addr != MAP_FAILED)
+                data = (const unsigned char*) addr;
+        }
+        close( fd );
+#endif
     }
-    if ( !f )
-        // File not found; return false.
-        return false;
+    if (data == NULL)
+        // File not found; return NULL.
+        return NULL;
 
-    // First two fullwords are the elevation data width and height.
-    //   These are stored in network byte order; convert them to
-    //   host byte order.
-    int elevW, elevH, elevWNBO, elevHNBO;
-    unsigned short* elev;
-    fread( &elevWNBO, sizeof( int ), 1, f );
-    fread( &elevHNBO, sizeof( int ), 1, f );
-    elevW = ntohl( elevWNBO );
-    elevH = ntohl( elevHNBO );
-    assert( elevW > 0 );
-    assert( elevH > 0 );
-
-    // Following the width and height are a number of elevation sample
-    //   points. Each is an unsigned short. The number of sample points
-    //   is equal to elevW times elevH.
-
-    // Allocate memory to hold the elevation data.
-    elev = new unsigned short[ elevW*elevH ];
-    unsigned short* ptrE = elev;
-    for( idx=0; idx<elevW*elevH; idx++)
+    // First two fullwords are the elevation data width and height,
+    //   stored in network byte order. Following them are elevW times
+    //   elevH unsigned short elevation samples, also in network byte
+    //   order; HeightField converts them.
+    size_t offset = 0;
+    bool valid = (size >= 8);
+    if (valid)
     {
-        // Read each unsigned short elevation data sample, and convert
-        //   from network byte order to host byte order.
-        unsigned short us;
-        fread( &us, sizeof( unsigned short ), 1, f );
-        *ptrE++ = ntohs( us );
+        elevW = getInt( data );
+        elevH = getInt( data + 4 );
+        offset = 8;
+        valid = (elevW > 1) && (elevH > 1) &&
+                ((size - offset) / sizeof( GLushort ) / elevW >= (size_t) elevH);
     }
-
-
-    // The ogld::Plane class expects a y-major array of float
-    //   z values, but our elevation data is East-West or
-    //   x-major shorts, so we need to transpose it as we
-    //   convert to float.
-    float* zArray = new float[ elevW*elevH ];
-    int xIdx;
-    for( xIdx=0; xIdx<elevW; xIdx++)
+    if (valid)
     {
-        int yIdx;
-        for( yIdx=0; yIdx<elevH; yIdx++)
-            zArray[ xIdx + yIdx*elevW ] = (float)( elev[ yIdx + xIdx*elevH ] );
+        elev = (const GLushort*)( data + offset );
+        offset += (size_t) elevW * elevH * sizeof( GLushort );
+        valid = (size - offset >= 8);
     }
 
-    // Create the Plane. Note Plane has two create() factory methods,
-    //   This code uses the one that allows us to pass an array of z
-    //   values to create a height field rather than a plane.
-    _hf = ogld::Plane::create( 11852.f * .7f, 11852.f, elevW-1, elevH-1, zArray );
-    delete[] elev;
-    delete[] zArray;
-
     // Following the elevation sample points comes the texture map
     //   width and height, each are fullwords in network byte order.
-    //   Read them and convert to host byte order.
-    int imageW, imageH, imageWNBO, imageHNBO;
-    unsigned char* image;
-    fread( &imageWNBO, sizeof( int ), 1, f );
-    fread( &imageHNBO, sizeof( int ), 1, f );
-    imageW = ntohl( imageWNBO );
-    imageH = ntohl( imageHNBO );
-    assert( imageW > 0 );
-    assert( imageH > 0 );
-
-    // After the width and height are the texture map RGBA components.
-    //   These are stored as RGBA packed bytes, and the number of RGBA
-    //   values is imageW times imageH. Multiply that by 4 to get the
-    //   amount of memory we need.
-
-    // Allocate memory to hold the texture map.
-    image = new unsigned char[ imageW*imageH*4 ];
-    int sz = fread( image, sizeof( unsigned char), imageW*imageH*4, f );
-    assert( sz == imageW*imageH*4 );
-
-    // Create the Texture, load the data. Specify GL_REPLACE texture
-    //   environment mode, since the image contains all lighting and
-    //   shadow effects.
-    _texture = ogld::Texture::create();
-    _texture->loadDirect( (GLsizei)imageW, (GLsizei)imageH, (GLubyte*)image );
-    _texture->setEnvMode( GL_REPLACE );
-    delete[] image;
+    //   After them are the texture map RGBA components, stored as
+    //   RGBA packed bytes; the number of RGBA values is imageW times
+    //   imageH.
+    if (valid)
+    {
+        imageW = getInt( data + offset );
+        imageH = getInt( data + offset + 4 );
+        offset += 8;
+        valid = (imageW > 0) && (imageH > 0) &&
+                ((size - offset) / 4 / imageW >= (size_t) imageH);
+    }
+    if (!valid)
+    {
+        unmapData( data, size );
+        return NULL;
+    }
+    image = data + offset;
 
-    fclose( f );
+    return data;
+}
 
-    return true;
+void Terrain::unmapData( const unsigned char* data, size_t size )
+{
+#if defined( WIN32 ) && !defined( __CYGWIN__ )
+    UnmapViewOfFile( data );
+#else
+    munmap( (void*) data, size );
+#endif
 }
 
 
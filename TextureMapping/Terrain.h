@@ -13,7 +13,8 @@
 #ifndef __TERRAIN_H__
 #define __TERRAIN_H__
 
-#include "OGLDPlane.h"
+#include "OGLDHeightField.h"
+#include "OGLDTiledHeightField.h"
 #include <string>
 
 
@@ -34,8 +35,29 @@ public:
 
     bool init( const std::string& dataFile );
 
+    // Streams the terrain from a tile file instead, holding only the
+    //   tiles near the view in memory.
+    bool initTiled( const std::string& tileFile );
+
+    // Writes the terrain in dataFile as a tile file.
+    static bool convert( const std::string& dataFile, const std::string& tileFile );
+
+    // Chunked level of detail for the height field. On by default.
+    void setLOD( bool enable );
+    bool getLOD() const;
+
 private:
-    ogld::Plane* _hf;
+    // Maps dataFile into memory and locates its elevation samples and
+    //   image within it. Returns NULL if the file can't be found or is
+    //   malformed; otherwise, release the mapping with unmapData().
+    static const unsigned char* mapData( const std::string& dataFile, size_t& size,
+            int& elevW, int& elevH, const GLushort*& elev,
+            int& imageW, int& imageH, const unsigned char*& image );
+    static void unmapData( const unsigned char* data, size_t size );
+    void clear();
+
+    ogld::HeightField* _hf;
+    ogld::TiledHeightField* _tiled;
     ogld::Texture* _texture;
 };
 
@@ -14,6 +14,8 @@
 #include "OGLDPlatformGLUT.h"
 #include "OGLDAltAzView.h"
 #include "OGLDif.h"
+#include "OGLDMeshCache.h"
+#include "OGLDShape.h"
 #include "Terrain.h"
 #include <string>
 #include <iostream>
@@ -21,10 +23,12 @@
 #include <assert.h>
 
 static const int WIRE_SOLID_VALUE( 1 );
+static const int LOD_VALUE( 2 );
 static const int QUIT_VALUE( 99 );
 
 
 Terrain terrain;
+std::string tileFile;
 ogld::AltAzView view;
 
 bool wireSolid( true );
@@ -56,6 +60,14 @@ reshape( int w, int h )
     glLoadIdentity();
     gluPerspective( 50., (double)w/(double)h, 10., 30000. );
 
+    // The terrain selects levels of detail with these, rather than
+    //   reading them back every frame.
+    GLdouble proj[ 16 ];
+    GLint viewport[ 4 ];
+    glGetDoublev( GL_PROJECTION_MATRIX, proj );
+    glGetIntegerv( GL_VIEWPORT, viewport );
+    ogld::Shape::setLODView( proj, viewport );
+
     // Leave us in model-view mode for our display routine
     glMatrixMode( GL_MODELVIEW );
 }
@@ -101,6 +113,10 @@ mainMenuCB( int value )
         glPolygonMode( GL_FRONT_AND_BACK, wireSolid ? GL_FILL : GL_LINE );
         break;
 
+    case LOD_VALUE:
+        terrain.setLOD( !terrain.getLOD() );
+        break;
+
     case QUIT_VALUE:
         exit( 0 );
 
@@ -115,11 +131,22 @@ mainMenuCB( int value )
 static void
 init()
 {
-    bool terrainOK = terrain.init( "teton.dat" );
-    if (!terrainOK)
+    if (!tileFile.empty())
     {
-        std::cout << "Failed to load teton.dat terrain data file." << std::endl;
-        exit( 1 );
+        if (!terrain.initTiled( tileFile ))
+        {
+            std::cout << "Failed to open " << tileFile << " terrain tile file." << std::endl;
+            exit( 1 );
+        }
+    }
+    else
+    {
+        bool terrainOK = terrain.init( "teton.dat" );
+        if (!terrainOK)
+        {
+            std::cout << "Failed to load teton.dat terrain data file." << std::endl;
+            exit( 1 );
+        }
     }
 
     view.setDirUp( ogld::Vec3d( -1.f, .8f, -.4f ), ogld::Vec3d( 0.f, 0.f, 1.f ) );
@@ -142,6 +169,7 @@ init()
 
     glutCreateMenu( mainMenuCB );
     glutAddMenuEntry( "Toggle wireframe/solid", WIRE_SOLID_VALUE );
+    glutAddMenuEntry( "Toggle level of detail", LOD_VALUE );
     glutAddMenuEntry( "Quit", QUIT_VALUE );
     glutAttachMenu( GLUT_RIGHT_BUTTON );
 }
@@ -150,6 +178,30 @@ int
 main( int argc, char** argv )
 {
     glutInit( &argc, argv );
+
+    // "-cache <dir>" keeps the tessellated terrain in <dir>, so later
+    //   runs start without rebuilding it.
+    int arg = 1;
+    if ( (argc > arg+1) && (std::string( argv[arg] ) == "-cache") )
+    {
+        ogld::MeshCache::instance()->setDirectory( argv[arg+1] );
+        arg += 2;
+    }
+
+    // "-convert <file>" writes teton.dat as a tile file. "<file>"
+    //   streams the terrain from a tile file.
+    if ( (argc > arg+1) && (std::string( argv[arg] ) == "-convert") )
+    {
+        if (!Terrain::convert( "teton.dat", argv[arg+1] ))
+        {
+            std::cout << "Failed to convert teton.dat to " << argv[arg+1] << "." << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    if (argc > arg)
+        tileFile = argv[arg];
+
     glutInitDisplayMode( GLUT_RGB | GLUT_DEPTH | GLUT_DOUBLE );
     glutInitWindowPosition( 0, 0 );
     glutInitWindowSize( 300, 300 );
@@ -89,6 +89,22 @@ SOURCE=..\OGLD\OGLDAltAzView.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=..\OGLD\OGLDBound.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\OGLD\OGLDBufferArena.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\OGLD\OGLDBuildThread.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\OGLD\OGLDCompactVertices.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=..\OGLD\OGLDCubeMap.cpp
 # End Source File
 # Begin Source File
@@ -101,10 +117,38 @@ SOURCE=..\OGLD\OGLDif.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=..\OGLD\OGLDFrustum.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\OGLD\OGLDHeightField.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\OGLD\OGLDHostData.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\OGLD\OGLDIndexArray.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\OGLD\OGLDInstanceBuffer.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=..\OGLD\OGLDMath.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=..\OGLD\OGLDMeshCache.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\OGLD\OGLDMipmap.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=..\OGLD\OGLDPixelBuffer.cpp
 # End Source File
 # Begin Source File
@@ -117,18 +161,46 @@ SOURCE=..\OGLD\OGLDPlane.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=..\OGLD\OGLDResample.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=..\OGLD\OGLDShape.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=..\OGLD\OGLDShapeCache.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\OGLD\OGLDShapeTuner.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=..\OGLD\OGLDSphere.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=..\OGLD\OGLDStaticBatch.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=..\OGLD\OGLDTexture.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=..\OGLD\OGLDTextureCache.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\OGLD\OGLDThread.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\OGLD\OGLDTiledHeightField.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=..\OGLD\OGLDTorus.cpp
 # End Source File
 # Begin Source File
@@ -137,6 +209,10 @@ SOURCE=..\OGLD\OGLDTrackballView.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=..\OGLD\OGLDVertexCache.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=..\OGLD\OGLDView.cpp
 # End Source File
 # End Group
@@ -149,6 +225,22 @@ SOURCE=..\OGLD\include\OGLDAltAzView.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\OGLD\include\OGLDBound.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\OGLD\include\OGLDBufferArena.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\OGLD\include\OGLDBuildThread.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\OGLD\include\OGLDCompactVertices.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\OGLD\include\OGLDCubeMap.h
 # End Source File
 # Begin Source File
@@ -161,10 +253,38 @@ SOURCE=..\OGLD\include\OGLDif.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\OGLD\include\OGLDFrustum.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\OGLD\include\OGLDHeightField.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\OGLD\include\OGLDHostData.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\OGLD\include\OGLDIndexArray.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\OGLD\include\OGLDInstanceBuffer.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\OGLD\include\OGLDMath.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\OGLD\include\OGLDMeshCache.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\OGLD\include\OGLDMipmap.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\OGLD\include\OGLDPixelBuffer.h
 # End Source File
 # Begin Source File
@@ -177,6 +297,10 @@ SOURCE=..\OGLD\include\OGLDPlane.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\OGLD\include\OGLDResample.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\OGLD\include\OGLDPlatformGL.h
 # End Source File
 # Begin Source File
@@ -193,14 +317,38 @@ SOURCE=..\OGLD\include\OGLDShape.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\OGLD\include\OGLDShapeCache.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\OGLD\include\OGLDShapeTuner.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\OGLD\include\OGLDSphere.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\OGLD\include\OGLDStaticBatch.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\OGLD\include\OGLDTexture.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\OGLD\include\OGLDTextureCache.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\OGLD\include\OGLDThread.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\OGLD\include\OGLDTiledHeightField.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\OGLD\include\OGLDTorus.h
 # End Source File
 # Begin Source File
@@ -209,6 +357,10 @@ SOURCE=..\OGLD\include\OGLDTrackballView.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\OGLD\include\OGLDVertexCache.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\OGLD\include\OGLDView.h
 # End Source File
 # End Group